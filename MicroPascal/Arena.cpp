@@ -0,0 +1,66 @@
+#include <algorithm>
+#include <cstdlib>
+
+#include "Arena.hpp"
+
+Arena::Arena(Arena&& other) noexcept
+	: chunks(std::move(other.chunks)), cursor(other.cursor), limit(other.limit), finalizers(std::move(other.finalizers)), used(other.used)
+{
+	other.chunks.clear();
+	other.finalizers.clear();
+	other.cursor = nullptr;
+	other.limit = nullptr;
+	other.used = 0;
+}
+
+Arena::~Arena()
+{
+	for (auto it = finalizers.rbegin(); it != finalizers.rend(); ++it)
+	{
+		it->destroy(it->object);
+	}
+	for (auto&& chunk : chunks)
+	{
+		std::free(chunk);
+	}
+}
+
+void Arena::Absorb(Arena&& other)
+{
+	// own chunk stays the current one, absorbed ones are only kept alive
+	chunks.insert(chunks.end(), other.chunks.begin(), other.chunks.end());
+	finalizers.insert(finalizers.end(), other.finalizers.begin(), other.finalizers.end());
+	used += other.used;
+
+	other.chunks.clear();
+	other.finalizers.clear();
+	other.cursor = nullptr;
+	other.limit = nullptr;
+	other.used = 0;
+}
+
+size_t Arena::Size() const
+{
+	return used;
+}
+
+// current chunk is full -> new one, big allocations get a chunk of their own
+void* Arena::AllocateChunk(size_t size, size_t alignment)
+{
+	size_t capacity = std::max(chunk_size, size + alignment);
+	char* chunk = static_cast<char*>(std::malloc(capacity));
+	if (chunk == nullptr)
+	{
+		throw std::bad_alloc();
+	}
+	chunks.push_back(chunk);
+
+	size_t padding = (alignment - reinterpret_cast<size_t>(chunk) % alignment) % alignment;
+	if (capacity - padding - size >= static_cast<size_t>(limit - cursor)) // keep whichever chunk has more room left
+	{
+		cursor = chunk + padding + size;
+		limit = chunk + capacity;
+	}
+	used += size;
+	return chunk + padding;
+}
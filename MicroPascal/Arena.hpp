@@ -0,0 +1,107 @@
+#ifndef ARENA_HPP
+#define ARENA_HPP
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// fixed size array that lives in an arena, does not own its items
+template<typename T>
+class Span
+{
+public:
+	Span() = default;
+	Span(T* m_items, size_t m_count) : items(m_items), count(m_count) {}
+
+	T* begin() const { return items; }
+	T* end() const { return items + count; }
+	T& operator[](size_t index) const { return items[index]; }
+	size_t size() const { return count; }
+	bool empty() const { return count == 0; }
+
+private:
+	T* items = nullptr;
+	size_t count = 0;
+};
+
+// bump pointer allocator, everything allocated in it gets freed at once by its destructor
+// -> objects with non trivial destructors get them called from there (in reverse order)
+class Arena
+{
+public:
+	Arena() = default;
+	Arena(Arena&& other) noexcept;
+	Arena(const Arena&) = delete;
+	Arena& operator=(const Arena&) = delete;
+	Arena& operator=(Arena&&) = delete;
+	~Arena();
+
+	template<typename T, typename... Args>
+	T* New(Args&&... args)
+	{
+		T* object = new (Allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+		if constexpr (!std::is_trivially_destructible_v<T>)
+		{
+			finalizers.push_back({ [](void* to_destroy) { static_cast<T*>(to_destroy)->~T(); }, object });
+		}
+		return object;
+	}
+
+	template<typename T>
+	Span<T> Copy(const T* items, size_t count)
+	{
+		static_assert(std::is_trivially_destructible_v<T>, "span items do not get destroyed");
+		if (count == 0)
+		{
+			return Span<T>();
+		}
+		T* copied = static_cast<T*>(Allocate(sizeof(T) * count, alignof(T)));
+		std::uninitialized_copy(items, items + count, copied);
+		return Span<T>(copied, count);
+	}
+
+	template<typename T>
+	Span<T> Copy(const std::vector<T>& items)
+	{
+		return Copy(items.data(), items.size());
+	}
+
+	void Absorb(Arena&& other); // takes over memory and objects of other arena (i.e. one filled by another thread)
+
+	size_t Size() const; // bytes handed out so far
+
+private:
+	void* Allocate(size_t size, size_t alignment)
+	{
+		size_t padding = (alignment - reinterpret_cast<size_t>(cursor) % alignment) % alignment;
+		if (cursor == nullptr || size + padding > static_cast<size_t>(limit - cursor))
+		{
+			return AllocateChunk(size, alignment);
+		}
+		void* allocated = cursor + padding;
+		cursor += padding + size;
+		used += size;
+		return allocated;
+	}
+
+	void* AllocateChunk(size_t size, size_t alignment);
+
+	struct Finalizer
+	{
+		void (*destroy)(void*);
+		void* object;
+	};
+
+	static constexpr size_t chunk_size = 256 * 1024;
+
+	std::vector<char*> chunks;
+	char* cursor = nullptr;
+	char* limit = nullptr;
+	std::vector<Finalizer> finalizers;
+	size_t used = 0;
+};
+
+#endif // !ARENA_HPP
@@ -0,0 +1,350 @@
+#include "CharScan.hpp"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define CHARSCAN_X86 1
+#include <immintrin.h>
+#endif
+
+static constexpr std::array<unsigned char, 256> MakeCharClass()
+{
+	std::array<unsigned char, 256> table{};
+	for (int c = 0; c < 256; c++)
+	{
+		unsigned char flags = 0;
+		if (c == ' ' || (c >= '\t' && c <= '\r')) // same set as std::isspace in "C" locale
+		{
+			flags |= 1;
+		}
+		if (c >= '0' && c <= '9')
+		{
+			flags |= 2;
+		}
+		if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_')
+		{
+			flags |= 4;
+		}
+		table[c] = flags;
+	}
+	return table;
+}
+
+const std::array<unsigned char, 256> CharScan::char_class = MakeCharClass();
+
+
+// scalar kernels, also used for tails shorter than one vector
+
+static size_t SkipWhitespaceScalar(const char* text, size_t pos, size_t size, int& newlines)
+{
+	while (pos < size && CharScan::IsSpace(text[pos]))
+	{
+		newlines += (text[pos] == '\n');
+		pos++;
+	}
+	return pos;
+}
+
+static size_t SkipIdentifierScalar(const char* text, size_t pos, size_t size)
+{
+	while (pos < size && CharScan::IsIdentChar(text[pos]))
+	{
+		pos++;
+	}
+	return pos;
+}
+
+static size_t FindBraceScalar(const char* text, size_t pos, size_t size, int& newlines)
+{
+	while (pos < size && text[pos] != '{' && text[pos] != '}')
+	{
+		newlines += (text[pos] == '\n');
+		pos++;
+	}
+	return pos;
+}
+
+static size_t FindQuoteOrNewlineScalar(const char* text, size_t pos, size_t size)
+{
+	while (pos < size && text[pos] != '\'' && text[pos] != '\n')
+	{
+		pos++;
+	}
+	return pos;
+}
+
+static size_t FindCommentOrStringScalar(const char* text, size_t pos, size_t size)
+{
+	while (pos < size && text[pos] != '{' && text[pos] != '\'')
+	{
+		pos++;
+	}
+	return pos;
+}
+
+
+#ifdef CHARSCAN_X86
+
+// SSE2 kernels -> 16 bytes per step, every x86-64 CPU has them
+
+static inline unsigned SpaceMask16(__m128i v)
+{
+	__m128i space = _mm_cmpeq_epi8(v, _mm_set1_epi8(' '));
+	__m128i control = _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8('\t' - 1)), _mm_cmplt_epi8(v, _mm_set1_epi8('\r' + 1)));
+	return static_cast<unsigned>(_mm_movemask_epi8(_mm_or_si128(space, control)));
+}
+
+static inline unsigned IdentMask16(__m128i v)
+{
+	__m128i lower = _mm_or_si128(v, _mm_set1_epi8(0x20)); // bytes >= 0x80 are negative -> never in range
+	__m128i alpha = _mm_and_si128(_mm_cmpgt_epi8(lower, _mm_set1_epi8('a' - 1)), _mm_cmplt_epi8(lower, _mm_set1_epi8('z' + 1)));
+	__m128i digit = _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8('0' - 1)), _mm_cmplt_epi8(v, _mm_set1_epi8('9' + 1)));
+	__m128i underscore = _mm_cmpeq_epi8(v, _mm_set1_epi8('_'));
+	return static_cast<unsigned>(_mm_movemask_epi8(_mm_or_si128(_mm_or_si128(alpha, digit), underscore)));
+}
+
+static inline unsigned ByteMask16(__m128i v, char c)
+{
+	return static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8(c))));
+}
+
+static size_t SkipWhitespaceSSE2(const char* text, size_t pos, size_t size, int& newlines)
+{
+	for (; pos + 16 <= size; pos += 16)
+	{
+		__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text + pos));
+		unsigned stop = ~SpaceMask16(v) & 0xFFFFu;
+		unsigned newline = ByteMask16(v, '\n');
+		if (stop != 0)
+		{
+			unsigned first = static_cast<unsigned>(__builtin_ctz(stop));
+			newlines += __builtin_popcount(newline & ((1u << first) - 1));
+			return pos + first;
+		}
+		newlines += __builtin_popcount(newline);
+	}
+	return SkipWhitespaceScalar(text, pos, size, newlines);
+}
+
+static size_t SkipIdentifierSSE2(const char* text, size_t pos, size_t size)
+{
+	for (; pos + 16 <= size; pos += 16)
+	{
+		unsigned stop = ~IdentMask16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(text + pos))) & 0xFFFFu;
+		if (stop != 0)
+		{
+			return pos + static_cast<unsigned>(__builtin_ctz(stop));
+		}
+	}
+	return SkipIdentifierScalar(text, pos, size);
+}
+
+static size_t FindBraceSSE2(const char* text, size_t pos, size_t size, int& newlines)
+{
+	for (; pos + 16 <= size; pos += 16)
+	{
+		__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text + pos));
+		unsigned stop = ByteMask16(v, '{') | ByteMask16(v, '}');
+		unsigned newline = ByteMask16(v, '\n');
+		if (stop != 0)
+		{
+			unsigned first = static_cast<unsigned>(__builtin_ctz(stop));
+			newlines += __builtin_popcount(newline & ((1u << first) - 1));
+			return pos + first;
+		}
+		newlines += __builtin_popcount(newline);
+	}
+	return FindBraceScalar(text, pos, size, newlines);
+}
+
+static size_t FindQuoteOrNewlineSSE2(const char* text, size_t pos, size_t size)
+{
+	for (; pos + 16 <= size; pos += 16)
+	{
+		__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text + pos));
+		unsigned stop = ByteMask16(v, '\'') | ByteMask16(v, '\n');
+		if (stop != 0)
+		{
+			return pos + static_cast<unsigned>(__builtin_ctz(stop));
+		}
+	}
+	return FindQuoteOrNewlineScalar(text, pos, size);
+}
+
+static size_t FindCommentOrStringSSE2(const char* text, size_t pos, size_t size)
+{
+	for (; pos + 16 <= size; pos += 16)
+	{
+		__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text + pos));
+		unsigned stop = ByteMask16(v, '{') | ByteMask16(v, '\'');
+		if (stop != 0)
+		{
+			return pos + static_cast<unsigned>(__builtin_ctz(stop));
+		}
+	}
+	return FindCommentOrStringScalar(text, pos, size);
+}
+
+
+// AVX2 kernels -> 32 bytes per step, compiled for AVX2 only here and used if the CPU reports it
+
+#define CHARSCAN_AVX2 __attribute__((target("avx2,popcnt,bmi")))
+
+CHARSCAN_AVX2 static inline unsigned SpaceMask32(__m256i v)
+{
+	__m256i space = _mm256_cmpeq_epi8(v, _mm256_set1_epi8(' '));
+	__m256i control = _mm256_and_si256(_mm256_cmpgt_epi8(v, _mm256_set1_epi8('\t' - 1)), _mm256_cmpgt_epi8(_mm256_set1_epi8('\r' + 1), v));
+	return static_cast<unsigned>(_mm256_movemask_epi8(_mm256_or_si256(space, control)));
+}
+
+CHARSCAN_AVX2 static inline unsigned IdentMask32(__m256i v)
+{
+	__m256i lower = _mm256_or_si256(v, _mm256_set1_epi8(0x20));
+	__m256i alpha = _mm256_and_si256(_mm256_cmpgt_epi8(lower, _mm256_set1_epi8('a' - 1)), _mm256_cmpgt_epi8(_mm256_set1_epi8('z' + 1), lower));
+	__m256i digit = _mm256_and_si256(_mm256_cmpgt_epi8(v, _mm256_set1_epi8('0' - 1)), _mm256_cmpgt_epi8(_mm256_set1_epi8('9' + 1), v));
+	__m256i underscore = _mm256_cmpeq_epi8(v, _mm256_set1_epi8('_'));
+	return static_cast<unsigned>(_mm256_movemask_epi8(_mm256_or_si256(_mm256_or_si256(alpha, digit), underscore)));
+}
+
+CHARSCAN_AVX2 static inline unsigned ByteMask32(__m256i v, char c)
+{
+	return static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(c))));
+}
+
+CHARSCAN_AVX2 static size_t SkipWhitespaceAVX2(const char* text, size_t pos, size_t size, int& newlines)
+{
+	for (; pos + 32 <= size; pos += 32)
+	{
+		__m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(text + pos));
+		unsigned stop = ~SpaceMask32(v);
+		unsigned newline = ByteMask32(v, '\n');
+		if (stop != 0)
+		{
+			unsigned first = static_cast<unsigned>(__builtin_ctz(stop));
+			newlines += __builtin_popcount(newline & ((1u << first) - 1));
+			return pos + first;
+		}
+		newlines += __builtin_popcount(newline);
+	}
+	return SkipWhitespaceSSE2(text, pos, size, newlines);
+}
+
+CHARSCAN_AVX2 static size_t SkipIdentifierAVX2(const char* text, size_t pos, size_t size)
+{
+	for (; pos + 32 <= size; pos += 32)
+	{
+		unsigned stop = ~IdentMask32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(text + pos)));
+		if (stop != 0)
+		{
+			return pos + static_cast<unsigned>(__builtin_ctz(stop));
+		}
+	}
+	return SkipIdentifierSSE2(text, pos, size);
+}
+
+CHARSCAN_AVX2 static size_t FindBraceAVX2(const char* text, size_t pos, size_t size, int& newlines)
+{
+	for (; pos + 32 <= size; pos += 32)
+	{
+		__m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(text + pos));
+		unsigned stop = ByteMask32(v, '{') | ByteMask32(v, '}');
+		unsigned newline = ByteMask32(v, '\n');
+		if (stop != 0)
+		{
+			unsigned first = static_cast<unsigned>(__builtin_ctz(stop));
+			newlines += __builtin_popcount(newline & ((1u << first) - 1));
+			return pos + first;
+		}
+		newlines += __builtin_popcount(newline);
+	}
+	return FindBraceSSE2(text, pos, size, newlines);
+}
+
+CHARSCAN_AVX2 static size_t FindQuoteOrNewlineAVX2(const char* text, size_t pos, size_t size)
+{
+	for (; pos + 32 <= size; pos += 32)
+	{
+		__m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(text + pos));
+		unsigned stop = ByteMask32(v, '\'') | ByteMask32(v, '\n');
+		if (stop != 0)
+		{
+			return pos + static_cast<unsigned>(__builtin_ctz(stop));
+		}
+	}
+	return FindQuoteOrNewlineSSE2(text, pos, size);
+}
+
+CHARSCAN_AVX2 static size_t FindCommentOrStringAVX2(const char* text, size_t pos, size_t size)
+{
+	for (; pos + 32 <= size; pos += 32)
+	{
+		__m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(text + pos));
+		unsigned stop = ByteMask32(v, '{') | ByteMask32(v, '\'');
+		if (stop != 0)
+		{
+			return pos + static_cast<unsigned>(__builtin_ctz(stop));
+		}
+	}
+	return FindCommentOrStringSSE2(text, pos, size);
+}
+
+#endif // CHARSCAN_X86
+
+
+// kernels are picked once at startup according to the CPU
+struct ScanKernels
+{
+	size_t (*skip_whitespace)(const char*, size_t, size_t, int&);
+	size_t (*skip_identifier)(const char*, size_t, size_t);
+	size_t (*find_brace)(const char*, size_t, size_t, int&);
+	size_t (*find_quote_or_newline)(const char*, size_t, size_t);
+	size_t (*find_comment_or_string)(const char*, size_t, size_t);
+	const char* name;
+};
+
+static ScanKernels SelectKernels()
+{
+#ifdef CHARSCAN_X86
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2"))
+	{
+		return { SkipWhitespaceAVX2, SkipIdentifierAVX2, FindBraceAVX2, FindQuoteOrNewlineAVX2, FindCommentOrStringAVX2, "avx2" };
+	}
+	if (__builtin_cpu_supports("sse2"))
+	{
+		return { SkipWhitespaceSSE2, SkipIdentifierSSE2, FindBraceSSE2, FindQuoteOrNewlineSSE2, FindCommentOrStringSSE2, "sse2" };
+	}
+#endif
+	return { SkipWhitespaceScalar, SkipIdentifierScalar, FindBraceScalar, FindQuoteOrNewlineScalar, FindCommentOrStringScalar, "scalar" };
+}
+
+static const ScanKernels kernels = SelectKernels();
+
+
+size_t CharScan::SkipWhitespace(std::string_view text, size_t pos, int& newlines)
+{
+	return kernels.skip_whitespace(text.data(), pos, text.size(), newlines);
+}
+
+size_t CharScan::SkipIdentifier(std::string_view text, size_t pos)
+{
+	return kernels.skip_identifier(text.data(), pos, text.size());
+}
+
+size_t CharScan::FindBrace(std::string_view text, size_t pos, int& newlines)
+{
+	return kernels.find_brace(text.data(), pos, text.size(), newlines);
+}
+
+size_t CharScan::FindQuoteOrNewline(std::string_view text, size_t pos)
+{
+	return kernels.find_quote_or_newline(text.data(), pos, text.size());
+}
+
+size_t CharScan::FindCommentOrString(std::string_view text, size_t pos)
+{
+	return kernels.find_comment_or_string(text.data(), pos, text.size());
+}
+
+const char* CharScan::Implementation()
+{
+	return kernels.name;
+}
@@ -0,0 +1,38 @@
+#ifndef CHARSCAN_HPP
+#define CHARSCAN_HPP
+
+#include <array>
+#include <cstddef>
+#include <string_view>
+
+// ASCII character classes (no locale) and bulk scanning kernels for the lexer,
+// SSE2/AVX2 versions get picked at runtime, scalar ones are the fallback
+class CharScan
+{
+public:
+	static bool IsSpace(char c) { return (char_class[static_cast<unsigned char>(c)] & SPACE) != 0; }
+	static bool IsDigit(char c) { return (char_class[static_cast<unsigned char>(c)] & DIGIT) != 0; }
+	static bool IsIdentStart(char c) { return (char_class[static_cast<unsigned char>(c)] & IDENT_START) != 0; }
+	static bool IsIdentChar(char c) { return (char_class[static_cast<unsigned char>(c)] & (IDENT_START | DIGIT)) != 0; }
+
+	// all return position of the first char that stops the scan (text.size() if there is none)
+	static size_t SkipWhitespace(std::string_view text, size_t pos, int& newlines); // newlines skipped get added
+	static size_t SkipIdentifier(std::string_view text, size_t pos);
+	static size_t FindBrace(std::string_view text, size_t pos, int& newlines); // '{' or '}', newlines before it get added
+	static size_t FindQuoteOrNewline(std::string_view text, size_t pos);
+	static size_t FindCommentOrString(std::string_view text, size_t pos); // '{' or '\''
+
+	static const char* Implementation(); // name of kernels in use
+
+private:
+	enum : unsigned char
+	{
+		SPACE = 1,
+		DIGIT = 2,
+		IDENT_START = 4
+	};
+
+	static const std::array<unsigned char, 256> char_class;
+};
+
+#endif // !CHARSCAN_HPP
@@ -0,0 +1,327 @@
+#include <algorithm>
+#include <climits>
+#include <variant>
+
+#include "ConstantFolder.hpp"
+
+ConstantFolder::ConstantFolder(Arena& m_arena) : arena(m_arena) {}
+
+void ConstantFolder::Fold(Stmt* program)
+{
+	for (int walk = 0; walk < max_walks; walk++)
+	{
+		variables.clear();
+		scopes.clear();
+		program->Accept(*this);
+
+		// replaced reads are literals now -> another walk only if some are left
+		bool propagable = false;
+		for (auto&& [routine, scope] : variables)
+		{
+			propagable = propagable || std::any_of(scope.begin(), scope.end(), Propagable);
+		}
+		if (!propagable)
+		{
+			break;
+		}
+		known.swap(variables);
+	}
+}
+
+void ConstantFolder::Simplify(Expr*& expr)
+{
+	folded_expr = nullptr;
+	expr->Accept(*this);
+	if (folded_expr != nullptr)
+	{
+		expr = folded_expr;
+		folded_expr = nullptr;
+	}
+}
+
+void ConstantFolder::Simplify(Stmt*& stmt)
+{
+	folded_stmt = nullptr;
+	stmt->Accept(*this);
+	if (folded_stmt != nullptr)
+	{
+		stmt = folded_stmt;
+		folded_stmt = nullptr;
+	}
+}
+
+void ConstantFolder::FoldRoutine(const Routine* routine, size_t slot_count, Span<Stmt*> decl_stmts, Stmt* body)
+{
+	std::vector<Variable>& own = variables[routine]; // nodes of the map stay put while nested routines get added
+	own.assign(slot_count, Variable());
+	auto previous = known.find(routine);
+
+	// nested routines first, they only see what the previous walk found out about this one
+	scopes.push_back({ &own, previous != known.end() ? &previous->second : nullptr, body });
+	for (auto&& decl : decl_stmts)
+	{
+		decl->Accept(*this);
+	}
+	body->Accept(*this); // compound statement -> never replaced, the routine keeps pointing to it
+	scopes.pop_back();
+}
+
+ConstantFolder::Variable& ConstantFolder::Written(Address address)
+{
+	Variable& variable = (*scopes[scopes.size() - 1 - address.depth].variables)[address.slot];
+	variable.writes++;
+	return variable;
+}
+
+bool ConstantFolder::Propagable(const Variable& variable)
+{
+	return variable.writes == 1 && variable.value.has_value() && (variable.read_nested || variable.last_read > variable.position + 1);
+}
+
+Expr* ConstantFolder::MakeLiteral(Literal value, VariableType type)
+{
+	auto* literal = arena.New<LiteralExpr>(std::move(value));
+	literal->type = type;
+	return literal;
+}
+
+bool ConstantFolder::Foldable(TokenType op, const Literal& left, const Literal& right)
+{
+	const int* a = std::get_if<int>(&left);
+	const int* b = std::get_if<int>(&right);
+	if (a == nullptr || b == nullptr)
+	{
+		return true;
+	}
+
+	// in 64 bits -> results of 32-bit operands cannot overflow there
+	switch (op)
+	{
+	case TokenType::PLUS:
+		return static_cast<int64_t>(*a) + *b >= INT_MIN && static_cast<int64_t>(*a) + *b <= INT_MAX;
+	case TokenType::MINUS:
+		return static_cast<int64_t>(*a) - *b >= INT_MIN && static_cast<int64_t>(*a) - *b <= INT_MAX;
+	case TokenType::MUL:
+		return static_cast<int64_t>(*a) * *b >= INT_MIN && static_cast<int64_t>(*a) * *b <= INT_MAX;
+	case TokenType::DIV:
+		return *b != 0 && !(*a == INT_MIN && *b == -1);
+	default:
+		return true;
+	}
+}
+
+
+Literal ConstantFolder::Visit(BinaryExpr& binExpr)
+{
+	Simplify(binExpr.left);
+	Simplify(binExpr.right);
+
+	auto* left = dynamic_cast<LiteralExpr*>(binExpr.left);
+	auto* right = dynamic_cast<LiteralExpr*>(binExpr.right);
+	if (left != nullptr && right != nullptr && Foldable(binExpr.op, left->value, right->value))
+	{
+		folded_expr = MakeLiteral(evaluator.Evaluate(&binExpr), binExpr.type);
+	}
+	return nullptr;
+}
+
+Literal ConstantFolder::Visit(UnaryExpr& unExpr)
+{
+	Simplify(unExpr.right);
+
+	auto* right = dynamic_cast<LiteralExpr*>(unExpr.right);
+	if (right != nullptr && !(unExpr.op == TokenType::MINUS && std::get<int>(right->value) == INT_MIN)) // negation overflows
+	{
+		folded_expr = MakeLiteral(evaluator.Evaluate(&unExpr), unExpr.type);
+	}
+	return nullptr;
+}
+
+Literal ConstantFolder::Visit([[maybe_unused]] LiteralExpr& litExpr)
+{
+	return nullptr;
+}
+
+Literal ConstantFolder::Visit(GroupingExpr& grExpr)
+{
+	// parentheses only mattered to the parser
+	Simplify(grExpr.expr);
+	folded_expr = grExpr.expr;
+	return nullptr;
+}
+
+Literal ConstantFolder::Visit(VariableExpr& varExpr)
+{
+	// function without parameters
+	if (varExpr.callee != nullptr)
+	{
+		scopes.back().called = true;
+		return nullptr;
+	}
+
+	// value the variable is known to have -> in nested routines (called only after it got assigned)
+	// or in later top level statements of its own body
+	const Scope& owner = scopes[scopes.size() - 1 - varExpr.address.depth];
+	if (owner.known != nullptr)
+	{
+		const Variable& variable = (*owner.known)[varExpr.address.slot];
+		if (variable.writes == 1 && variable.value.has_value() &&
+			(varExpr.address.depth > 0 || owner.position > variable.position))
+		{
+			folded_expr = MakeLiteral(*variable.value, varExpr.type);
+			return nullptr;
+		}
+	}
+
+	Variable& variable = (*owner.variables)[varExpr.address.slot];
+	if (varExpr.address.depth > 0)
+	{
+		variable.read_nested = true;
+	}
+	else
+	{
+		variable.last_read = owner.position + 1;
+	}
+	return nullptr;
+}
+
+Literal ConstantFolder::Visit(FunctionCallExpr& funcCallExpr)
+{
+	for (auto&& expr : funcCallExpr.exprs)
+	{
+		Simplify(expr);
+	}
+	scopes.back().called = true;
+	return nullptr;
+}
+
+Literal ConstantFolder::Visit(InlinedCallExpr& inlinedCallExpr)
+{
+	Visit(*inlinedCallExpr.call);
+	return nullptr;
+}
+
+void ConstantFolder::Visit(ProgramStmt& programStmt)
+{
+	FoldRoutine(nullptr, programStmt.slots.size(), programStmt.decl_stmts, programStmt.stmt);
+}
+
+void ConstantFolder::Visit(CompoundStmt& compoundStmt)
+{
+	bool top = &compoundStmt == scopes.back().body;
+	for (size_t i = 0; i < compoundStmt.statements.size(); i++)
+	{
+		if (top)
+		{
+			scopes.back().statement = compoundStmt.statements[i];
+			scopes.back().position = i;
+		}
+		Simplify(compoundStmt.statements[i]);
+	}
+}
+
+void ConstantFolder::Visit(WritelnStmt& writelnStmt)
+{
+	for (auto&& expr : writelnStmt.exprs)
+	{
+		Simplify(expr);
+	}
+}
+
+void ConstantFolder::Visit([[maybe_unused]] EmptyStmt& emptyStmt) {}
+
+void ConstantFolder::Visit([[maybe_unused]] VarDeclStmt& varDeclStmt) {}
+
+void ConstantFolder::Visit(FuncDeclStmt& funcDeclStmt)
+{
+	FoldRoutine(funcDeclStmt.routine, funcDeclStmt.routine->slots.size(), funcDeclStmt.decl_stmts, funcDeclStmt.body);
+}
+
+void ConstantFolder::Visit(ProcDeclStmt& procDeclStmt)
+{
+	FoldRoutine(procDeclStmt.routine, procDeclStmt.routine->slots.size(), procDeclStmt.decl_stmts, procDeclStmt.body);
+}
+
+void ConstantFolder::Visit(AssignmentStmt& assignmentStmt)
+{
+	Simplify(assignmentStmt.value);
+
+	// only a top level statement of the variable's own body that runs before any call sets it for good,
+	// a second write anywhere -> not constant
+	Variable& variable = Written(assignmentStmt.address);
+	const Scope& scope = scopes.back();
+	auto* literal = dynamic_cast<LiteralExpr*>(assignmentStmt.value);
+	if (literal != nullptr && assignmentStmt.address.depth == 0 && scope.statement == &assignmentStmt && !scope.called)
+	{
+		variable.value = literal->value;
+		variable.position = scope.position;
+	}
+}
+
+void ConstantFolder::Visit(IfStmt& ifStmt)
+{
+	Simplify(ifStmt.condition);
+
+	// dead branch is not walked -> its writes and calls do not count
+	if (auto* literal = dynamic_cast<LiteralExpr*>(ifStmt.condition))
+	{
+		Stmt*& taken = std::get<bool>(literal->value) ? ifStmt.then_branch : ifStmt.else_branch;
+		if (taken != nullptr)
+		{
+			Simplify(taken);
+		}
+		folded_stmt = taken != nullptr ? taken : arena.New<EmptyStmt>();
+		return;
+	}
+
+	Simplify(ifStmt.then_branch);
+	if (ifStmt.else_branch != nullptr)
+	{
+		Simplify(ifStmt.else_branch);
+	}
+}
+
+void ConstantFolder::Visit(WhileStmt& whileStmt)
+{
+	Simplify(whileStmt.condition);
+
+	auto* literal = dynamic_cast<LiteralExpr*>(whileStmt.condition);
+	if (literal != nullptr && !std::get<bool>(literal->value))
+	{
+		folded_stmt = arena.New<EmptyStmt>();
+		return;
+	}
+	Simplify(whileStmt.body);
+}
+
+void ConstantFolder::Visit(ForStmt& forStmt)
+{
+	Simplify(forStmt.assignment);
+	Simplify(forStmt.expression);
+	Written(forStmt.address); // counter changes every iteration
+	Simplify(forStmt.body);
+}
+
+void ConstantFolder::Visit(ProcedureCallStmt& procedureCallStmt)
+{
+	for (auto&& expr : procedureCallStmt.arguments)
+	{
+		Simplify(expr);
+	}
+	scopes.back().called = true;
+}
+
+void ConstantFolder::Visit(InlinedCallStmt& inlinedCallStmt)
+{
+	for (auto&& expr : inlinedCallStmt.arguments)
+	{
+		Simplify(expr);
+	}
+
+	// copied body runs on slots of the current scope, which get set on every call
+	for (uint32_t i = 0; i < inlinedCallStmt.slots.size(); i++)
+	{
+		Written({ 0, inlinedCallStmt.base + i });
+	}
+	Simplify(inlinedCallStmt.body);
+}
@@ -0,0 +1,90 @@
+#ifndef CONSTANTFOLDER_HPP
+#define CONSTANTFOLDER_HPP
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Arena.hpp"
+#include "Expr.hpp"
+#include "Stmt.hpp"
+#include "Interpreter.hpp"
+
+// optimization pass over a resolved program -> literal subtrees become literals, variables that get one constant
+// assigned get it propagated to their reads, if and while with constant conditions lose the dead branch;
+// whatever could fail at runtime (i.e. division by zero, overflow) is left to fail there, on its line
+class ConstantFolder : public VisitorExpr, public VisitorStmt
+{
+public:
+	ConstantFolder(Arena& m_arena);
+
+	void Fold(Stmt* program);
+
+private:
+	Literal Visit(BinaryExpr& binExpr) override;
+	Literal Visit(UnaryExpr& unExpr) override;
+	Literal Visit(LiteralExpr& litExpr) override;
+	Literal Visit(GroupingExpr& grExpr) override;
+	Literal Visit(VariableExpr& varExpr) override;
+	Literal Visit(FunctionCallExpr& funcCallExpr) override;
+	Literal Visit(InlinedCallExpr& inlinedCallExpr) override;
+
+	void Visit(ProgramStmt& programStmt) override;
+	void Visit(CompoundStmt& compoundStmt) override;
+	void Visit(WritelnStmt& writelnStmt) override;
+	void Visit([[maybe_unused]] EmptyStmt& emptyStmt) override;
+	void Visit([[maybe_unused]] VarDeclStmt& varDeclStmt) override;
+	void Visit(FuncDeclStmt& funcDeclStmt) override;
+	void Visit(AssignmentStmt& assignmentStmt) override;
+	void Visit(IfStmt& ifStmt) override;
+	void Visit(WhileStmt& whileStmt) override;
+	void Visit(ForStmt& forStmt) override;
+	void Visit(ProcDeclStmt& procDeclStmt) override;
+	void Visit(ProcedureCallStmt& procedureCallStmt) override;
+	void Visit(InlinedCallStmt& inlinedCallStmt) override;
+
+	// what one walk found out about a variable
+	struct Variable
+	{
+		uint32_t writes = 0;
+		std::optional<Literal> value; // assigned by a top level statement of the body of its scope, before any call
+		size_t position = 0; // of that statement -> reads after it see the value
+		size_t last_read = 0; // top level statement of its own body that read it last, plus 1 (0 -> none)
+		bool read_nested = false; // in a nested routine
+	};
+
+	// routine (or program) being walked
+	struct Scope
+	{
+		std::vector<Variable>* variables; // of this walk
+		const std::vector<Variable>* known; // of the previous walk, to propagate
+		Stmt* body;
+		Stmt* statement = nullptr; // top level statement of body being walked
+		size_t position = 0; // its index
+		bool called = false; // by a statement of body so far
+	};
+
+	void Simplify(Expr*& expr); // folds expr, replaces it by what it folded to
+	void Simplify(Stmt*& stmt);
+	void FoldRoutine(const Routine* routine, size_t slot_count, Span<Stmt*> decl_stmts, Stmt* body);
+	Variable& Written(Address address);
+	Expr* MakeLiteral(Literal value, VariableType type);
+
+	static bool Foldable(TokenType op, const Literal& left, const Literal& right); // false -> would fail or overflow at runtime
+
+	static bool Propagable(const Variable& variable); // constant with reads a next walk could replace
+
+	static constexpr int max_walks = 4; // each one propagates what the previous one found
+
+	Arena& arena; // new literals go in here
+	Interpreter evaluator; // folds with the semantics of a run
+	std::unordered_map<const Routine*, std::vector<Variable>> variables; // by scope, program is nullptr
+	std::unordered_map<const Routine*, std::vector<Variable>> known;
+	std::vector<Scope> scopes; // lexically enclosing ones, innermost last
+	Expr* folded_expr = nullptr; // replacement of the node just visited
+	Stmt* folded_stmt = nullptr;
+};
+
+#endif // !CONSTANTFOLDER_HPP
@@ -0,0 +1,495 @@
+#include <algorithm>
+#include <variant>
+
+#include "DeadCodeEliminator.hpp"
+
+DeadCodeEliminator::DeadCodeEliminator(Arena& m_arena) : arena(m_arena) {}
+
+void DeadCodeEliminator::Eliminate(Stmt* program)
+{
+	scopes.clear();
+	roots.clear();
+	uses.clear();
+
+	phase = Phase::COLLECT;
+	program->Accept(*this);
+
+	// routines the program's body leads to, each one walked once
+	phase = Phase::MARK;
+	Reach(nullptr);
+	while (!pending.empty())
+	{
+		const Routine* routine = pending.back();
+		pending.pop_back();
+		Scope& scope = scopes.at(routine);
+
+		chain.clear();
+		for (const Routine* outer = routine; outer != nullptr; outer = scopes.at(outer).parent)
+		{
+			chain.push_back(outer);
+		}
+		chain.push_back(nullptr);
+		std::reverse(chain.begin(), chain.end());
+
+		for (uint32_t slot = 0; slot < scope.locals; slot++)
+		{
+			roots.push_back({ routine, slot });
+		}
+		scope.body->Accept(*this);
+	}
+	chain.clear();
+
+	Propagate();
+	for (auto&& [routine, scope] : scopes)
+	{
+		if (scope.reachable)
+		{
+			Renumber(scope);
+		}
+	}
+
+	phase = Phase::SWEEP;
+	Sweep(nullptr, program_stmt->decl_stmts, program_stmt->stmt);
+}
+
+void DeadCodeEliminator::Collect(const Routine* routine, Span<VariableType>* slots, Span<Stmt*> decl_stmts, Stmt* body, uint32_t locals)
+{
+	Scope& scope = scopes[routine];
+	scope.parent = current;
+	scope.slots = slots;
+	scope.body = body;
+	scope.locals = locals;
+	scope.live.assign(slots->size(), false);
+
+	const Routine* outer = current;
+	current = routine;
+	for (auto&& decl : decl_stmts)
+	{
+		decl->Accept(*this);
+	}
+	current = outer;
+}
+
+void DeadCodeEliminator::Reach(const Routine* routine)
+{
+	Scope& scope = scopes.at(routine);
+	if (!scope.reachable)
+	{
+		scope.reachable = true;
+		pending.push_back(routine);
+	}
+}
+
+// assignments that cannot fail are only worth running when their target gets read
+void DeadCodeEliminator::Read(Address address)
+{
+	if (assigned != nullptr)
+	{
+		uses.push_back({ *assigned, SideEffects::Of(chain, address) });
+	}
+	else
+	{
+		roots.push_back(SideEffects::Of(chain, address));
+	}
+}
+
+void DeadCodeEliminator::Propagate()
+{
+	std::sort(uses.begin(), uses.end());
+	while (!roots.empty())
+	{
+		SideEffects::Variable variable = roots.back();
+		roots.pop_back();
+		std::vector<bool>::reference live = scopes.at(variable.first).live[variable.second];
+		if (live)
+		{
+			continue;
+		}
+		live = true;
+
+		auto first = std::lower_bound(uses.begin(), uses.end(), variable,
+			[](const auto& use, const SideEffects::Variable& key) { return use.first < key; });
+		for (auto use = first; use != uses.end() && use->first == variable; ++use)
+		{
+			roots.push_back(use->second);
+		}
+	}
+}
+
+void DeadCodeEliminator::Renumber(Scope& scope)
+{
+	std::vector<VariableType> kept;
+	scope.moved.resize(scope.live.size());
+	for (uint32_t slot = 0; slot < scope.live.size(); slot++)
+	{
+		if (scope.live[slot])
+		{
+			scope.moved[slot] = static_cast<uint32_t>(kept.size());
+			kept.push_back((*scope.slots)[slot]);
+		}
+	}
+	if (kept.size() < scope.slots->size())
+	{
+		*scope.slots = arena.Copy(kept);
+	}
+}
+
+void DeadCodeEliminator::Sweep(const Routine* routine, Span<Stmt*>& decl_stmts, Stmt* body)
+{
+	chain.push_back(routine);
+
+	std::vector<Stmt*> kept;
+	for (auto&& decl : decl_stmts)
+	{
+		dropped = false;
+		decl->Accept(*this);
+		if (!dropped)
+		{
+			kept.push_back(decl);
+		}
+	}
+	if (kept.size() < decl_stmts.size())
+	{
+		decl_stmts = arena.Copy(kept);
+	}
+	dropped = false; // routine itself stays in the declarations of the enclosing one
+
+	body->Accept(*this); // compound statement -> never replaced, the routine keeps pointing to it
+	chain.pop_back();
+}
+
+void DeadCodeEliminator::Rewrite(Stmt*& stmt)
+{
+	replaced_stmt = nullptr;
+	stmt->Accept(*this);
+	if (replaced_stmt != nullptr)
+	{
+		stmt = replaced_stmt;
+		replaced_stmt = nullptr;
+	}
+}
+
+bool DeadCodeEliminator::Live(Address address) const
+{
+	return scopes.at(chain[chain.size() - 1 - address.depth]).live[address.slot];
+}
+
+Address DeadCodeEliminator::Moved(Address address) const
+{
+	return { address.depth, scopes.at(chain[chain.size() - 1 - address.depth]).moved[address.slot] };
+}
+
+bool DeadCodeEliminator::Pure(Expr* expr)
+{
+	if (dynamic_cast<LiteralExpr*>(expr) != nullptr)
+	{
+		return true;
+	}
+	if (auto* variable = dynamic_cast<VariableExpr*>(expr))
+	{
+		return variable->callee == nullptr;
+	}
+	if (auto* grouping = dynamic_cast<GroupingExpr*>(expr))
+	{
+		return Pure(grouping->expr);
+	}
+	if (auto* unary = dynamic_cast<UnaryExpr*>(expr))
+	{
+		return Pure(unary->right);
+	}
+	if (auto* binary = dynamic_cast<BinaryExpr*>(expr))
+	{
+		if (binary->op == TokenType::DIV)
+		{
+			auto* divisor = dynamic_cast<LiteralExpr*>(binary->right);
+			if (divisor == nullptr || std::get<int>(divisor->value) == 0 || std::get<int>(divisor->value) == -1)
+			{
+				return false;
+			}
+		}
+		return Pure(binary->left) && Pure(binary->right);
+	}
+	return false; // call
+}
+
+bool DeadCodeEliminator::Endless(Stmt* stmt)
+{
+	auto* loop = dynamic_cast<WhileStmt*>(stmt);
+	if (loop == nullptr)
+	{
+		return false;
+	}
+	auto* condition = dynamic_cast<LiteralExpr*>(loop->condition);
+	return condition != nullptr && std::get<bool>(condition->value);
+}
+
+
+Literal DeadCodeEliminator::Visit(BinaryExpr& binExpr)
+{
+	binExpr.left->Accept(*this);
+	binExpr.right->Accept(*this);
+	return nullptr;
+}
+
+Literal DeadCodeEliminator::Visit(UnaryExpr& unExpr)
+{
+	unExpr.right->Accept(*this);
+	return nullptr;
+}
+
+Literal DeadCodeEliminator::Visit([[maybe_unused]] LiteralExpr& litExpr)
+{
+	return nullptr;
+}
+
+Literal DeadCodeEliminator::Visit(GroupingExpr& grExpr)
+{
+	grExpr.expr->Accept(*this);
+	return nullptr;
+}
+
+Literal DeadCodeEliminator::Visit(VariableExpr& varExpr)
+{
+	if (varExpr.callee != nullptr) // function without parameters
+	{
+		if (phase == Phase::MARK)
+		{
+			Reach(varExpr.callee);
+		}
+		return nullptr;
+	}
+
+	if (phase == Phase::MARK)
+	{
+		Read(varExpr.address);
+	}
+	else
+	{
+		varExpr.address = Moved(varExpr.address);
+	}
+	return nullptr;
+}
+
+Literal DeadCodeEliminator::Visit(FunctionCallExpr& funcCallExpr)
+{
+	for (auto&& expr : funcCallExpr.exprs)
+	{
+		expr->Accept(*this);
+	}
+	if (phase == Phase::MARK)
+	{
+		Reach(funcCallExpr.callee);
+	}
+	return nullptr;
+}
+
+Literal DeadCodeEliminator::Visit(InlinedCallExpr& inlinedCallExpr)
+{
+	Visit(*inlinedCallExpr.call);
+	if (phase == Phase::SWEEP)
+	{
+		inlinedCallExpr.result = Moved({ 0, inlinedCallExpr.result }).slot;
+	}
+	return nullptr;
+}
+
+void DeadCodeEliminator::Visit(ProgramStmt& programStmt)
+{
+	program_stmt = &programStmt;
+	Collect(nullptr, &programStmt.slots, programStmt.decl_stmts, programStmt.stmt, 0);
+}
+
+// statements that do nothing go away, as do those after a loop that only an error leaves
+void DeadCodeEliminator::Visit(CompoundStmt& compoundStmt)
+{
+	std::vector<Stmt*> kept;
+	kept.reserve(compoundStmt.statements.size());
+	for (auto&& stmt : compoundStmt.statements)
+	{
+		Rewrite(stmt);
+		if (dynamic_cast<EmptyStmt*>(stmt) == nullptr)
+		{
+			kept.push_back(stmt);
+		}
+		if (Endless(stmt))
+		{
+			break;
+		}
+	}
+	if (kept.size() < compoundStmt.statements.size())
+	{
+		compoundStmt.statements = arena.Copy(kept);
+	}
+}
+
+void DeadCodeEliminator::Visit(WritelnStmt& writelnStmt)
+{
+	for (auto&& expr : writelnStmt.exprs)
+	{
+		expr->Accept(*this);
+	}
+}
+
+void DeadCodeEliminator::Visit([[maybe_unused]] EmptyStmt& emptyStmt) {}
+
+void DeadCodeEliminator::Visit([[maybe_unused]] VarDeclStmt& varDeclStmt) {}
+
+void DeadCodeEliminator::Visit(FuncDeclStmt& funcDeclStmt)
+{
+	Routine* routine = funcDeclStmt.routine;
+	if (phase == Phase::COLLECT)
+	{
+		Collect(routine, &routine->slots, funcDeclStmt.decl_stmts, funcDeclStmt.body, routine->parameter_count + 1);
+	}
+	else if (!scopes.at(routine).reachable)
+	{
+		dropped = true;
+	}
+	else
+	{
+		Sweep(routine, funcDeclStmt.decl_stmts, funcDeclStmt.body);
+	}
+}
+
+void DeadCodeEliminator::Visit(ProcDeclStmt& procDeclStmt)
+{
+	Routine* routine = procDeclStmt.routine;
+	if (phase == Phase::COLLECT)
+	{
+		Collect(routine, &routine->slots, procDeclStmt.decl_stmts, procDeclStmt.body, routine->parameter_count);
+	}
+	else if (!scopes.at(routine).reachable)
+	{
+		dropped = true;
+	}
+	else
+	{
+		Sweep(routine, procDeclStmt.decl_stmts, procDeclStmt.body);
+	}
+}
+
+void DeadCodeEliminator::Visit(AssignmentStmt& assignmentStmt)
+{
+	if (phase == Phase::MARK)
+	{
+		SideEffects::Variable target = SideEffects::Of(chain, assignmentStmt.address);
+		if (Pure(assignmentStmt.value))
+		{
+			assigned = &target;
+		}
+		else
+		{
+			roots.push_back(target);
+		}
+		assignmentStmt.value->Accept(*this);
+		assigned = nullptr;
+		return;
+	}
+
+	if (!Live(assignmentStmt.address))
+	{
+		replaced_stmt = arena.New<EmptyStmt>();
+		return;
+	}
+	assignmentStmt.address = Moved(assignmentStmt.address);
+	assignmentStmt.value->Accept(*this);
+}
+
+void DeadCodeEliminator::Visit(IfStmt& ifStmt)
+{
+	ifStmt.condition->Accept(*this);
+
+	if (auto* literal = dynamic_cast<LiteralExpr*>(ifStmt.condition))
+	{
+		Stmt*& taken = std::get<bool>(literal->value) ? ifStmt.then_branch : ifStmt.else_branch;
+		if (taken != nullptr)
+		{
+			Rewrite(taken);
+		}
+		replaced_stmt = taken != nullptr ? taken : arena.New<EmptyStmt>();
+		return;
+	}
+
+	Rewrite(ifStmt.then_branch);
+	if (ifStmt.else_branch != nullptr)
+	{
+		Rewrite(ifStmt.else_branch);
+	}
+}
+
+void DeadCodeEliminator::Visit(WhileStmt& whileStmt)
+{
+	auto* literal = dynamic_cast<LiteralExpr*>(whileStmt.condition);
+	if (literal != nullptr && !std::get<bool>(literal->value))
+	{
+		replaced_stmt = arena.New<EmptyStmt>();
+		return;
+	}
+	whileStmt.condition->Accept(*this);
+	Rewrite(whileStmt.body);
+}
+
+void DeadCodeEliminator::Visit(ForStmt& forStmt)
+{
+	forStmt.expression->Accept(*this);
+	Rewrite(forStmt.assignment);
+
+	// bounds known to be the wrong way around -> only the counter gets its initial value
+	auto* assignment = dynamic_cast<AssignmentStmt*>(forStmt.assignment);
+	auto* first = assignment != nullptr ? dynamic_cast<LiteralExpr*>(assignment->value) : nullptr;
+	auto* limit = dynamic_cast<LiteralExpr*>(forStmt.expression);
+	if (first != nullptr && limit != nullptr
+		&& (forStmt.increment ? std::get<int>(first->value) > std::get<int>(limit->value) : std::get<int>(first->value) < std::get<int>(limit->value)))
+	{
+		replaced_stmt = forStmt.assignment;
+		return;
+	}
+
+	if (phase == Phase::MARK)
+	{
+		roots.push_back(SideEffects::Of(chain, forStmt.address));
+	}
+	else
+	{
+		forStmt.address = Moved(forStmt.address);
+	}
+	Rewrite(forStmt.body);
+}
+
+void DeadCodeEliminator::Visit(ProcedureCallStmt& procedureCallStmt)
+{
+	for (auto&& expr : procedureCallStmt.arguments)
+	{
+		expr->Accept(*this);
+	}
+	if (phase == Phase::MARK)
+	{
+		Reach(procedureCallStmt.callee);
+	}
+}
+
+// slots of a copied body get reset together -> all of them stay
+void DeadCodeEliminator::Visit(InlinedCallStmt& inlinedCallStmt)
+{
+	for (auto&& expr : inlinedCallStmt.arguments)
+	{
+		expr->Accept(*this);
+	}
+	if (phase == Phase::MARK)
+	{
+		for (uint32_t i = 0; i < inlinedCallStmt.slots.size(); i++)
+		{
+			roots.push_back(SideEffects::Of(chain, { 0, inlinedCallStmt.base + i }));
+		}
+	}
+	else if (inlinedCallStmt.slots.empty()) // base may be past the last slot -> live ones below it
+	{
+		const std::vector<bool>& live = scopes.at(chain.back()).live;
+		inlinedCallStmt.base = static_cast<uint32_t>(std::count(live.begin(), live.begin() + std::min<size_t>(inlinedCallStmt.base, live.size()), true));
+	}
+	else
+	{
+		inlinedCallStmt.base = Moved({ 0, inlinedCallStmt.base }).slot;
+	}
+	Rewrite(inlinedCallStmt.body);
+}
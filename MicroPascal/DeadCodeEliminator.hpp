@@ -0,0 +1,93 @@
+#ifndef DEADCODEELIMINATOR_HPP
+#define DEADCODEELIMINATOR_HPP
+
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "Arena.hpp"
+#include "Expr.hpp"
+#include "Stmt.hpp"
+#include "SideEffects.hpp"
+
+// optimization pass over a resolved program -> routines no call from the program's body leads to lose their declarations,
+// local variables nothing reads lose their slots (with assignments to them that cannot fail), statements behind constant
+// conditions and after loops that never end get removed
+class DeadCodeEliminator : public VisitorExpr, public VisitorStmt
+{
+public:
+	DeadCodeEliminator(Arena& m_arena);
+
+	void Eliminate(Stmt* program);
+
+private:
+	Literal Visit(BinaryExpr& binExpr) override;
+	Literal Visit(UnaryExpr& unExpr) override;
+	Literal Visit([[maybe_unused]] LiteralExpr& litExpr) override;
+	Literal Visit(GroupingExpr& grExpr) override;
+	Literal Visit(VariableExpr& varExpr) override;
+	Literal Visit(FunctionCallExpr& funcCallExpr) override;
+	Literal Visit(InlinedCallExpr& inlinedCallExpr) override;
+
+	void Visit(ProgramStmt& programStmt) override;
+	void Visit(CompoundStmt& compoundStmt) override;
+	void Visit(WritelnStmt& writelnStmt) override;
+	void Visit([[maybe_unused]] EmptyStmt& emptyStmt) override;
+	void Visit([[maybe_unused]] VarDeclStmt& varDeclStmt) override;
+	void Visit(FuncDeclStmt& funcDeclStmt) override;
+	void Visit(AssignmentStmt& assignmentStmt) override;
+	void Visit(IfStmt& ifStmt) override;
+	void Visit(WhileStmt& whileStmt) override;
+	void Visit(ForStmt& forStmt) override;
+	void Visit(ProcDeclStmt& procDeclStmt) override;
+	void Visit(ProcedureCallStmt& procedureCallStmt) override;
+	void Visit(InlinedCallStmt& inlinedCallStmt) override;
+
+	enum class Phase
+	{
+		COLLECT, // declarations only
+		MARK, // bodies of routines calls lead to, dead branches get cut off on the way
+		SWEEP, // same bodies once more, with the slots that are left
+	};
+
+	// routine (or the program) as seen by this pass
+	struct Scope
+	{
+		const Routine* parent = nullptr; // routine it is declared in, nullptr -> program
+		Span<VariableType>* slots = nullptr;
+		Stmt* body = nullptr;
+		uint32_t locals = 0; // first slot that is neither a parameter nor the return variable
+		bool reachable = false;
+		std::vector<bool> live; // slot gets read, or has to stay anyway
+		std::vector<uint32_t> moved; // new slot of every live one
+	};
+
+	void Collect(const Routine* routine, Span<VariableType>* slots, Span<Stmt*> decl_stmts, Stmt* body, uint32_t locals);
+	void Reach(const Routine* routine);
+	void Read(Address address);
+	void Propagate(); // liveness from unconditional reads along conditional ones
+	void Renumber(Scope& scope);
+	void Sweep(const Routine* routine, Span<Stmt*>& decl_stmts, Stmt* body);
+
+	void Rewrite(Stmt*& stmt); // walks stmt, replaces it by what is left of it
+	bool Live(Address address) const;
+	Address Moved(Address address) const;
+	static bool Pure(Expr* expr); // no calls, cannot fail
+	static bool Endless(Stmt* stmt); // while loop whose condition is true
+
+	Arena& arena; // shortened lists go in here
+	Phase phase = Phase::COLLECT;
+	ProgramStmt* program_stmt = nullptr;
+	std::unordered_map<const Routine*, Scope> scopes;
+	const Routine* current = nullptr; // routine whose declarations are being collected
+	std::vector<const Routine*> pending; // reached, body not marked yet
+	SideEffects::Chain chain; // routines being walked, innermost last
+	std::vector<SideEffects::Variable> roots; // read unconditionally
+	std::vector<std::pair<SideEffects::Variable, SideEffects::Variable>> uses; // variable is read by an assignment to another
+	const SideEffects::Variable* assigned = nullptr; // target of the assignment whose value is being walked, nullptr -> none
+	Stmt* replaced_stmt = nullptr; // replacement of the statement just visited
+	bool dropped = false; // declaration just visited goes away
+};
+
+#endif // !DEADCODEELIMINATOR_HPP
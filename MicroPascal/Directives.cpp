@@ -0,0 +1,261 @@
+#include <algorithm>
+#include <iterator>
+
+#include "Directives.hpp"
+
+// sets what the interpreter has to know about the switches on the nodes they concern
+class SwitchMarker : public VisitorExpr, public VisitorStmt
+{
+public:
+	SwitchMarker(const Directives& m_directives, uint32_t m_shift) : directives(m_directives), shift(m_shift) {}
+
+private:
+	Literal Visit(BinaryExpr& binExpr) override;
+	Literal Visit(UnaryExpr& unExpr) override;
+	Literal Visit([[maybe_unused]] LiteralExpr& litExpr) override;
+	Literal Visit(GroupingExpr& grExpr) override;
+	Literal Visit([[maybe_unused]] VariableExpr& varExpr) override;
+	Literal Visit(FunctionCallExpr& funcCallExpr) override;
+	Literal Visit(InlinedCallExpr& inlinedCallExpr) override;
+
+	void Visit(ProgramStmt& programStmt) override;
+	void Visit(CompoundStmt& compoundStmt) override;
+	void Visit(WritelnStmt& writelnStmt) override;
+	void Visit([[maybe_unused]] EmptyStmt& emptyStmt) override;
+	void Visit([[maybe_unused]] VarDeclStmt& varDeclStmt) override;
+	void Visit(FuncDeclStmt& funcDeclStmt) override;
+	void Visit(AssignmentStmt& assignmentStmt) override;
+	void Visit(IfStmt& ifStmt) override;
+	void Visit(WhileStmt& whileStmt) override;
+	void Visit(ForStmt& forStmt) override;
+	void Visit(ProcDeclStmt& procDeclStmt) override;
+	void Visit(ProcedureCallStmt& procedureCallStmt) override;
+	void Visit(InlinedCallStmt& inlinedCallStmt) override;
+
+	void MarkRoutine(Routine* routine, SourceLoc loc, Span<Stmt*> decl_stmts, Stmt* body);
+	Switches At(SourceLoc loc) const { return directives.At(SourceLoc{ loc.offset + shift }); }
+
+	const Directives& directives;
+	uint32_t shift; // location of a node -> offset in the text, wraps around for negative ones
+};
+
+Literal SwitchMarker::Visit(BinaryExpr& binExpr)
+{
+	binExpr.left->Accept(*this);
+	binExpr.right->Accept(*this);
+
+	Switches switches = At(binExpr.loc);
+	if (binExpr.op == TokenType::AND || binExpr.op == TokenType::OR)
+	{
+		binExpr.short_circuit = !switches.complete_booleans;
+	}
+	else if (binExpr.op == TokenType::DIV)
+	{
+		binExpr.proven = !switches.range_checks; // divisor not checked for zero, before the range analyzer runs
+	}
+	return nullptr;
+}
+
+Literal SwitchMarker::Visit(UnaryExpr& unExpr)
+{
+	unExpr.right->Accept(*this);
+	return nullptr;
+}
+
+Literal SwitchMarker::Visit([[maybe_unused]] LiteralExpr& litExpr)
+{
+	return nullptr;
+}
+
+Literal SwitchMarker::Visit(GroupingExpr& grExpr)
+{
+	grExpr.expr->Accept(*this);
+	return nullptr;
+}
+
+Literal SwitchMarker::Visit([[maybe_unused]] VariableExpr& varExpr)
+{
+	return nullptr;
+}
+
+Literal SwitchMarker::Visit(FunctionCallExpr& funcCallExpr)
+{
+	for (auto&& expr : funcCallExpr.exprs)
+	{
+		expr->Accept(*this);
+	}
+	return nullptr;
+}
+
+Literal SwitchMarker::Visit(InlinedCallExpr& inlinedCallExpr)
+{
+	Visit(*inlinedCallExpr.call);
+	return nullptr;
+}
+
+void SwitchMarker::Visit(ProgramStmt& programStmt)
+{
+	for (auto&& decl : programStmt.decl_stmts)
+	{
+		decl->Accept(*this);
+	}
+	programStmt.stmt->Accept(*this);
+}
+
+void SwitchMarker::Visit(CompoundStmt& compoundStmt)
+{
+	for (auto&& stmt : compoundStmt.statements)
+	{
+		stmt->Accept(*this);
+	}
+}
+
+void SwitchMarker::Visit(WritelnStmt& writelnStmt)
+{
+	for (auto&& expr : writelnStmt.exprs)
+	{
+		expr->Accept(*this);
+	}
+}
+
+void SwitchMarker::Visit([[maybe_unused]] EmptyStmt& emptyStmt) {}
+
+void SwitchMarker::Visit([[maybe_unused]] VarDeclStmt& varDeclStmt) {}
+
+void SwitchMarker::Visit(FuncDeclStmt& funcDeclStmt)
+{
+	MarkRoutine(funcDeclStmt.routine, funcDeclStmt.id.loc, funcDeclStmt.decl_stmts, funcDeclStmt.body);
+}
+
+void SwitchMarker::Visit(ProcDeclStmt& procDeclStmt)
+{
+	MarkRoutine(procDeclStmt.routine, procDeclStmt.id.loc, procDeclStmt.decl_stmts, procDeclStmt.body);
+}
+
+// stack gets checked on entering a routine -> switch where it is declared counts, not the ones at its calls
+void SwitchMarker::MarkRoutine(Routine* routine, SourceLoc loc, Span<Stmt*> decl_stmts, Stmt* body)
+{
+	routine->stack_check = At(loc).stack_checks;
+	for (auto&& decl : decl_stmts)
+	{
+		decl->Accept(*this);
+	}
+	body->Accept(*this);
+}
+
+void SwitchMarker::Visit(AssignmentStmt& assignmentStmt)
+{
+	assignmentStmt.value->Accept(*this);
+}
+
+void SwitchMarker::Visit(IfStmt& ifStmt)
+{
+	ifStmt.condition->Accept(*this);
+	ifStmt.then_branch->Accept(*this);
+	if (ifStmt.else_branch != nullptr)
+	{
+		ifStmt.else_branch->Accept(*this);
+	}
+}
+
+void SwitchMarker::Visit(WhileStmt& whileStmt)
+{
+	whileStmt.condition->Accept(*this);
+	whileStmt.body->Accept(*this);
+}
+
+void SwitchMarker::Visit(ForStmt& forStmt)
+{
+	forStmt.assignment->Accept(*this);
+	forStmt.expression->Accept(*this);
+	forStmt.body->Accept(*this);
+}
+
+void SwitchMarker::Visit(ProcedureCallStmt& procedureCallStmt)
+{
+	for (auto&& expr : procedureCallStmt.arguments)
+	{
+		expr->Accept(*this);
+	}
+}
+
+void SwitchMarker::Visit(InlinedCallStmt& inlinedCallStmt)
+{
+	for (auto&& expr : inlinedCallStmt.arguments)
+	{
+		expr->Accept(*this);
+	}
+	inlinedCallStmt.body->Accept(*this);
+}
+
+
+Directives::Directives(Switches m_initial) : initial(m_initial) {}
+
+bool Directives::Parse(std::string_view text, Switches& switches)
+{
+	Switches parsed = switches;
+	size_t pos = 0;
+	while (true)
+	{
+		if (pos + 2 > text.size() || (text[pos + 1] != '+' && text[pos + 1] != '-'))
+		{
+			return false;
+		}
+		bool on = text[pos + 1] == '+';
+		switch (text[pos])
+		{
+		case 'B': case 'b':
+			parsed.complete_booleans = on;
+			break;
+		case 'S': case 's':
+			parsed.stack_checks = on;
+			break;
+		case 'R': case 'r':
+			parsed.range_checks = on;
+			break;
+		default:
+			return false;
+		}
+
+		pos += 2;
+		if (pos == text.size())
+		{
+			break;
+		}
+		if (text[pos] != ',')
+		{
+			return false;
+		}
+		pos++;
+	}
+
+	switches = parsed;
+	return true;
+}
+
+void Directives::Add(SourceLoc loc, std::string_view text)
+{
+	Switches switches = changes.empty() ? initial : changes.back().switches;
+	if (Parse(text, switches))
+	{
+		changes.push_back({ loc.offset, switches });
+	}
+}
+
+Switches Directives::At(SourceLoc loc) const
+{
+	auto after = std::upper_bound(changes.begin(), changes.end(), loc.offset,
+		[](uint32_t offset, const Change& change) { return offset < change.offset; });
+	return after == changes.begin() ? initial : std::prev(after)->switches;
+}
+
+bool Directives::Default() const
+{
+	return changes.empty() && initial.complete_booleans && initial.stack_checks && initial.range_checks;
+}
+
+void Directives::Apply(Stmt* node, uint32_t shift) const
+{
+	SwitchMarker marker(*this, shift);
+	node->Accept(marker);
+}
@@ -0,0 +1,45 @@
+#ifndef DIRECTIVES_HPP
+#define DIRECTIVES_HPP
+
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+#include "SourceLoc.hpp"
+#include "Stmt.hpp"
+
+// compiler switches in the style of Free Pascal, default ones leave the interpreter as safe as it can be
+struct Switches
+{
+	bool complete_booleans = true; // {$B+} -> and, or evaluate both operands
+	bool stack_checks = true; // {$S+} -> calls nested too deep stop the program with an error
+	bool range_checks = true; // {$R+} -> division by zero stops the program with an error
+};
+
+// switches set by {$B-}, {$S+}, {$R-,S-}, ... comments, each from the end of its comment on
+class Directives
+{
+public:
+	Directives(Switches m_initial);
+
+	static bool Parse(std::string_view text, Switches& switches); // "B-,R+" (letters in any case), false -> not like that, switches untouched
+
+	void Add(SourceLoc loc, std::string_view text); // text of a comment behind "{$", ignored unless it parses
+	Switches At(SourceLoc loc) const;
+	bool Default() const; // everywhere as if there were no directives
+
+	void Apply(Stmt* node, uint32_t shift = 0) const; // marks nodes of a resolved program by the switches of their regions, at locations + shift
+
+private:
+	// switches from offset on
+	struct Change
+	{
+		uint32_t offset;
+		Switches switches;
+	};
+
+	Switches initial;
+	std::vector<Change> changes; // by offset
+};
+
+#endif // !DIRECTIVES_HPP
@@ -1,55 +1,31 @@
 ﻿#ifndef ENVIRONMENT_HPP
 #define ENVIRONMENT_HPP
 
-#include <unordered_map>
-#include <string>
-#include <variant>
-#include <memory>
 #include <vector>
 
-#include "Stmt.hpp"
+#include "Arena.hpp"
+#include "Expr.hpp"
 #include "Token.hpp"
 
-class Callable;
-
+// variables of one activation of a routine (or of the program), addressed by the slots the resolver gave them
 class Environment
 {
 public:
-	Environment();
-	Environment(std::shared_ptr<Environment> m_enclosing_env);
-
-	static bool IsLiteral(std::variant<Literal, std::shared_ptr<Callable>> value);
-	static bool IsCallable(std::variant<Literal, std::shared_ptr<Callable>> value);
-
-	void Define(Token name, VariableType type);
-	void Define(Token name, Callable callable);
+	Environment(Span<VariableType> slots, Environment* m_enclosing_env);
+	Environment(std::vector<Literal>&& m_values, Environment* m_enclosing_env); // values already set up for the slots
 
-	std::variant<Literal, std::shared_ptr<Callable>>& Get(Token& name);
-	Literal& GetLiteral(Token& name);
-	std::shared_ptr<Callable>& GetCallable(Token& name);
+	Literal& Get(Address address);
+	void Reset(uint32_t first, Span<VariableType> slots); // slots from first on -> zero values again, like in a new environment
+	std::vector<Literal> Release(); // values, their memory can serve another environment
 
-	void Assign(Token& name, Literal value);
+	static std::vector<Literal> Zeros(Span<VariableType> slots);
 
-	std::shared_ptr<Environment> enclosing_env;
+	Environment* enclosing_env; // of the routine this one was declared in (not of the caller) -> lexical scoping
 
 private:
-	std::unordered_map<std::string, std::variant<Literal, std::shared_ptr<Callable>>> values;
-};
-
-
-class Callable {
-public:
-	Callable(std::shared_ptr<Stmt> m_body, std::vector<std::shared_ptr<Stmt>> m_declarations, std::vector<std::pair<Token, VariableType>> m_parameters, std::optional<VariableType> m_return_type);
-	
-	void PassArguments(std::vector<Literal> arguments, Token& callee);
-
-	std::shared_ptr<Stmt> body;
-	std::vector<std::shared_ptr<Stmt>> declarations;
-	std::vector<std::pair<Token, VariableType>> parameters;
-
-	std::optional<VariableType> return_type;
+	static Literal Zero(VariableType type);
 
-	std::shared_ptr<Environment> local_env = nullptr; // gets assigned on call
+	std::vector<Literal> values;
 };
 
 
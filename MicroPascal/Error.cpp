@@ -1,11 +1,39 @@
 #include "Error.hpp"
 
-Error::Error(int line, std::string message)
+Error::Error(int m_line, std::string m_message) : line(m_line), has_line(true), message(std::move(m_message)) {}
+
+Error::Error(SourceLoc m_loc, std::string m_message) : line(0), loc(m_loc), has_line(false), message(std::move(m_message)) {}
+
+std::string Error::what() const noexcept
 {
-	error_message = ("[Line: " + std::to_string(line) + "] " + "Error: " + message);
+	return ("[Line: " + std::to_string(line) + "] " + "Error: " + message);
 }
 
-std::string Error::what() const noexcept
+int Error::Line() const noexcept
 {
-	return error_message;
-}
\ No newline at end of file
+	return line;
+}
+
+const std::string& Error::Message() const noexcept
+{
+	return message;
+}
+
+bool Error::HasLine() const noexcept
+{
+	return has_line;
+}
+
+SourceLoc Error::Loc() const noexcept
+{
+	return loc;
+}
+
+void Error::ResolveLine(const LineTable& lines)
+{
+	if (!has_line)
+	{
+		line = lines.Line(loc);
+		has_line = true;
+	}
+}
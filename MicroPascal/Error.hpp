@@ -3,13 +3,26 @@
 
 #include <string>
 
+#include "SourceLoc.hpp"
+
 class Error
 {
 public:
-	Error(int line, std::string message);
+	Error(int m_line, std::string m_message);
+	Error(SourceLoc m_loc, std::string m_message); // line gets looked up only if the error is reported -> ResolveLine
 	std::string what() const noexcept;
 
+	int Line() const noexcept;
+	const std::string& Message() const noexcept; // without line prefix
+
+	bool HasLine() const noexcept;
+	SourceLoc Loc() const noexcept; // only meaningful without line
+	void ResolveLine(const LineTable& lines);
+
 private:
-	std::string error_message;
+	int line;
+	SourceLoc loc;
+	bool has_line;
+	std::string message;
 };
 #endif // !ERROR:HPP
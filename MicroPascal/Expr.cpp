@@ -2,8 +2,8 @@
 
 #include "Expr.hpp"
 
-BinaryExpr::BinaryExpr(std::unique_ptr<Expr> m_left, std::unique_ptr<Expr> m_right, Token& m_op)
-	: left(std::move(m_left)), right(std::move(m_right)), op(m_op) {};
+BinaryExpr::BinaryExpr(Expr* m_left, Expr* m_right, TokenType m_op, SourceLoc m_loc)
+	: op(m_op), loc(m_loc), left(m_left), right(m_right) {};
 	
 Literal BinaryExpr::Accept(VisitorExpr& visitor)
 {
@@ -11,8 +11,8 @@ Literal BinaryExpr::Accept(VisitorExpr& visitor)
 };
 
 
-UnaryExpr::UnaryExpr(std::unique_ptr<Expr> m_right, Token& m_op)
-	: right(std::move(m_right)), op(m_op) {};
+UnaryExpr::UnaryExpr(Expr* m_right, TokenType m_op, SourceLoc m_loc)
+	: op(m_op), loc(m_loc), right(m_right) {};
 
 Literal UnaryExpr::Accept(VisitorExpr& visitor)
 {
@@ -28,7 +28,7 @@ Literal LiteralExpr::Accept(VisitorExpr& visitor)
 };
 
 
-GroupingExpr::GroupingExpr(std::unique_ptr<Expr> m_expr) : expr(std::move(m_expr)) {};
+GroupingExpr::GroupingExpr(Expr* m_expr) : expr(m_expr) {};
 
 Literal GroupingExpr::Accept(VisitorExpr& visitor)
 {
@@ -36,7 +36,7 @@ Literal GroupingExpr::Accept(VisitorExpr& visitor)
 };
 
 
-VariableExpr::VariableExpr(Token m_token) : token(m_token) {};
+VariableExpr::VariableExpr(Identifier m_id) : id(m_id) {};
 
 Literal VariableExpr::Accept(VisitorExpr& visitor)
 {
@@ -44,10 +44,19 @@ Literal VariableExpr::Accept(VisitorExpr& visitor)
 }
 
 
-FunctionCallExpr::FunctionCallExpr(std::vector<std::unique_ptr<Expr>> m_exprs, Token m_id_token)
-	: exprs(std::move(m_exprs)), id_token(m_id_token) {};
+FunctionCallExpr::FunctionCallExpr(Span<Expr*> m_exprs, Identifier m_id)
+	: id(m_id), exprs(m_exprs) {};
 
 Literal FunctionCallExpr::Accept(VisitorExpr& visitor)
 {
 	return visitor.Visit(*this);
 }
+
+
+InlinedCallExpr::InlinedCallExpr(InlinedCallStmt* m_call, uint32_t m_result)
+	: call(m_call), result(m_result) {};
+
+Literal InlinedCallExpr::Accept(VisitorExpr& visitor)
+{
+	return visitor.Visit(*this);
+}
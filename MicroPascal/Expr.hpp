@@ -1,9 +1,9 @@
 #ifndef EXPR_HPP
 #define EXPR_HPP
 
-#include <memory>
-#include <vector>
+#include <cstdint>
 
+#include "Arena.hpp"
 #include "Token.hpp"
 
 class BinaryExpr;
@@ -12,6 +12,17 @@ class LiteralExpr;
 class GroupingExpr;
 class VariableExpr;
 class FunctionCallExpr;
+class InlinedCallExpr;
+
+class InlinedCallStmt;
+struct Routine;
+
+// where a variable lives at runtime, filled in by the resolver
+struct Address
+{
+	uint32_t depth = 0; // environments to go up from the current one
+	uint32_t slot = 0; // index of the variable in that environment
+};
 
 class VisitorExpr
 {
@@ -22,38 +33,46 @@ public:
 	virtual Literal Visit(GroupingExpr& grExpr) = 0;
 	virtual Literal Visit(VariableExpr& varExpr) = 0;
 	virtual Literal Visit(FunctionCallExpr& funcCallExpr) = 0;
+	virtual Literal Visit(InlinedCallExpr& inlinedCallExpr) = 0;
 };
 
 
-class Expr
+class Expr // nodes live in an arena -> never deleted through this base
 {
 public:
-	virtual ~Expr() {};
-
 	virtual Literal Accept(VisitorExpr& visitor) = 0;
+
+	VariableType type = VariableType::INTEGER; // of its value, filled in by the resolver -> small fields of derived nodes go right after it
+
+protected:
+	~Expr() = default;
 };
 
 class BinaryExpr : public Expr
 {
 public:
-	BinaryExpr(std::unique_ptr<Expr> m_left, std::unique_ptr<Expr> m_right, Token& m_op);
+	BinaryExpr(Expr* m_left, Expr* m_right, TokenType m_op, SourceLoc m_loc);
 
 	Literal Accept(VisitorExpr& visitor) override;
 
-	std::unique_ptr<Expr> left;
-	std::unique_ptr<Expr> right;
-	Token op;
+	TokenType op;
+	bool proven = false; // cannot fail (divisor never zero, result never overflows) -> no runtime check, filled in by the range analyzer, div in a {$R-} region gets it too
+	bool short_circuit = false; // and, or in a {$B-} region -> right operand evaluated only if the left one does not decide
+	SourceLoc loc; // of the operator
+	Expr* left;
+	Expr* right;
 };
 
 class UnaryExpr : public Expr
 {
 public:
-	UnaryExpr(std::unique_ptr<Expr> m_right, Token& m_op);
+	UnaryExpr(Expr* m_right, TokenType m_op, SourceLoc m_loc);
 
 	Literal Accept(VisitorExpr& visitor) override;
 
-	std::unique_ptr<Expr> right;
-	Token op;
+	TokenType op;
+	SourceLoc loc; // of the operator
+	Expr* right;
 };
 
 class LiteralExpr : public Expr
@@ -69,32 +88,49 @@ public:
 class GroupingExpr : public Expr
 {
 public:
-	GroupingExpr(std::unique_ptr<Expr> m_expr);
+	GroupingExpr(Expr* m_expr);
 
 	Literal Accept(VisitorExpr& visitor) override;
 
-	std::unique_ptr<Expr> expr;
+	Expr* expr;
 };
 
 class VariableExpr : public Expr
 {
 public:
-	VariableExpr(Token m_token);
+	VariableExpr(Identifier m_id);
 
 	Literal Accept(VisitorExpr& visitor) override;
 
-	Token token;
+	Identifier id;
+	Address address;
+	Routine* callee = nullptr; // function without parameters -> gets called, address.depth leads to where it was declared
 };
 
 class FunctionCallExpr : public Expr
 {
 public:
-	FunctionCallExpr(std::vector<std::unique_ptr<Expr>> m_exprs, Token m_id_token);
+	FunctionCallExpr(Span<Expr*> m_exprs, Identifier m_id);
+
+	Literal Accept(VisitorExpr& visitor) override;
+
+	Identifier id;
+	uint32_t depth = 0; // environments to go up from the caller's one to the one callee was declared in
+	bool tail = false; // caller calling itself as the last thing it does -> reuses its environment, filled in by the tail call finder
+	Span<Expr*> exprs;
+	Routine* callee = nullptr;
+};
+
+// function call the inliner replaced by a copy of the callee's body -> made after resolving, never parsed
+class InlinedCallExpr : public Expr
+{
+public:
+	InlinedCallExpr(InlinedCallStmt* m_call, uint32_t m_result);
 
 	Literal Accept(VisitorExpr& visitor) override;
 
-	std::vector<std::unique_ptr<Expr>> exprs;
-	Token id_token;
+	InlinedCallStmt* call;
+	uint32_t result; // slot of the return variable in the caller's environment
 };
 
 #endif // !EXPR_HPP
\ No newline at end of file
@@ -0,0 +1,550 @@
+#include <algorithm>
+#include <utility>
+
+#include "Inliner.hpp"
+
+// deep copy of a routine's body for one call site -> variables of the routine move to slots of the caller from base on,
+// environments further out are reached from the caller's one, which lies depth of the call below the callee's declaration
+class BodyCopier : public VisitorExpr, public VisitorStmt
+{
+public:
+	BodyCopier(Arena& m_arena, uint32_t m_base, uint32_t m_call_depth) : arena(m_arena), base(m_base), call_depth(m_call_depth) {}
+
+	Expr* Copy(Expr* expr)
+	{
+		expr->Accept(*this);
+		return copied_expr;
+	}
+
+	Stmt* Copy(Stmt* stmt)
+	{
+		stmt->Accept(*this);
+		return copied_stmt;
+	}
+
+private:
+	Literal Visit(BinaryExpr& binExpr) override;
+	Literal Visit(UnaryExpr& unExpr) override;
+	Literal Visit(LiteralExpr& litExpr) override;
+	Literal Visit(GroupingExpr& grExpr) override;
+	Literal Visit(VariableExpr& varExpr) override;
+	Literal Visit(FunctionCallExpr& funcCallExpr) override;
+	Literal Visit(InlinedCallExpr& inlinedCallExpr) override;
+
+	void Visit([[maybe_unused]] ProgramStmt& programStmt) override;
+	void Visit(CompoundStmt& compoundStmt) override;
+	void Visit(WritelnStmt& writelnStmt) override;
+	void Visit([[maybe_unused]] EmptyStmt& emptyStmt) override;
+	void Visit([[maybe_unused]] VarDeclStmt& varDeclStmt) override;
+	void Visit([[maybe_unused]] FuncDeclStmt& funcDeclStmt) override;
+	void Visit(AssignmentStmt& assignmentStmt) override;
+	void Visit(IfStmt& ifStmt) override;
+	void Visit(WhileStmt& whileStmt) override;
+	void Visit(ForStmt& forStmt) override;
+	void Visit([[maybe_unused]] ProcDeclStmt& procDeclStmt) override;
+	void Visit(ProcedureCallStmt& procedureCallStmt) override;
+	void Visit(InlinedCallStmt& inlinedCallStmt) override;
+
+	Span<Expr*> Copy(Span<Expr*> exprs);
+	Address Moved(Address address) const;
+	uint32_t Moved(uint32_t depth) const; // of a call, callee is declared outside of the copied routine
+
+	Arena& arena;
+	uint32_t base;
+	uint32_t call_depth; // 0 -> callee is declared in the caller itself
+	Expr* copied_expr = nullptr;
+	Stmt* copied_stmt = nullptr;
+};
+
+Span<Expr*> BodyCopier::Copy(Span<Expr*> exprs)
+{
+	std::vector<Expr*> copies;
+	copies.reserve(exprs.size());
+	for (auto&& expr : exprs)
+	{
+		copies.push_back(Copy(expr));
+	}
+	return arena.Copy(copies);
+}
+
+Address BodyCopier::Moved(Address address) const
+{
+	if (address.depth == 0)
+	{
+		return { 0, base + address.slot };
+	}
+	return { Moved(address.depth), address.slot };
+}
+
+uint32_t BodyCopier::Moved(uint32_t depth) const
+{
+	return depth + call_depth - 1;
+}
+
+Literal BodyCopier::Visit(BinaryExpr& binExpr)
+{
+	Expr* left = Copy(binExpr.left);
+	Expr* right = Copy(binExpr.right);
+	auto* copy = arena.New<BinaryExpr>(left, right, binExpr.op, binExpr.loc);
+	copy->type = binExpr.type;
+	copy->short_circuit = binExpr.short_circuit;
+	copy->proven = binExpr.proven;
+	copied_expr = copy;
+	return nullptr;
+}
+
+Literal BodyCopier::Visit(UnaryExpr& unExpr)
+{
+	copied_expr = arena.New<UnaryExpr>(Copy(unExpr.right), unExpr.op, unExpr.loc);
+	copied_expr->type = unExpr.type;
+	return nullptr;
+}
+
+Literal BodyCopier::Visit(LiteralExpr& litExpr)
+{
+	copied_expr = arena.New<LiteralExpr>(litExpr.value);
+	copied_expr->type = litExpr.type;
+	return nullptr;
+}
+
+Literal BodyCopier::Visit(GroupingExpr& grExpr)
+{
+	copied_expr = arena.New<GroupingExpr>(Copy(grExpr.expr));
+	copied_expr->type = grExpr.type;
+	return nullptr;
+}
+
+Literal BodyCopier::Visit(VariableExpr& varExpr)
+{
+	auto* copy = arena.New<VariableExpr>(varExpr.id);
+	copy->type = varExpr.type;
+	copy->callee = varExpr.callee;
+	copy->address = varExpr.callee != nullptr ? Address{ Moved(varExpr.address.depth), 0 } : Moved(varExpr.address);
+	copied_expr = copy;
+	return nullptr;
+}
+
+Literal BodyCopier::Visit(FunctionCallExpr& funcCallExpr)
+{
+	auto* copy = arena.New<FunctionCallExpr>(Copy(funcCallExpr.exprs), funcCallExpr.id);
+	copy->type = funcCallExpr.type;
+	copy->callee = funcCallExpr.callee;
+	copy->depth = Moved(funcCallExpr.depth);
+	copied_expr = copy;
+	return nullptr;
+}
+
+Literal BodyCopier::Visit(InlinedCallExpr& inlinedCallExpr)
+{
+	Visit(*inlinedCallExpr.call);
+	copied_expr = arena.New<InlinedCallExpr>(static_cast<InlinedCallStmt*>(copied_stmt), base + inlinedCallExpr.result);
+	copied_expr->type = inlinedCallExpr.type;
+	return nullptr;
+}
+
+// declarations are not part of a body
+void BodyCopier::Visit([[maybe_unused]] ProgramStmt& programStmt) {}
+
+void BodyCopier::Visit([[maybe_unused]] VarDeclStmt& varDeclStmt) {}
+
+void BodyCopier::Visit([[maybe_unused]] FuncDeclStmt& funcDeclStmt) {}
+
+void BodyCopier::Visit([[maybe_unused]] ProcDeclStmt& procDeclStmt) {}
+
+void BodyCopier::Visit(CompoundStmt& compoundStmt)
+{
+	std::vector<Stmt*> copies;
+	copies.reserve(compoundStmt.statements.size());
+	for (auto&& stmt : compoundStmt.statements)
+	{
+		copies.push_back(Copy(stmt));
+	}
+	copied_stmt = arena.New<CompoundStmt>(arena.Copy(copies));
+}
+
+void BodyCopier::Visit(WritelnStmt& writelnStmt)
+{
+	copied_stmt = arena.New<WritelnStmt>(Copy(writelnStmt.exprs));
+}
+
+void BodyCopier::Visit([[maybe_unused]] EmptyStmt& emptyStmt)
+{
+	copied_stmt = arena.New<EmptyStmt>();
+}
+
+void BodyCopier::Visit(AssignmentStmt& assignmentStmt)
+{
+	auto* copy = arena.New<AssignmentStmt>(assignmentStmt.id, Copy(assignmentStmt.value));
+	copy->address = Moved(assignmentStmt.address);
+	copied_stmt = copy;
+}
+
+void BodyCopier::Visit(IfStmt& ifStmt)
+{
+	Expr* condition = Copy(ifStmt.condition);
+	Stmt* then_branch = Copy(ifStmt.then_branch);
+	Stmt* else_branch = ifStmt.else_branch != nullptr ? Copy(ifStmt.else_branch) : nullptr;
+	copied_stmt = arena.New<IfStmt>(ifStmt.loc, condition, then_branch, else_branch);
+}
+
+void BodyCopier::Visit(WhileStmt& whileStmt)
+{
+	Expr* condition = Copy(whileStmt.condition);
+	copied_stmt = arena.New<WhileStmt>(whileStmt.loc, condition, Copy(whileStmt.body));
+}
+
+void BodyCopier::Visit(ForStmt& forStmt)
+{
+	Stmt* assignment = Copy(forStmt.assignment);
+	Expr* expression = Copy(forStmt.expression);
+	auto* copy = arena.New<ForStmt>(forStmt.loc, forStmt.increment, forStmt.id, assignment, expression, Copy(forStmt.body));
+	copy->address = Moved(forStmt.address);
+	copied_stmt = copy;
+}
+
+void BodyCopier::Visit(ProcedureCallStmt& procedureCallStmt)
+{
+	auto* copy = arena.New<ProcedureCallStmt>(Copy(procedureCallStmt.arguments), procedureCallStmt.id);
+	copy->callee = procedureCallStmt.callee;
+	copy->depth = Moved(procedureCallStmt.depth);
+	copied_stmt = copy;
+}
+
+void BodyCopier::Visit(InlinedCallStmt& inlinedCallStmt)
+{
+	Span<Expr*> arguments = Copy(inlinedCallStmt.arguments);
+	auto* copy = arena.New<InlinedCallStmt>(arguments, Copy(inlinedCallStmt.body), inlinedCallStmt.slots, base + inlinedCallStmt.base);
+	copy->stack_check = inlinedCallStmt.stack_check;
+	copied_stmt = copy;
+}
+
+
+Inliner::Inliner(Arena& m_arena, size_t m_budget) : arena(m_arena), budget(m_budget) {}
+
+void Inliner::Inline(Stmt* program)
+{
+	if (budget == 0)
+	{
+		return;
+	}
+
+	collecting = true;
+	program->Accept(*this);
+	collecting = false;
+	FindRecursion();
+
+	// callees are done when their callers get their copies
+	for (uint32_t index : order)
+	{
+		current = index;
+		Callable& callable = callables[index];
+		frame.assign(callable.slots->begin(), callable.slots->end());
+		Rewrite(callable.body); // compound statement -> never replaced, the routine keeps pointing to it
+		if (frame.size() > callable.slots->size())
+		{
+			*callable.slots = arena.Copy(frame);
+		}
+	}
+}
+
+void Inliner::Rewrite(Expr*& expr)
+{
+	if (collecting)
+	{
+		callables[current].size++;
+	}
+	inlined_expr = nullptr;
+	expr->Accept(*this);
+	if (inlined_expr != nullptr)
+	{
+		expr = inlined_expr;
+		inlined_expr = nullptr;
+	}
+}
+
+void Inliner::Rewrite(Stmt*& stmt)
+{
+	if (collecting)
+	{
+		callables[current].size++;
+	}
+	inlined_stmt = nullptr;
+	stmt->Accept(*this);
+	if (inlined_stmt != nullptr)
+	{
+		stmt = inlined_stmt;
+		inlined_stmt = nullptr;
+	}
+}
+
+void Inliner::Collect(Routine* routine, Span<VariableType>* slots, Span<Stmt*> decl_stmts, Stmt* body)
+{
+	uint32_t outer = current;
+	current = static_cast<uint32_t>(callables.size());
+	Callable callable;
+	callable.routine = routine;
+	callable.slots = slots;
+	callable.body = body;
+	callables.push_back(std::move(callable));
+	if (routine != nullptr)
+	{
+		indices[routine] = current;
+	}
+
+	for (auto&& decl : decl_stmts)
+	{
+		decl->Accept(*this);
+	}
+	Rewrite(body);
+	current = outer;
+}
+
+void Inliner::FindRecursion()
+{
+	// Tarjan's algorithm with an explicit stack -> call chains of any length,
+	// components are completed callees first
+	std::vector<uint32_t> component;
+	std::vector<std::pair<uint32_t, size_t>> path; // callable and its next callee to look at
+	int32_t discovered = 0;
+
+	auto discover = [&](uint32_t index)
+	{
+		callables[index].index = callables[index].low = discovered++;
+		callables[index].on_stack = true;
+		component.push_back(index);
+		path.push_back({ index, 0 });
+	};
+
+	for (uint32_t root = 0; root < callables.size(); root++)
+	{
+		if (callables[root].index >= 0)
+		{
+			continue;
+		}
+		discover(root);
+
+		while (!path.empty())
+		{
+			uint32_t index = path.back().first;
+			Callable& callable = callables[index];
+			if (path.back().second < callable.callees.size())
+			{
+				Routine* callee = callable.callees[path.back().second++];
+				uint32_t next = indices.at(callee);
+				callable.recursive = callable.recursive || callee == callable.routine;
+				if (callables[next].index < 0)
+				{
+					discover(next);
+				}
+				else if (callables[next].on_stack)
+				{
+					callable.low = std::min(callable.low, callables[next].index);
+				}
+				continue;
+			}
+
+			path.pop_back();
+			if (!path.empty())
+			{
+				Callable& caller = callables[path.back().first];
+				caller.low = std::min(caller.low, callable.low);
+			}
+			if (callable.low != callable.index)
+			{
+				continue; // part of a component further up
+			}
+
+			size_t first = order.size();
+			uint32_t member;
+			do
+			{
+				member = component.back();
+				component.pop_back();
+				callables[member].on_stack = false;
+				order.push_back(member);
+			} while (member != index);
+
+			if (order.size() - first > 1) // cycle through several routines
+			{
+				for (size_t i = first; i < order.size(); i++)
+				{
+					callables[order[i]].recursive = true;
+				}
+			}
+		}
+	}
+}
+
+bool Inliner::Inlinable(const Routine* callee) const
+{
+	const Callable& callable = callables[indices.at(callee)];
+	return !callable.recursive && !callable.nested && callable.size <= budget;
+}
+
+InlinedCallStmt* Inliner::Expand(const Routine* callee, uint32_t depth, Span<Expr*> arguments)
+{
+	auto base = static_cast<uint32_t>(frame.size());
+	frame.insert(frame.end(), callee->slots.begin(), callee->slots.end());
+	callables[current].size += callables[indices.at(callee)].size;
+
+	BodyCopier copier(arena, base, depth);
+	auto* inlined = arena.New<InlinedCallStmt>(arguments, copier.Copy(callee->body), callee->slots, base);
+	inlined->stack_check = callee->stack_check;
+	return inlined;
+}
+
+
+Literal Inliner::Visit(BinaryExpr& binExpr)
+{
+	Rewrite(binExpr.left);
+	Rewrite(binExpr.right);
+	return nullptr;
+}
+
+Literal Inliner::Visit(UnaryExpr& unExpr)
+{
+	Rewrite(unExpr.right);
+	return nullptr;
+}
+
+Literal Inliner::Visit([[maybe_unused]] LiteralExpr& litExpr)
+{
+	return nullptr;
+}
+
+Literal Inliner::Visit(GroupingExpr& grExpr)
+{
+	Rewrite(grExpr.expr);
+	return nullptr;
+}
+
+Literal Inliner::Visit(VariableExpr& varExpr)
+{
+	// function without parameters
+	if (varExpr.callee == nullptr)
+	{
+		return nullptr;
+	}
+	if (collecting)
+	{
+		callables[current].callees.push_back(varExpr.callee);
+	}
+	else if (Inlinable(varExpr.callee))
+	{
+		InlinedCallStmt* call = Expand(varExpr.callee, varExpr.address.depth, Span<Expr*>());
+		inlined_expr = arena.New<InlinedCallExpr>(call, call->base + varExpr.callee->parameter_count);
+		inlined_expr->type = varExpr.type;
+	}
+	return nullptr;
+}
+
+Literal Inliner::Visit(FunctionCallExpr& funcCallExpr)
+{
+	for (auto&& expr : funcCallExpr.exprs)
+	{
+		Rewrite(expr);
+	}
+
+	if (collecting)
+	{
+		callables[current].callees.push_back(funcCallExpr.callee);
+	}
+	else if (Inlinable(funcCallExpr.callee))
+	{
+		InlinedCallStmt* call = Expand(funcCallExpr.callee, funcCallExpr.depth, funcCallExpr.exprs);
+		inlined_expr = arena.New<InlinedCallExpr>(call, call->base + funcCallExpr.callee->parameter_count);
+		inlined_expr->type = funcCallExpr.type;
+	}
+	return nullptr;
+}
+
+// made by this pass, after the walk over the body they are in
+Literal Inliner::Visit([[maybe_unused]] InlinedCallExpr& inlinedCallExpr)
+{
+	return nullptr;
+}
+
+void Inliner::Visit([[maybe_unused]] InlinedCallStmt& inlinedCallStmt) {}
+
+void Inliner::Visit(ProgramStmt& programStmt)
+{
+	Collect(nullptr, &programStmt.slots, programStmt.decl_stmts, programStmt.stmt);
+}
+
+void Inliner::Visit(CompoundStmt& compoundStmt)
+{
+	for (auto&& stmt : compoundStmt.statements)
+	{
+		Rewrite(stmt);
+	}
+}
+
+void Inliner::Visit(WritelnStmt& writelnStmt)
+{
+	for (auto&& expr : writelnStmt.exprs)
+	{
+		Rewrite(expr);
+	}
+}
+
+void Inliner::Visit([[maybe_unused]] EmptyStmt& emptyStmt) {}
+
+void Inliner::Visit([[maybe_unused]] VarDeclStmt& varDeclStmt) {}
+
+// only reached while collecting, by the declarations of the enclosing routine
+void Inliner::Visit(FuncDeclStmt& funcDeclStmt)
+{
+	callables[current].nested = true;
+	Collect(funcDeclStmt.routine, &funcDeclStmt.routine->slots, funcDeclStmt.decl_stmts, funcDeclStmt.body);
+}
+
+void Inliner::Visit(ProcDeclStmt& procDeclStmt)
+{
+	callables[current].nested = true;
+	Collect(procDeclStmt.routine, &procDeclStmt.routine->slots, procDeclStmt.decl_stmts, procDeclStmt.body);
+}
+
+void Inliner::Visit(AssignmentStmt& assignmentStmt)
+{
+	Rewrite(assignmentStmt.value);
+}
+
+void Inliner::Visit(IfStmt& ifStmt)
+{
+	Rewrite(ifStmt.condition);
+	Rewrite(ifStmt.then_branch);
+	if (ifStmt.else_branch != nullptr)
+	{
+		Rewrite(ifStmt.else_branch);
+	}
+}
+
+void Inliner::Visit(WhileStmt& whileStmt)
+{
+	Rewrite(whileStmt.condition);
+	Rewrite(whileStmt.body);
+}
+
+void Inliner::Visit(ForStmt& forStmt)
+{
+	Rewrite(forStmt.assignment);
+	Rewrite(forStmt.expression);
+	Rewrite(forStmt.body);
+}
+
+void Inliner::Visit(ProcedureCallStmt& procedureCallStmt)
+{
+	for (auto&& expr : procedureCallStmt.arguments)
+	{
+		Rewrite(expr);
+	}
+
+	if (collecting)
+	{
+		callables[current].callees.push_back(procedureCallStmt.callee);
+	}
+	else if (Inlinable(procedureCallStmt.callee))
+	{
+		inlined_stmt = Expand(procedureCallStmt.callee, procedureCallStmt.depth, procedureCallStmt.arguments);
+	}
+}
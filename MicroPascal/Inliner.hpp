@@ -0,0 +1,78 @@
+#ifndef INLINER_HPP
+#define INLINER_HPP
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "Arena.hpp"
+#include "Expr.hpp"
+#include "Stmt.hpp"
+
+// optimization pass over a resolved program -> calls of small routines that are not part of any recursion
+// get a copy of the callee's body, whose parameters and locals become fresh slots of the caller's environment
+class Inliner : public VisitorExpr, public VisitorStmt
+{
+public:
+	Inliner(Arena& m_arena, size_t m_budget);
+
+	void Inline(Stmt* program);
+
+private:
+	Literal Visit(BinaryExpr& binExpr) override;
+	Literal Visit(UnaryExpr& unExpr) override;
+	Literal Visit(LiteralExpr& litExpr) override;
+	Literal Visit(GroupingExpr& grExpr) override;
+	Literal Visit(VariableExpr& varExpr) override;
+	Literal Visit(FunctionCallExpr& funcCallExpr) override;
+	Literal Visit(InlinedCallExpr& inlinedCallExpr) override;
+
+	void Visit(ProgramStmt& programStmt) override;
+	void Visit(CompoundStmt& compoundStmt) override;
+	void Visit(WritelnStmt& writelnStmt) override;
+	void Visit([[maybe_unused]] EmptyStmt& emptyStmt) override;
+	void Visit([[maybe_unused]] VarDeclStmt& varDeclStmt) override;
+	void Visit(FuncDeclStmt& funcDeclStmt) override;
+	void Visit(AssignmentStmt& assignmentStmt) override;
+	void Visit(IfStmt& ifStmt) override;
+	void Visit(WhileStmt& whileStmt) override;
+	void Visit(ForStmt& forStmt) override;
+	void Visit(ProcDeclStmt& procDeclStmt) override;
+	void Visit(ProcedureCallStmt& procedureCallStmt) override;
+	void Visit(InlinedCallStmt& inlinedCallStmt) override;
+
+	// routine as a vertex of the call graph
+	struct Callable
+	{
+		Routine* routine; // nullptr -> program
+		Span<VariableType>* slots; // of the routine or the program -> grow by what gets inlined
+		Stmt* body;
+		std::vector<Routine*> callees;
+		size_t size = 0; // nodes of the body, with what got inlined into it
+		bool nested = false; // declares routines itself -> body needs its own environment
+		bool recursive = false;
+		int32_t index = -1; // order of discovery in the search for cycles
+		int32_t low = 0; // smallest index reachable
+		bool on_stack = false;
+	};
+
+	void Rewrite(Expr*& expr); // walks expr, replaces it by what got inlined for it
+	void Rewrite(Stmt*& stmt);
+	void Collect(Routine* routine, Span<VariableType>* slots, Span<Stmt*> decl_stmts, Stmt* body);
+	void FindRecursion(); // cycles of the call graph, callables get listed callees first
+	bool Inlinable(const Routine* callee) const;
+	InlinedCallStmt* Expand(const Routine* callee, uint32_t depth, Span<Expr*> arguments);
+
+	Arena& arena; // copies go in here
+	size_t budget; // nodes a body may have to get copied
+	bool collecting = false; // first walk only builds the call graph
+	std::vector<Callable> callables; // program is the first one
+	std::unordered_map<const Routine*, uint32_t> indices; // into callables
+	std::vector<uint32_t> order; // callables, every one after those it calls (unless they call it back)
+	uint32_t current = 0; // callable whose body is being walked
+	std::vector<VariableType> frame; // slots of current while its body gets rewritten
+	Expr* inlined_expr = nullptr; // replacement of the node just visited
+	Stmt* inlined_stmt = nullptr;
+};
+
+#endif // !INLINER_HPP
@@ -1,86 +1,86 @@
+#include <algorithm>
+#include <array>
+#include <climits>
+#include <cstdint>
+#include <functional>
 #include <variant>
 
 #include "Interpreter.hpp"
 #include "Error.hpp"
 
-Interpreter::Interpreter() : global_env(std::make_shared<Environment>()), current_env(global_env) {};
+Interpreter::Interpreter() {};
 
-void Interpreter::Interpret(std::unique_ptr<Stmt> stmt)
+void Interpreter::Interpret(Stmt* stmt)
 {
 	stmt->Accept(*this);
 }
 
+Literal Interpreter::Evaluate(Expr* expr)
+{
+	return expr->Accept(*this);
+}
+
 
 Literal Interpreter::Visit(BinaryExpr& binExpr)
 {
+	if (binExpr.short_circuit)
+	{
+		return ShortCircuit(binExpr);
+	}
 	Literal left_value = binExpr.left->Accept(*this);
 	Literal right_value = binExpr.right->Accept(*this);
 
-	// operations on integers
-	if (IsInt(left_value) && IsInt(right_value))
+	// operand types got checked by the resolver -> only the operator is dispatched on
+	switch (binExpr.op)
 	{
-		switch (binExpr.op.type)
+	case TokenType::PLUS:
+		if (binExpr.type == VariableType::STRING) // string concat
 		{
-		case TokenType::PLUS:
-			return std::get<int>(left_value) + std::get<int>(right_value);
-		case TokenType::MINUS:
-			return std::get<int>(left_value) - std::get<int>(right_value);
-		case TokenType::MUL:
-			return std::get<int>(left_value) * std::get<int>(right_value);
-		case TokenType::DIV:
-			if (std::get<int>(right_value) == 0)
-			{
-				throw Error(binExpr.op.line_num,"division by zero.");
-			}
-			return std::get<int>(left_value) / std::get<int>(right_value);
-		case TokenType::GREATER_EQUAL:
-			return std::get<int>(left_value) >= std::get<int>(right_value);
-		case TokenType::GREATER:
-			return std::get<int>(left_value) > std::get<int>(right_value);
-		case TokenType::LESS_EQUAL:
-			return std::get<int>(left_value) <= std::get<int>(right_value);
-		case TokenType::LESS:
-			return std::get<int>(left_value) < std::get<int>(right_value);
-		default:
-			break;
+			return std::move(AsString(left_value)) + AsString(right_value);
 		}
-	}
-
-	// string concat on + op
-	if (IsString(left_value) && IsString(right_value) && binExpr.op.type == TokenType::PLUS) 
-	{
-		return std::get<std::string>(left_value) + std::get<std::string>(right_value);
-	}
-
-	// (in)equality operators
-	if (left_value.index() == right_value.index()) // (in)equality only for same types
-	{
-		switch (binExpr.op.type)
+		return AsInt(left_value) + AsInt(right_value);
+	case TokenType::MINUS:
+		return AsInt(left_value) - AsInt(right_value);
+	case TokenType::MUL:
+		return AsInt(left_value) * AsInt(right_value);
+	case TokenType::DIV:
+		if (!binExpr.proven && AsInt(right_value) == 0)
 		{
-		case TokenType::EQUAL:
-			return left_value == right_value;
-		case TokenType::NOT_EQUAL:
-			return left_value != right_value;
-		default:
-			break;
+			throw Error(binExpr.loc,"division by zero.");
 		}
+		return AsInt(left_value) / AsInt(right_value);
+	case TokenType::GREATER_EQUAL:
+		return AsInt(left_value) >= AsInt(right_value);
+	case TokenType::GREATER:
+		return AsInt(left_value) > AsInt(right_value);
+	case TokenType::LESS_EQUAL:
+		return AsInt(left_value) <= AsInt(right_value);
+	case TokenType::LESS:
+		return AsInt(left_value) < AsInt(right_value);
+	case TokenType::EQUAL: // same types on both sides
+		return left_value == right_value;
+	case TokenType::NOT_EQUAL:
+		return left_value != right_value;
+	case TokenType::AND:
+		return AsBool(left_value) && AsBool(right_value);
+	case TokenType::OR:
+		return AsBool(left_value) || AsBool(right_value);
+	default:
+		break;
 	}
 
-	// boolean operators and, or
-	if (IsBool(left_value) && IsBool(right_value)) // compare only bools
+	throw Error(binExpr.loc, "types incompatible with given operator.");
+}
+
+// and, or in a {$B-} region -> right operand only if the left one does not decide
+Literal Interpreter::ShortCircuit(BinaryExpr& binExpr)
+{
+	Literal left_value = binExpr.left->Accept(*this);
+	if (AsBool(left_value) == (binExpr.op == TokenType::OR)) // true or ..., false and ...
 	{
-		switch (binExpr.op.type)
-		{
-		case TokenType::AND:
-			return std::get<bool>(left_value) && std::get<bool>(right_value);
-		case TokenType::OR:
-			return std::get<bool>(left_value) || std::get<bool>(right_value);
-		default:
-			break;
-		}
+		return left_value;
 	}
-
-	throw Error(binExpr.op.line_num, "types incompatible with given operator.");
+	return binExpr.right->Accept(*this);
 }
 
 Literal Interpreter::Visit(LiteralExpr& litExpr)
@@ -92,27 +92,19 @@ Literal Interpreter::Visit(UnaryExpr& unExpr)
 {
 	Literal right_value = unExpr.right->Accept(*this);
 
-	// + and - only on integers
-	if (IsInt(right_value))
+	switch (unExpr.op)
 	{
-		switch (unExpr.op.type)
-		{
-		case TokenType::MINUS:
-			return -std::get<int>(right_value);
-		case TokenType::PLUS:
-			return std::get<int>(right_value);
-		default:
-			break;
-		}
-	}
-
-	// NOT only on booleans
-	if (IsBool(right_value) && unExpr.op.type == TokenType::NOT)
-	{
-		return !std::get<bool>(right_value);
+	case TokenType::MINUS:
+		return -AsInt(right_value);
+	case TokenType::PLUS:
+		return AsInt(right_value);
+	case TokenType::NOT:
+		return !AsBool(right_value);
+	default:
+		break;
 	}
 	
-	throw Error(unExpr.op.line_num, "type incompatible with given operator.");
+	throw Error(unExpr.loc, "type incompatible with given operator.");
 }
 
 Literal Interpreter::Visit(GroupingExpr& grExpr)
@@ -123,92 +115,40 @@ Literal Interpreter::Visit(GroupingExpr& grExpr)
 Literal Interpreter::Visit(VariableExpr& varExpr)
 {
 	// function without parameters
-	if (Environment::IsCallable(current_env->Get(varExpr.token))) 
+	if (varExpr.callee != nullptr)
 	{
-		auto&& callable = current_env->GetCallable(varExpr.token);
-
-		// move to local env for execution while remembering the previous one
-		auto prev_env = current_env;
-		current_env = callable->local_env;
-
-		// body execution
-		callable->body->Accept(*this);
-
-		// go back to previous environment (caller's one)
-		current_env = prev_env;
-
-		return callable->local_env->GetLiteral(varExpr.token);
+		return Call(*varExpr.callee, varExpr.address.depth, Span<Expr*>());
 	}
 
 	// literal
-	return current_env->GetLiteral(varExpr.token);
+	return current_env->Get(varExpr.address);
 }
 
 Literal Interpreter::Visit(FunctionCallExpr& funcCallExpr)
 {
-	stack_count++;
-	CheckStackOverflow();
-
-	std::vector<Literal> arguments;
-
-	// evaluate all expressions to literals
-	for (auto&& expr : funcCallExpr.exprs)
+	if (funcCallExpr.tail)
 	{
-		arguments.push_back(expr->Accept(*this));
+		TailCall(funcCallExpr.exprs);
+		return nullptr; // goes to the result, which gets reset before the body runs again
 	}
+	return Call(*funcCallExpr.callee, funcCallExpr.depth, funcCallExpr.exprs);
+}
 
-	// get callable by id
-	auto&& callable = current_env->GetCallable(funcCallExpr.id_token);
-
-	// remember current env
-	std::shared_ptr<Environment> prev_env = current_env;
-
-	std::shared_ptr<Environment> local_env = std::make_shared<Environment>(current_env);
-	callable->local_env = local_env; // pass local env to callable
-	current_env = local_env;
-
-	// execute declarations
-	for (auto&& declStmt : callable->declarations)
-	{
-		declStmt->Accept(*this);
-	}
-
-	// define parameters variables in local env
-	for (auto&& [var, type] : callable->parameters)
-	{
-		current_env->Define(var, type);
-	}
-
-	// define variable that will serve as return (value in it will be returned), id same as func id
-	current_env->Define(funcCallExpr.id_token, callable->return_type.value());
-
-	// pass arguments to callable -> arity, type check and arguments assignment happens over there
-	callable->PassArguments(arguments, funcCallExpr.id_token);
-
-	// body execution
-	callable->body->Accept(*this);
-
-	// return value -> need to get it before exiting enviornment
-	Literal return_value = current_env->GetLiteral(funcCallExpr.id_token);
-
-	// go back to previous environment (caller's one)
-	current_env = prev_env;
-
-	// return 
-	stack_count--;
-	return return_value;
+Literal Interpreter::Visit(InlinedCallExpr& inlinedCallExpr)
+{
+	Visit(*inlinedCallExpr.call);
+	return std::move(current_env->Get({ 0, inlinedCallExpr.result }));
 }
 
 void Interpreter::Visit(ProgramStmt& programStmt)
 {
-	// first interpret all declarations
-	for (auto&& declStmt : programStmt.decl_stmts)
-	{
-		declStmt->Accept(*this);
-	}
+	// global variables, declarations got resolved already
+	Environment global_env(programStmt.slots, nullptr);
+	current_env = &global_env;
 
 	// then compound statement
 	programStmt.stmt->Accept(*this);
+	current_env = nullptr;
 }
 
 void Interpreter::Visit(WritelnStmt& writelnStmt)
@@ -234,119 +174,76 @@ void Interpreter::Visit(CompoundStmt& compoundStmt)
 
 void Interpreter::Visit([[maybe_unused]] EmptyStmt& emptyStmt) {} // do nothing
 
-void Interpreter::Visit(VarDeclStmt& varDeclStmt)
-{
-	// define all variables
-	for (auto&& [type, identifiers] : varDeclStmt.variables)
-	{
-		for (auto&& identifier : identifiers)
-		{
-			current_env->Define(identifier, type);
-		}
-	}
-}
-
-void Interpreter::Visit(FuncDeclStmt& funcDeclStmt)
-{
-	// make callable 
-	auto&& callable = Callable(std::move(funcDeclStmt.body), std::move(funcDeclStmt.decl_stmts), funcDeclStmt.parameters, funcDeclStmt.return_type);
-
-	// define function by id in current env
-	current_env->Define(funcDeclStmt.id_token, std::move(callable));
-}
+// declarations are laid out by the resolver -> nothing to do when they are reached
+void Interpreter::Visit([[maybe_unused]] VarDeclStmt& varDeclStmt) {}
 
-void Interpreter::Visit(ProcDeclStmt& procDeclStmt)
-{
-	// make callable 
-	auto&& callable = Callable(std::move(procDeclStmt.body), std::move(procDeclStmt.decl_stmts), procDeclStmt.parameters, std::nullopt);
+void Interpreter::Visit([[maybe_unused]] FuncDeclStmt& funcDeclStmt) {}
 
-	// define procedure by id in current env
-	current_env->Define(procDeclStmt.id_token, std::move(callable));
-}
+void Interpreter::Visit([[maybe_unused]] ProcDeclStmt& procDeclStmt) {}
 
 void Interpreter::Visit(ProcedureCallStmt& procCallStmt)
 {
-	stack_count++;
-	CheckStackOverflow();
-
-	std::vector<Literal> arguments;
-
-	// evaluate all expressions to literals
-	for (auto&& expr : procCallStmt.arguments)
+	if (procCallStmt.tail)
 	{
-		arguments.push_back(expr->Accept(*this));
+		TailCall(procCallStmt.arguments);
+		return;
 	}
+	Call(*procCallStmt.callee, procCallStmt.depth, procCallStmt.arguments);
+}
 
-	// get callable by id
-	auto&& callable = current_env->GetCallable(procCallStmt.id_token);
-
-	// remember current env
-	std::shared_ptr<Environment> prev_env = current_env;
-
-	std::shared_ptr<Environment> local_env = std::make_shared<Environment>(current_env);
-	callable->local_env = local_env; // pass local env to callable
-	current_env = local_env;
-
-	// interpret all declarations in procedure object
-	for (auto&& declStmt : callable->declarations)
+// body got copied in with its slots moved into the current environment -> no environment of its own, counts as a call though
+void Interpreter::Visit(InlinedCallStmt& inlinedCallStmt)
+{
+	int counted = inlinedCallStmt.stack_check ? 1 : 0; // {$S-} -> does not count against the limit
+	stack_count += counted;
+	if (inlinedCallStmt.stack_check)
 	{
-		declStmt->Accept(*this);
+		CheckStackOverflow();
 	}
 
-	// define parameters variables in local env
-	for (auto&& [var, type] : callable->parameters)
+	for (uint32_t i = 0; i < inlinedCallStmt.arguments.size(); i++)
 	{
-		current_env->Define(var, type);
+		current_env->Get({ 0, inlinedCallStmt.base + i }) = inlinedCallStmt.arguments[i]->Accept(*this);
 	}
+	size_t parameter_count = inlinedCallStmt.arguments.size();
+	current_env->Reset(inlinedCallStmt.base + static_cast<uint32_t>(parameter_count),
+		Span<VariableType>(inlinedCallStmt.slots.begin() + parameter_count, inlinedCallStmt.slots.size() - parameter_count));
 
-	// pass arguments to callable -> arity, type check and arguments assignment happens over there
-	callable->PassArguments(arguments, procCallStmt.id_token);
-
-	// body execution
-	callable->body->Accept(*this);
-
-	// go back to previous environment (caller's one)
-	current_env = prev_env;
-	stack_count--;
+	inlinedCallStmt.body->Accept(*this);
+	stack_count -= counted;
 }
 
 void Interpreter::Visit(AssignmentStmt& assignmentStmt)
 {
-	current_env->Assign(assignmentStmt.token, assignmentStmt.value->Accept(*this));
+	Literal value = assignmentStmt.value->Accept(*this);
+	current_env->Get(assignmentStmt.address) = std::move(value); // same type, checked by the resolver
 }
 
 void Interpreter::Visit(IfStmt& ifStmt)
 {
 	Literal condition_value = ifStmt.condition->Accept(*this);
 
-	if (IsBool(condition_value))
+	if (AsBool(condition_value))
 	{
-		if (std::get<bool>(condition_value))
-		{
-			ifStmt.then_branch->Accept(*this);
-		}
-		else if (ifStmt.else_branch.has_value())
-		{
-			ifStmt.else_branch.value()->Accept(*this);
-		}
-		return; 
+		ifStmt.then_branch->Accept(*this);
+	}
+	else if (ifStmt.else_branch != nullptr)
+	{
+		ifStmt.else_branch->Accept(*this);
 	}
-	throw Error(ifStmt.token.line_num, "expected boolean value.");
 }
 
 void Interpreter::Visit(WhileStmt& whileStmt)
 {
-	Literal condition_value = whileStmt.condition->Accept(*this);
-
-	if (IsBool(condition_value))
+	while (true)
 	{
-		while (std::get<bool>(whileStmt.condition->Accept(*this))) // note: need to Accept visitor like this because of environment change
+		Literal condition_value = whileStmt.condition->Accept(*this);
+		if (!AsBool(condition_value))
 		{
-			whileStmt.body->Accept(*this);
+			return;
 		}
-		return;
+		whileStmt.body->Accept(*this);
 	}
-	throw Error(whileStmt.token.line_num, "expected boolean value.");
 }
 
 void Interpreter::Visit(ForStmt& forStmt)
@@ -356,31 +253,107 @@ void Interpreter::Visit(ForStmt& forStmt)
 
 	forStmt.assignment->Accept(*this); // assign init value of iterator variable
 
-	Literal& initial_value = current_env->GetLiteral(forStmt.id_token);
+	int& counter = AsInt(current_env->Get(forStmt.address)); // body cannot move it, nor change its type
+	int limit = AsInt(expression_value);
 
-	// check types and desugar to while cycle
-	if (IsInt(expression_value) && IsInt(initial_value))
+	// counting past the limit would overflow -> only then the body has to run one iteration at a time
+	if (forStmt.closed_form && limit != (forStmt.increment ? INT_MAX : INT_MIN))
+	{
+		RunClosedForm(forStmt, counter, limit);
+		return;
+	}
+	if (!forStmt.inductions.empty())
 	{
-		if (forStmt.increment)
+		RunInductions(forStmt, counter, limit);
+		return;
+	}
+
+	// desugar to while cycle
+	if (forStmt.increment)
+	{
+		while (counter <= limit)
 		{
-			while (std::get<int>(current_env->GetLiteral(forStmt.id_token)) <= std::get<int>(expression_value))
+			forStmt.body->Accept(*this);
+			counter = counter + 1;
+		}
+	}
+	else // decrement
+	{
+		while (counter >= limit)
+		{
+			forStmt.body->Accept(*this);
+			counter = counter - 1;
+		}
+	}
+}
+
+// arithmetic modulo 2^32 -> same results as the additions and multiplications of every iteration, overflows included
+void Interpreter::RunClosedForm(ForStmt& forStmt, int& counter, int limit)
+{
+	int first = forStmt.increment ? counter : limit;
+	int last = forStmt.increment ? limit : counter;
+	if (first > last)
+	{
+		return;
+	}
+
+	// sum of first .. last, one of the factors is even and gets halved exactly
+	int64_t count = static_cast<int64_t>(last) - first + 1;
+	int64_t ends = static_cast<int64_t>(first) + last;
+	uint32_t counter_sum = count % 2 == 0
+		? static_cast<uint32_t>(count / 2) * static_cast<uint32_t>(ends)
+		: static_cast<uint32_t>(count) * static_cast<uint32_t>(ends / 2);
+
+	for (auto&& reduction : forStmt.reductions)
+	{
+		Literal coefficient = reduction.coefficient->Accept(*this);
+		Literal constant = reduction.constant->Accept(*this);
+		int& target = AsInt(current_env->Get(reduction.target));
+		target = static_cast<int>(static_cast<uint32_t>(target)
+			+ static_cast<uint32_t>(AsInt(coefficient)) * counter_sum
+			+ static_cast<uint32_t>(AsInt(constant)) * static_cast<uint32_t>(count));
+	}
+	counter = forStmt.increment ? last + 1 : first - 1;
+}
+
+// products start from the initial value of the counter and follow it by additions of steps evaluated once
+void Interpreter::RunInductions(ForStmt& forStmt, int& counter, int limit)
+{
+	std::array<int*, ForStmt::max_inductions> products;
+	std::array<uint32_t, ForStmt::max_inductions> steps;
+	size_t count = forStmt.inductions.size();
+	for (size_t i = 0; i < count; i++)
+	{
+		Literal step = forStmt.inductions[i].step->Accept(*this);
+		steps[i] = static_cast<uint32_t>(AsInt(step));
+		products[i] = &AsInt(current_env->Get({ 0, forStmt.inductions[i].slot })); // only the loop writes it
+		*products[i] = static_cast<int>(static_cast<uint32_t>(counter) * steps[i]);
+	}
+
+	if (forStmt.increment)
+	{
+		while (counter <= limit)
+		{
+			forStmt.body->Accept(*this);
+			counter = counter + 1;
+			for (size_t i = 0; i < count; i++)
 			{
-				forStmt.body->Accept(*this);
-				current_env->Assign(forStmt.id_token, std::get<int>(current_env->GetLiteral(forStmt.id_token)) + 1);
+				*products[i] = static_cast<int>(static_cast<uint32_t>(*products[i]) + steps[i]);
 			}
-			return;
 		}
-		else // decrement
+	}
+	else // decrement
+	{
+		while (counter >= limit)
 		{
-			while (std::get<int>(current_env->GetLiteral(forStmt.id_token)) >= std::get<int>(expression_value))
+			forStmt.body->Accept(*this);
+			counter = counter - 1;
+			for (size_t i = 0; i < count; i++)
 			{
-				forStmt.body->Accept(*this);
-				current_env->Assign(forStmt.id_token, std::get<int>(current_env->GetLiteral(forStmt.id_token)) - 1);
+				*products[i] = static_cast<int>(static_cast<uint32_t>(*products[i]) - steps[i]);
 			}
-			return;
 		}
 	}
-	throw Error(forStmt.for_token.line_num, "expected integer value.");
 }
 
 
@@ -400,6 +373,22 @@ bool Interpreter::IsString(Literal& lit)
 	return lit.index() == 3;
 }
 
+// alternative the resolver proved -> get_if cannot give nullptr, so the compiler can drop the index check that std::get does
+int& Interpreter::AsInt(Literal& lit)
+{
+	return *std::get_if<int>(&lit);
+}
+
+bool& Interpreter::AsBool(Literal& lit)
+{
+	return *std::get_if<bool>(&lit);
+}
+
+std::string& Interpreter::AsString(Literal& lit)
+{
+	return *std::get_if<std::string>(&lit);
+}
+
 
 // convert literal to string representation for writeln statement (C++ print 0 on false etc.)
 std::string Interpreter::LitToString(Literal& lit) 
@@ -421,10 +410,155 @@ std::string Interpreter::LitToString(Literal& lit)
 }
 
 
+// arguments get evaluated in the caller's environment, body runs in a new one enclosed by the one callee was declared in
+Literal Interpreter::Call(Routine& callee, uint32_t depth, Span<Expr*> arguments)
+{
+	int counted = callee.stack_check ? 1 : 0; // {$S-} -> does not count against the limit
+	stack_count += counted;
+	if (callee.stack_check)
+	{
+		CheckStackOverflow();
+	}
+
+	Environment* enclosing_env = current_env;
+	for (uint32_t i = 0; i < depth; i++)
+	{
+		enclosing_env = enclosing_env->enclosing_env;
+	}
+
+	// layout is final once the program runs -> zero values get built on the first call only (the resolver clears them
+	// when it lays the routine out again), copied into memory of an ended call
+	if (callee.frame.size() != callee.slots.size())
+	{
+		callee.frame = Environment::Zeros(callee.slots);
+	}
+	std::vector<Literal> values;
+	if (!spare_values.empty())
+	{
+		values = std::move(spare_values.back());
+		spare_values.pop_back();
+	}
+	values.assign(callee.frame.begin(), callee.frame.end());
+	Environment local_env(std::move(values), enclosing_env);
+
+	// parameters are the first slots -> arguments go right in, arity and types got checked by the resolver
+	for (uint32_t i = 0; i < arguments.size(); i++)
+	{
+		local_env.Get({ 0, i }) = arguments[i]->Accept(*this);
+	}
+
+	// pure function called with these arguments before -> same result, same calls made on the way
+	Memo* memo = callee.pure ? &memos[&callee] : nullptr;
+	std::vector<Literal> key;
+	int outer_deepest = deepest;
+	if (memo != nullptr && memo->counters.off)
+	{
+		memo = nullptr;
+	}
+	if (memo != nullptr)
+	{
+		for (uint32_t i = 0; i < arguments.size(); i++)
+		{
+			key.push_back(local_env.Get({ 0, i }));
+		}
+		auto found = memo->results.find(key);
+		if (found != memo->results.end())
+		{
+			memo->counters.hits++;
+			if (stack_count + found->second.depth > max_stack_count)
+			{
+				throw Error(0, "stack overflow.");
+			}
+			deepest = std::max(deepest, stack_count + found->second.depth);
+			stack_count -= counted;
+			spare_values.push_back(local_env.Release());
+			return found->second.result;
+		}
+		memo->counters.misses++;
+		if (memo->counters.misses == memo_trial && memo->counters.hits < memo_trial / 8)
+		{
+			memo->counters.off = true;
+			memo->results.clear();
+		}
+		deepest = stack_count;
+	}
+
+	// move to local env for execution while remembering the previous one
+	Environment* prev_env = current_env;
+	current_env = &local_env;
+
+	// body execution, again as long as it ends by calling itself
+	callee.body->Accept(*this);
+	while (tail_call)
+	{
+		tail_call = false;
+		size_t parameter_count = callee.parameter_count;
+		local_env.Reset(callee.parameter_count, Span<VariableType>(callee.slots.begin() + parameter_count, callee.slots.size() - parameter_count));
+		auto first = tail_arguments.end() - parameter_count;
+		for (uint32_t i = 0; i < parameter_count; i++)
+		{
+			local_env.Get({ 0, i }) = std::move(first[i]);
+		}
+		tail_arguments.erase(first, tail_arguments.end());
+		callee.body->Accept(*this);
+	}
+
+	// go back to previous environment (caller's one)
+	current_env = prev_env;
+
+	if (memo != nullptr)
+	{
+		if (memo->results.size() == max_memo_size)
+		{
+			memo->results.clear();
+		}
+		if (!memo->counters.off)
+		{
+			Memoized& memoized = memo->results[std::move(key)];
+			memoized.result = local_env.Get({ 0, callee.parameter_count });
+			memoized.depth = deepest - stack_count;
+		}
+		deepest = std::max(outer_deepest, deepest);
+	}
+	stack_count -= counted;
+
+	// return variable follows the parameters
+	Literal result = callee.is_function ? std::move(local_env.Get({ 0, callee.parameter_count })) : Literal();
+	spare_values.push_back(local_env.Release());
+	return result;
+}
+
+// arguments wait on top of the others (calls within them take theirs first), the call being run picks them up
+void Interpreter::TailCall(Span<Expr*> arguments)
+{
+	for (auto&& expr : arguments)
+	{
+		tail_arguments.push_back(expr->Accept(*this));
+	}
+	tail_call = true;
+}
+
 void Interpreter::CheckStackOverflow()
 {
+	deepest = std::max(deepest, stack_count);
 	if (stack_count > max_stack_count)
 	{
 		throw Error(0, "stack overflow.");
 	}
 }
+
+Interpreter::MemoCounters Interpreter::Counters(const Routine* routine) const
+{
+	auto found = memos.find(routine);
+	return found != memos.end() ? found->second.counters : MemoCounters();
+}
+
+size_t Interpreter::ArgumentsHash::operator()(const std::vector<Literal>& arguments) const
+{
+	size_t hash = arguments.size();
+	for (auto&& argument : arguments)
+	{
+		hash = hash * 31 + std::hash<Literal>()(argument);
+	}
+	return hash;
+}
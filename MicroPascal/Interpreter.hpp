@@ -1,7 +1,8 @@
 #ifndef INTERPRETER_HPP
 #define INTERPRETER_HPP
 
-#include <memory>
+#include <cstdint>
+#include <unordered_map>
 #include <vector>
 
 #include "Expr.hpp"
@@ -13,7 +14,18 @@ class Interpreter : public VisitorExpr, public VisitorStmt
 public:
 	Interpreter();
 
-	void Interpret(std::unique_ptr<Stmt> stmt);
+	void Interpret(Stmt* stmt);
+	Literal Evaluate(Expr* expr); // one without variables and calls -> optimizer folds with the same semantics
+
+	// calls of a pure function answered from its memo and those that ran its body
+	struct MemoCounters
+	{
+		uint64_t hits = 0;
+		uint64_t misses = 0;
+		bool off = false; // gave up on remembering
+	};
+
+	MemoCounters Counters(const Routine* routine) const;
 
 private:
 	Literal Visit(BinaryExpr& binExpr) override;
@@ -22,6 +34,7 @@ private:
 	Literal Visit(GroupingExpr& grExpr) override;
 	Literal Visit(VariableExpr& varExpr) override;
 	Literal Visit(FunctionCallExpr& funcCallExpr) override;
+	Literal Visit(InlinedCallExpr& inlinedCallExpr) override;
 
 	void Visit(ProgramStmt& programStmt) override;
 	void Visit(WritelnStmt& writelnStmt) override;
@@ -35,20 +48,57 @@ private:
 	void Visit(IfStmt& ifStmt) override;
 	void Visit(WhileStmt& whileStmt) override;
 	void Visit(ForStmt& whileStmt) override;
+	void Visit(InlinedCallStmt& inlinedCallStmt) override;
 
 	static bool IsInt(Literal& lit);
 	static bool IsString(Literal& lit);
 	static bool IsBool(Literal& lit);
 
+	static int& AsInt(Literal& lit);
+	static bool& AsBool(Literal& lit);
+	static std::string& AsString(Literal& lit);
+
 	std::string LitToString(Literal& lit);
 
+	void RunClosedForm(ForStmt& forStmt, int& counter, int limit);
+	void RunInductions(ForStmt& forStmt, int& counter, int limit);
+
+	Literal Call(Routine& callee, uint32_t depth, Span<Expr*> arguments);
+	void TailCall(Span<Expr*> arguments);
+	Literal ShortCircuit(BinaryExpr& binExpr);
 	void CheckStackOverflow();
 
-	std::shared_ptr<Environment> global_env;
-	std::shared_ptr<Environment> current_env;
+	// result of a call and how much deeper than the call itself it went
+	struct Memoized
+	{
+		Literal result;
+		int depth = 0;
+	};
+
+	struct ArgumentsHash
+	{
+		size_t operator()(const std::vector<Literal>& arguments) const;
+	};
+
+	struct Memo
+	{
+		std::unordered_map<std::vector<Literal>, Memoized, ArgumentsHash> results;
+		MemoCounters counters; // off -> arguments hardly ever repeat, remembering costs more than it saves
+	};
+
+	Environment* current_env = nullptr; // environments live on the C++ stack -> a call outlives every one it creates
+	std::vector<std::vector<Literal>> spare_values; // of environments that ended -> a call allocates nothing once they are there
+
+	std::vector<Literal> tail_arguments; // of tail calls made, not picked up yet
+	bool tail_call = false; // body just made one
 
 	int stack_count = 0;
+	int deepest = 0; // stack_count reached since the outermost memoized call that is running began
 	const int max_stack_count = 256;
+
+	std::unordered_map<const Routine*, Memo> memos; // of pure functions
+	static constexpr size_t max_memo_size = 1 << 16; // results per function, full -> starts over
+	static constexpr uint64_t memo_trial = 1 << 12; // misses after which a memo has to have paid off
 };
 
 #endif // !INTERPRETER_HPP
\ No newline at end of file
@@ -0,0 +1,141 @@
+#ifndef KEYWORDS_HPP
+#define KEYWORDS_HPP
+
+#include <array>
+#include <string_view>
+#include <utility>
+
+#include "TokenType.hpp"
+
+// reserved words, looked up by a perfect hash that is found and checked at compile time
+// -> one probe, one compare, no allocation and no per-lexer table
+class Keywords
+{
+public:
+	// TokenType::ID if lexeme is not a reserved word, case insensitive
+	static TokenType Lookup(std::string_view lexeme)
+	{
+		if (lexeme.size() < min_length || lexeme.size() > max_length)
+		{
+			return TokenType::ID;
+		}
+
+		const Entry& entry = table[Hash(lexeme, multipliers.first, multipliers.second)];
+		if (entry.word.size() != lexeme.size())
+		{
+			return TokenType::ID;
+		}
+
+		// lexeme is an identifier ([A-Za-z0-9_]) -> '| 0x20' lowercases letters and never turns other chars into letters
+		for (size_t i = 0; i < lexeme.size(); i++)
+		{
+			if ((lexeme[i] | 0x20) != entry.word[i])
+			{
+				return TokenType::ID;
+			}
+		}
+		return entry.type;
+	}
+
+private:
+	struct Entry
+	{
+		std::string_view word;
+		TokenType type;
+	};
+
+	static constexpr Entry words[] =
+	{
+		{"program", TokenType::PROGRAM},
+		{"begin", TokenType::BEGIN},
+		{"end", TokenType::END},
+		{"var", TokenType::VAR},
+		{"true", TokenType::TRUE},
+		{"false", TokenType::FALSE},
+		{"and", TokenType::AND},
+		{"or", TokenType::OR},
+		{"not", TokenType::NOT},
+		{"for", TokenType::FOR},
+		{"to", TokenType::TO},
+		{"downto", TokenType::DOWNTO},
+		{"do", TokenType::DO},
+		{"while", TokenType::WHILE},
+		{"if", TokenType::IF},
+		{"then", TokenType::THEN},
+		{"else", TokenType::ELSE},
+		{"procedure", TokenType::PROCEDURE},
+		{"function", TokenType::FUNCTION},
+		{"writeln", TokenType::WRITELN},
+		{"string", TokenType::STRING_TYPE},
+		{"integer", TokenType::INTEGER_TYPE},
+		{"boolean", TokenType::BOOL_TYPE},
+		{"div", TokenType::DIV}
+	};
+
+	static constexpr size_t min_length = 2;
+	static constexpr size_t max_length = 9;
+	static constexpr size_t table_size = 64; // power of two
+
+	// length and first/last char mixed by two multipliers
+	static constexpr size_t Hash(std::string_view word, unsigned first, unsigned last)
+	{
+		return (word.size() + static_cast<unsigned>(word.front() | 0x20) * first + static_cast<unsigned>(word.back() | 0x20) * last) & (table_size - 1);
+	}
+
+	static constexpr bool IsPerfect(unsigned first, unsigned last)
+	{
+		bool used[table_size] = {};
+		for (const Entry& entry : words)
+		{
+			size_t slot = Hash(entry.word, first, last);
+			if (used[slot])
+			{
+				return false;
+			}
+			used[slot] = true;
+		}
+		return true;
+	}
+
+	// smallest multipliers without collisions, compilation fails if there are none
+	static constexpr std::pair<unsigned, unsigned> FindMultipliers()
+	{
+		for (unsigned first = 1; first < 32; first++)
+		{
+			for (unsigned last = 1; last < 32; last++)
+			{
+				if (IsPerfect(first, last))
+				{
+					return { first, last };
+				}
+			}
+		}
+		throw "no perfect hash for keywords, change Hash() or table_size";
+	}
+
+	static constexpr std::array<Entry, table_size> BuildTable()
+	{
+		std::array<Entry, table_size> built{};
+		for (size_t i = 0; i < table_size; i++)
+		{
+			built[i] = { std::string_view(), TokenType::ID }; // empty word never matches
+		}
+		for (const Entry& entry : words)
+		{
+			if (entry.word.size() < min_length || entry.word.size() > max_length)
+			{
+				throw "keyword length out of [min_length, max_length]";
+			}
+			built[Hash(entry.word, multipliers.first, multipliers.second)] = entry;
+		}
+		return built;
+	}
+
+	static const std::pair<unsigned, unsigned> multipliers;
+	static const std::array<Entry, table_size> table;
+};
+
+inline constexpr std::pair<unsigned, unsigned> Keywords::multipliers = Keywords::FindMultipliers();
+inline constexpr std::array<Keywords::Entry, Keywords::table_size> Keywords::table = Keywords::BuildTable();
+
+#endif // !KEYWORDS_HPP
@@ -1,36 +1,65 @@
-#include <algorithm>
-
 #include "Lexer.hpp"
 #include "Error.hpp"
+#include "CharScan.hpp"
+#include "Keywords.hpp"
 
-Lexer::Lexer(std::string m_text) : input(m_text) {}
+Lexer::Lexer(std::string_view m_text, SymbolTable& m_symbols) : Lexer(m_text, m_symbols, 1) {}
 
-std::vector<Token> Lexer::GetTokens()
+Lexer::Lexer(std::string_view m_text, SymbolTable& m_symbols, int m_first_line) : Lexer(m_text, m_symbols, m_first_line, SourceLoc()) {}
+
+Lexer::Lexer(std::string_view m_text, SymbolTable& m_symbols, int m_first_line, SourceLoc m_first_loc)
+    : input(m_text), symbols(m_symbols), line_num(m_first_line), loc_base(m_first_loc.offset)
+{
+    if (!input.empty())
+    {
+        curr_char = input[0];
+    }
+}
+
+// scans just enough input for one token -> parser pulls tokens one by one and memory does not grow with the input
+Token Lexer::NextToken()
 {
     while (!IsAtEnd())
     {
         start_pos = curr_pos;
         ScanToken();
+
+        if (scanned.has_value())
+        {
+            Token token = *scanned;
+            scanned.reset();
+            return token;
+        }
     }
-    tokens.push_back(Token(TokenType::END_OF_FILE, "", nullptr, line_num));
+    return Token(TokenType::END_OF_FILE, std::string_view(), line_num, SourceLoc{ static_cast<uint32_t>(loc_base + input.size()) });
+}
+
+std::vector<Token> Lexer::GetTokens()
+{
+    std::vector<Token> tokens;
+    do
+    {
+        tokens.push_back(NextToken());
+    } while (tokens.back().type != TokenType::END_OF_FILE);
     return tokens;
 }
 
 void Lexer::ScanToken()
 {
-    if (std::isspace(curr_char))
+    if (CharScan::IsSpace(curr_char))
     {
         SkipWhitespace();
         return;
     }
 
-    if (std::isdigit(curr_char))
+    if (CharScan::IsDigit(curr_char))
     {
-        AddToken(TokenType::INTEGER_VAL, Integer());
+        Integer();
+        AddToken(TokenType::INTEGER_VAL);
         return;
     }
 
-    if (std::isalpha(curr_char) || curr_char == '_')
+    if (CharScan::IsIdentStart(curr_char))
     {
         Identifier();
         return;
@@ -100,7 +129,8 @@ void Lexer::ScanToken()
         }
         break;
     case '\'': // '
-        AddToken(TokenType::STRING_VAL, String());
+        String();
+        AddToken(TokenType::STRING_VAL);
         break;
     case '{':
         SkipComment();
@@ -111,91 +141,58 @@ void Lexer::ScanToken()
     }
 }
 
-void Lexer::AddToken(TokenType type)
-{
-    AddToken(type, nullptr);
-}
-
-void Lexer::AddToken(TokenType type, Literal lit)
+// token is a view of [start_pos, curr_pos] in the input -> no allocation per token
+void Lexer::AddToken(TokenType type, SymbolId symbol)
 {
     Advance();
-    std::string lexeme = input.substr(start_pos, curr_pos - start_pos);
-    if (type == TokenType::ID)
-    {
-        // Pascal is case insensitive -> ID's lexeme gets converted to lower so it must not be done later (for looking up value etc.)
-        std::transform(lexeme.begin(), lexeme.end(), lexeme.begin(), [](unsigned char c) { return std::tolower(c); }); // transform to lower
-    }
-
-    tokens.push_back(Token(type, lexeme, lit, line_num));
+    scanned.emplace(type, input.substr(start_pos, curr_pos - start_pos), line_num, SourceLoc{ static_cast<uint32_t>(loc_base + start_pos) }, symbol);
 }
 
-int Lexer::Integer()
+// value gets computed by the parser from the lexeme
+void Lexer::Integer()
 {
-    int number = curr_char - '0'; // make int out of a char
-    while (curr_pos + 1 < input.size() && std::isdigit(input[curr_pos + 1]))
+    while (curr_pos + 1 < input.size() && CharScan::IsDigit(input[curr_pos + 1]))
     {
         Advance();
-        number = 10 * number + (curr_char - '0');
     }
-    return number;
 }
 
 void Lexer::Identifier()
 {
-    // advance while it's part of ID name
-    while (curr_pos + 1 < input.size() && (std::isalnum(input[curr_pos + 1]) || input[curr_pos + 1] == '_'))
-    {
-        Advance();
-    }
+    // move to the last char of ID name
+    MoveTo(CharScan::SkipIdentifier(input, curr_pos + 1) - 1);
 
-    // get lexeme and transform to lower
-    std::string lit_value = input.substr(start_pos, curr_pos - start_pos + 1); // + 1 -> need lit_value, in AddToken it will be advanced
-    std::transform(lit_value.begin(), lit_value.end(), lit_value.begin(), [](unsigned char c) { return std::tolower(c); }); // transform to lower
+    std::string_view lexeme = input.substr(start_pos, curr_pos - start_pos + 1); // + 1 -> in AddToken it will be advanced
 
-    // check for reserved keyword
-    if (reserved_keywords.find(lit_value) != reserved_keywords.end())
+    // check for reserved keyword -> such words will not be considered as identifiers
+    TokenType keyword = Keywords::Lookup(lexeme);
+    if (keyword != TokenType::ID)
     {
-        if (lit_value == "true")
-        {
-            AddToken(TokenType::TRUE, true);
-            return;
-        }
-
-        if (lit_value == "false")
-        {
-            AddToken(TokenType::FALSE, false);
-            return;
-        }
-
-        AddToken(reserved_keywords.at(lit_value));
+        AddToken(keyword);
         return;
     }
 
-    AddToken(TokenType::ID);
+    // Pascal is case insensitive -> all spellings of a name map to one symbol, nothing later compares strings
+    AddToken(TokenType::ID, symbols.Intern(lexeme));
 }
 
-std::string Lexer::String()
+void Lexer::String()
 {
-    // advance while it's part of the string
-    while (curr_pos + 1 < input.size() && input[curr_pos + 1] != '\'')
-    {
-        Advance();
-
-        // string cannot exceed line
-        if (curr_char == '\n')
-        {
-            throw Error(line_num, "string exceeds line.");
-        }
-    }
+    size_t end = CharScan::FindQuoteOrNewline(input, curr_pos + 1);
 
     // string has to be terminated by '
-    if (IsAtEnd())
+    if (end >= input.size())
     {
         throw Error(line_num, "string is not terminated.");
     }
 
-    Advance(); // skip second '
-    return input.substr(start_pos + 1, curr_pos - (start_pos + 1)); // +1's -> cut ' chars
+    // string cannot exceed line
+    if (input[end] == '\n')
+    {
+        throw Error(line_num, "string exceeds line.");
+    }
+
+    MoveTo(end); // skip second ' -> lexeme keeps both quotes, parser cuts them
 }
 
 // assign current char if not the end
@@ -208,10 +205,20 @@ void Lexer::Advance()
     }
 }
 
+// jump forward, curr_char is kept valid if not the end
+void Lexer::MoveTo(size_t pos)
+{
+    curr_pos = pos;
+    if (!IsAtEnd())
+    {
+        curr_char = input[curr_pos];
+    }
+}
+
 // check if next char matches with given one, advances if there is match
 bool Lexer::NextIsMatchWith(char next)
 {
-    if (IsAtEnd() || input[curr_pos + 1] != next)
+    if (curr_pos + 1 >= input.size() || input[curr_pos + 1] != next)
     {
         return false;
     }
@@ -223,43 +230,68 @@ bool Lexer::NextIsMatchWith(char next)
 
 void Lexer::SkipWhitespace()
 {
-    while (!IsAtEnd() && std::isspace(curr_char))
-    {
-        if (curr_char == '\n')
-        {
-            line_num++;
-        }
-        Advance();
-    }
+    MoveTo(CharScan::SkipWhitespace(input, curr_pos, line_num));
 }
 
 void Lexer::SkipComment()
 {
-    Advance(); // go past the first '{'
+    size_t pos = curr_pos + 1; // go past the first '{'
 
     int braces_count = 1; // +1 if see '{', -1 if see '}' -> allows nested comments
-    while (!IsAtEnd() && braces_count != 0) // skip comment
+    while (braces_count != 0) // skip comment, jumping from brace to brace
     {
-        if (curr_char == '\n')
-        {
-            line_num++;
-        }
-        else if (curr_char == '{')
-        {
-            braces_count++;
-        }
-        else if (curr_char == '}')
+        pos = CharScan::FindBrace(input, pos, line_num);
+
+        // comment must be terminated by '}'
+        if (pos >= input.size())
         {
-            braces_count--;
+            MoveTo(pos);
+            throw Error(line_num, "unexpected EOF."); // comment goes on until the EOF
         }
 
-        Advance();
+        braces_count += (input[pos] == '{') ? 1 : -1;
+        pos++;
     }
 
-    // comment must be terminated by '{'
-    if (IsAtEnd() && braces_count != 0)
+    MoveTo(pos);
+}
+
+void Lexer::ScanDirectives(std::string_view text, Directives& directives)
+{
+    if (text.find("{$") == std::string_view::npos) // usual case -> one pass of a fast search
     {
-        throw Error(line_num, "unexpected EOF."); // comment goes on until the EOF
+        return;
+    }
+
+    size_t pos = CharScan::FindCommentOrString(text, 0);
+    while (pos < text.size())
+    {
+        if (text[pos] == '\'')
+        {
+            pos = CharScan::FindQuoteOrNewline(text, pos + 1) + 1; // unterminated ones get reported by the lexer
+        }
+        else
+        {
+            size_t start = pos;
+            int newlines = 0;
+            int braces_count = 1; // nested comments, as in SkipComment
+            pos++;
+            while (braces_count != 0)
+            {
+                pos = CharScan::FindBrace(text, pos, newlines);
+                if (pos >= text.size())
+                {
+                    return;
+                }
+                braces_count += (text[pos] == '{') ? 1 : -1;
+                pos++;
+            }
+            if (text[start + 1] == '$')
+            {
+                directives.Add(SourceLoc{ static_cast<uint32_t>(pos) }, text.substr(start + 2, pos - 1 - (start + 2)));
+            }
+        }
+        pos = CharScan::FindCommentOrString(text, pos);
     }
 }
 
@@ -1,73 +1,56 @@
 #ifndef LEXER_HPP
 #define LEXER_HPP
 
+#include <optional>
 #include <string>
-#include <unordered_map>
+#include <string_view>
 #include <vector>
 
 #include "TokenType.hpp"
 #include "Token.hpp"
+#include "SymbolTable.hpp"
+#include "TokenSource.hpp"
+#include "Directives.hpp"
 
-class Lexer // lexical analysis, creates Tokens
+class Lexer : public TokenSource // lexical analysis, creates Tokens on demand
 {
 public:
-    Lexer(std::string m_text);
+    Lexer(std::string_view m_text, SymbolTable& m_symbols); // m_text has to outlive the lexer, nothing gets copied
+    Lexer(std::string_view m_text, SymbolTable& m_symbols, int m_first_line); // m_text may be just a part of the input
+    Lexer(std::string_view m_text, SymbolTable& m_symbols, int m_first_line, SourceLoc m_first_loc); // locations counted from m_first_loc
 
-    std::vector<Token> GetTokens();
+    Token NextToken() override;
+    std::vector<Token> GetTokens(); // whole rest of the input at once
+
+    // {$...} comments of a whole source -> no tokens, so that they are found the same way however the program gets parsed
+    static void ScanDirectives(std::string_view text, Directives& directives);
 
 private:
     void ScanToken();
 
-    void AddToken(TokenType type);
-    void AddToken(TokenType type, Literal lit);
+    void AddToken(TokenType type, SymbolId symbol = 0);
     
-    int Integer();
+    void Integer();
     void Identifier();
-    std::string String();
+    void String();
     
     void Advance();
+    void MoveTo(size_t pos);
     bool NextIsMatchWith(char next);
     void SkipWhitespace();
     void SkipComment();
     bool IsAtEnd();
 
-    std::string input;
-
-    // such words will not be considered as identifiers
-    const std::unordered_map<std::string, TokenType> reserved_keywords =
-    {
-        {"program", TokenType::PROGRAM},
-        {"begin", TokenType::BEGIN},
-        {"end", TokenType::END},
-        {"var", TokenType::VAR},
-        {"true", TokenType::TRUE},
-        {"false", TokenType::FALSE},
-        {"and", TokenType::AND},
-        {"or", TokenType::OR},
-        {"not", TokenType::NOT},
-        {"for", TokenType::FOR},
-        {"to", TokenType::TO},
-        {"downto", TokenType::DOWNTO},
-        {"do", TokenType::DO},
-        {"while", TokenType::WHILE},
-        {"if", TokenType::IF},
-        {"then", TokenType::THEN},
-        {"else", TokenType::ELSE},
-        {"procedure", TokenType::PROCEDURE},
-        {"function", TokenType::FUNCTION},
-        {"writeln", TokenType::WRITELN},
-        {"string", TokenType::STRING_TYPE},
-        {"integer", TokenType::INTEGER_TYPE},
-        {"boolean", TokenType::BOOL_TYPE},
-        {"div", TokenType::DIV}
-    };
+    std::string_view input;
+    SymbolTable& symbols; // identifiers get interned here
 
-    std::vector<Token> tokens;
+    std::optional<Token> scanned; // set by AddToken, ScanToken may also produce no token (whitespace, comment)
 
     int line_num = 1;
+    uint32_t loc_base = 0;
     size_t start_pos = 0; // starting position of current lexeme
     size_t curr_pos = 0;
-    char curr_char = input[curr_pos];
+    char curr_char = '\0';
 };
 
 #endif // !LEXER_HPP
@@ -0,0 +1,276 @@
+#include <algorithm>
+#include <utility>
+#include <variant>
+
+#include "LoopHoister.hpp"
+
+LoopHoister::LoopHoister(Arena& m_arena) : arena(m_arena) {}
+
+void LoopHoister::Hoist(Stmt* program)
+{
+	program->Accept(*this);
+}
+
+void LoopHoister::HoistRoutine(const Routine* routine, Span<VariableType>& slots, Span<Stmt*> decl_stmts, Stmt* body)
+{
+	chain.push_back(routine);
+	std::vector<VariableType> outer_frame = std::move(frame);
+
+	for (auto&& decl : decl_stmts)
+	{
+		decl->Accept(*this);
+	}
+
+	frame.assign(slots.begin(), slots.end());
+	body->Accept(*this); // compound statement -> never replaced, the routine keeps pointing to it
+	if (frame.size() > slots.size())
+	{
+		slots = arena.Copy(frame);
+	}
+
+	frame = std::move(outer_frame);
+	chain.pop_back();
+}
+
+void LoopHoister::HoistLoop(Stmt& loop, Expr** condition, Stmt*& body)
+{
+	if (condition != nullptr)
+	{
+		Hoist(*condition);
+	}
+	Rewrite(body);
+
+	// everything the loop writes is known only now that loops within it got their temporaries
+	std::vector<SideEffects::Variable> writes = effects.Writes(&loop, chain);
+	loop_writes = &writes;
+	if (condition != nullptr)
+	{
+		Hoist(*condition);
+	}
+	Rewrite(body);
+	loop_writes = nullptr;
+
+	if (!prelude.empty())
+	{
+		prelude.push_back(&loop);
+		hoisted_stmt = arena.New<CompoundStmt>(arena.Copy(prelude));
+		prelude.clear();
+	}
+}
+
+void LoopHoister::Rewrite(Stmt*& stmt)
+{
+	hoisted_stmt = nullptr;
+	stmt->Accept(*this);
+	if (hoisted_stmt != nullptr)
+	{
+		stmt = hoisted_stmt;
+		hoisted_stmt = nullptr;
+	}
+}
+
+void LoopHoister::Hoist(Expr*& expr)
+{
+	if (Invariant(expr))
+	{
+		Hoisted(expr);
+	}
+}
+
+bool LoopHoister::Invariant(Expr*& expr)
+{
+	invariant = false;
+	expr->Accept(*this);
+	return invariant;
+}
+
+void LoopHoister::Hoisted(Expr*& expr)
+{
+	// a literal or a variable is read as fast as a temporary
+	if (loop_writes == nullptr || (dynamic_cast<BinaryExpr*>(expr) == nullptr && dynamic_cast<UnaryExpr*>(expr) == nullptr))
+	{
+		return;
+	}
+
+	auto slot = static_cast<uint32_t>(frame.size());
+	frame.push_back(expr->type);
+
+	auto* assignment = arena.New<AssignmentStmt>(Identifier{}, expr);
+	assignment->address = { 0, slot };
+	prelude.push_back(assignment);
+
+	auto* temporary = arena.New<VariableExpr>(Identifier{});
+	temporary->type = expr->type;
+	temporary->address = { 0, slot };
+	expr = temporary;
+}
+
+
+Literal LoopHoister::Visit(BinaryExpr& binExpr)
+{
+	bool left = Invariant(binExpr.left);
+	bool right = Invariant(binExpr.right);
+
+	// division is the only operator that can fail -> evaluated ahead only when its divisor is known to be fine
+	bool safe = true;
+	if (binExpr.op == TokenType::DIV)
+	{
+		auto* divisor = dynamic_cast<LiteralExpr*>(binExpr.right);
+		safe = divisor != nullptr && std::get<int>(divisor->value) != 0 && std::get<int>(divisor->value) != -1;
+	}
+	if (left && right && safe)
+	{
+		invariant = true;
+		return nullptr;
+	}
+
+	if (left)
+	{
+		Hoisted(binExpr.left);
+	}
+	if (right)
+	{
+		Hoisted(binExpr.right);
+	}
+	invariant = false;
+	return nullptr;
+}
+
+Literal LoopHoister::Visit(UnaryExpr& unExpr)
+{
+	invariant = Invariant(unExpr.right);
+	return nullptr;
+}
+
+Literal LoopHoister::Visit([[maybe_unused]] LiteralExpr& litExpr)
+{
+	invariant = true;
+	return nullptr;
+}
+
+Literal LoopHoister::Visit(GroupingExpr& grExpr)
+{
+	invariant = Invariant(grExpr.expr);
+	return nullptr;
+}
+
+Literal LoopHoister::Visit(VariableExpr& varExpr)
+{
+	if (varExpr.callee != nullptr || loop_writes == nullptr) // function without parameters
+	{
+		invariant = false;
+		return nullptr;
+	}
+	invariant = !std::binary_search(loop_writes->begin(), loop_writes->end(), SideEffects::Of(chain, varExpr.address));
+	return nullptr;
+}
+
+Literal LoopHoister::Visit(FunctionCallExpr& funcCallExpr)
+{
+	for (auto&& expr : funcCallExpr.exprs)
+	{
+		Hoist(expr);
+	}
+	invariant = false;
+	return nullptr;
+}
+
+Literal LoopHoister::Visit(InlinedCallExpr& inlinedCallExpr)
+{
+	Visit(*inlinedCallExpr.call);
+	invariant = false;
+	return nullptr;
+}
+
+void LoopHoister::Visit(ProgramStmt& programStmt)
+{
+	HoistRoutine(nullptr, programStmt.slots, programStmt.decl_stmts, programStmt.stmt);
+}
+
+void LoopHoister::Visit(CompoundStmt& compoundStmt)
+{
+	for (auto&& stmt : compoundStmt.statements)
+	{
+		Rewrite(stmt);
+	}
+}
+
+void LoopHoister::Visit(WritelnStmt& writelnStmt)
+{
+	for (auto&& expr : writelnStmt.exprs)
+	{
+		Hoist(expr);
+	}
+}
+
+void LoopHoister::Visit([[maybe_unused]] EmptyStmt& emptyStmt) {}
+
+void LoopHoister::Visit([[maybe_unused]] VarDeclStmt& varDeclStmt) {}
+
+void LoopHoister::Visit(FuncDeclStmt& funcDeclStmt)
+{
+	HoistRoutine(funcDeclStmt.routine, funcDeclStmt.routine->slots, funcDeclStmt.decl_stmts, funcDeclStmt.body);
+}
+
+void LoopHoister::Visit(ProcDeclStmt& procDeclStmt)
+{
+	HoistRoutine(procDeclStmt.routine, procDeclStmt.routine->slots, procDeclStmt.decl_stmts, procDeclStmt.body);
+}
+
+void LoopHoister::Visit(AssignmentStmt& assignmentStmt)
+{
+	Hoist(assignmentStmt.value);
+}
+
+void LoopHoister::Visit(IfStmt& ifStmt)
+{
+	Hoist(ifStmt.condition);
+	Rewrite(ifStmt.then_branch);
+	if (ifStmt.else_branch != nullptr)
+	{
+		Rewrite(ifStmt.else_branch);
+	}
+}
+
+// loops within the one hoisted out of are only walked, they got their own temporaries already
+void LoopHoister::Visit(WhileStmt& whileStmt)
+{
+	if (loop_writes == nullptr)
+	{
+		HoistLoop(whileStmt, &whileStmt.condition, whileStmt.body);
+		return;
+	}
+	Hoist(whileStmt.condition);
+	Rewrite(whileStmt.body);
+}
+
+// initial value and limit are evaluated once per run of the loop -> only its body is hoisted out of
+void LoopHoister::Visit(ForStmt& forStmt)
+{
+	Rewrite(forStmt.assignment);
+	Hoist(forStmt.expression);
+	if (loop_writes == nullptr)
+	{
+		HoistLoop(forStmt, nullptr, forStmt.body);
+		return;
+	}
+	Rewrite(forStmt.body);
+}
+
+void LoopHoister::Visit(ProcedureCallStmt& procedureCallStmt)
+{
+	for (auto&& expr : procedureCallStmt.arguments)
+	{
+		Hoist(expr);
+	}
+}
+
+// copy of a body runs on slots of the caller -> its loops get their temporaries there too
+void LoopHoister::Visit(InlinedCallStmt& inlinedCallStmt)
+{
+	for (auto&& expr : inlinedCallStmt.arguments)
+	{
+		Hoist(expr);
+	}
+	Rewrite(inlinedCallStmt.body);
+}
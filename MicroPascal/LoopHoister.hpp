@@ -0,0 +1,62 @@
+#ifndef LOOPHOISTER_HPP
+#define LOOPHOISTER_HPP
+
+#include <vector>
+
+#include "Arena.hpp"
+#include "Expr.hpp"
+#include "Stmt.hpp"
+#include "SideEffects.hpp"
+
+// optimization pass over a resolved program -> parts of expressions in while and for loops that read only variables
+// the loop does not write (itself or through the routines it calls), call nothing and cannot fail
+// get evaluated once before the loop, into new slots of the environment the loop runs in
+class LoopHoister : public VisitorExpr, public VisitorStmt
+{
+public:
+	LoopHoister(Arena& m_arena);
+
+	void Hoist(Stmt* program);
+
+private:
+	Literal Visit(BinaryExpr& binExpr) override;
+	Literal Visit(UnaryExpr& unExpr) override;
+	Literal Visit([[maybe_unused]] LiteralExpr& litExpr) override;
+	Literal Visit(GroupingExpr& grExpr) override;
+	Literal Visit(VariableExpr& varExpr) override;
+	Literal Visit(FunctionCallExpr& funcCallExpr) override;
+	Literal Visit(InlinedCallExpr& inlinedCallExpr) override;
+
+	void Visit(ProgramStmt& programStmt) override;
+	void Visit(CompoundStmt& compoundStmt) override;
+	void Visit(WritelnStmt& writelnStmt) override;
+	void Visit([[maybe_unused]] EmptyStmt& emptyStmt) override;
+	void Visit([[maybe_unused]] VarDeclStmt& varDeclStmt) override;
+	void Visit(FuncDeclStmt& funcDeclStmt) override;
+	void Visit(AssignmentStmt& assignmentStmt) override;
+	void Visit(IfStmt& ifStmt) override;
+	void Visit(WhileStmt& whileStmt) override;
+	void Visit(ForStmt& forStmt) override;
+	void Visit(ProcDeclStmt& procDeclStmt) override;
+	void Visit(ProcedureCallStmt& procedureCallStmt) override;
+	void Visit(InlinedCallStmt& inlinedCallStmt) override;
+
+	void HoistRoutine(const Routine* routine, Span<VariableType>& slots, Span<Stmt*> decl_stmts, Stmt* body);
+	void HoistLoop(Stmt& loop, Expr** condition, Stmt*& body); // loops within first -> their temporaries get hoisted further
+
+	void Rewrite(Stmt*& stmt); // walks stmt, replaces it by the loop with its temporaries in front
+	void Hoist(Expr*& expr); // invariant parts of expr -> temporaries
+	bool Invariant(Expr*& expr); // false -> invariant parts of expr got hoisted already
+	void Hoisted(Expr*& expr); // invariant one -> temporary, unless it is too simple to be worth one
+
+	Arena& arena; // temporaries go in here
+	SideEffects effects;
+	SideEffects::Chain chain; // routines being walked, innermost last
+	std::vector<VariableType> frame; // slots of the innermost one
+	const std::vector<SideEffects::Variable>* loop_writes = nullptr; // of the loop hoisted out of, nullptr -> only looking for loops
+	std::vector<Stmt*> prelude; // assignments of its temporaries
+	bool invariant = false; // expression just visited
+	Stmt* hoisted_stmt = nullptr; // replacement of the statement just visited
+};
+
+#endif // !LOOPHOISTER_HPP
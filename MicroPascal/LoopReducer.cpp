@@ -0,0 +1,459 @@
+#include <algorithm>
+#include <utility>
+#include <variant>
+
+#include "LoopReducer.hpp"
+
+LoopReducer::LoopReducer(Arena& m_arena) : arena(m_arena) {}
+
+void LoopReducer::Reduce(Stmt* program)
+{
+	program->Accept(*this);
+}
+
+void LoopReducer::ReduceRoutine(const Routine* routine, Span<VariableType>& slots, Span<Stmt*> decl_stmts, Stmt* body)
+{
+	chain.push_back(routine);
+	std::vector<VariableType> outer_frame = std::move(frame);
+
+	for (auto&& decl : decl_stmts)
+	{
+		decl->Accept(*this);
+	}
+
+	frame.assign(slots.begin(), slots.end());
+	body->Accept(*this);
+	if (frame.size() > slots.size())
+	{
+		slots = arena.Copy(frame);
+	}
+
+	frame = std::move(outer_frame);
+	chain.pop_back();
+}
+
+// sum over all iterations -> coefficient * (sum of the counter values) + constant * (number of iterations)
+bool LoopReducer::CloseForm(ForStmt& forStmt)
+{
+	std::vector<AssignmentStmt*> assignments;
+	if (!Accumulations(forStmt.body, assignments))
+	{
+		return false;
+	}
+
+	counter = forStmt.address;
+	targets.clear();
+	for (auto&& assignment : assignments)
+	{
+		if (Same(assignment->address, counter) || assignment->value->type != VariableType::INTEGER)
+		{
+			return false;
+		}
+		targets.push_back(assignment->address);
+	}
+
+	std::vector<Reduction> reductions;
+	for (auto&& assignment : assignments)
+	{
+		target = assignment->address;
+		Term term;
+		if (!Decompose(assignment->value, term) || term.accumulators != 1)
+		{
+			return false;
+		}
+		Reduction reduction;
+		reduction.target = target;
+		reduction.coefficient = OrZero(term.coefficient);
+		reduction.constant = OrZero(term.constant);
+		reductions.push_back(reduction);
+	}
+
+	forStmt.reductions = arena.Copy(reductions);
+	forStmt.closed_form = true;
+	return true;
+}
+
+void LoopReducer::StrengthReduce(ForStmt& forStmt)
+{
+	// counter moved by the body (or by a routine it calls) -> products would go out of step
+	body_writes = effects.Writes(forStmt.body, chain);
+	if (std::binary_search(body_writes.begin(), body_writes.end(), SideEffects::Of(chain, forStmt.address)))
+	{
+		return;
+	}
+
+	loop = &forStmt;
+	forStmt.body->Accept(*this);
+	loop = nullptr;
+	if (!inductions.empty())
+	{
+		forStmt.inductions = arena.Copy(inductions);
+		inductions.clear();
+	}
+}
+
+bool LoopReducer::Accumulations(Stmt* stmt, std::vector<AssignmentStmt*>& assignments)
+{
+	if (auto* assignment = dynamic_cast<AssignmentStmt*>(stmt))
+	{
+		assignments.push_back(assignment);
+		return true;
+	}
+	if (auto* compound = dynamic_cast<CompoundStmt*>(stmt))
+	{
+		return std::all_of(compound->statements.begin(), compound->statements.end(),
+			[&](Stmt* inner) { return Accumulations(inner, assignments); });
+	}
+	return dynamic_cast<EmptyStmt*>(stmt) != nullptr;
+}
+
+// only additions, subtractions, negations and multiplications -> nothing can fail and everything wraps around the same way
+bool LoopReducer::Decompose(Expr* expr, Term& term)
+{
+	if (expr->type != VariableType::INTEGER)
+	{
+		return false;
+	}
+
+	if (dynamic_cast<LiteralExpr*>(expr) != nullptr)
+	{
+		term.constant = expr;
+		return true;
+	}
+
+	if (auto* variable = dynamic_cast<VariableExpr*>(expr))
+	{
+		if (variable->callee != nullptr) // function without parameters
+		{
+			return false;
+		}
+		if (Same(variable->address, counter))
+		{
+			term.coefficient = arena.New<LiteralExpr>(1);
+			return true;
+		}
+		if (Same(variable->address, target))
+		{
+			term.accumulators = 1;
+			return true;
+		}
+		if (std::any_of(targets.begin(), targets.end(), [&](Address other) { return Same(variable->address, other); }))
+		{
+			return false;
+		}
+		term.constant = expr;
+		return true;
+	}
+
+	if (auto* grouping = dynamic_cast<GroupingExpr*>(expr))
+	{
+		return Decompose(grouping->expr, term);
+	}
+
+	if (auto* unary = dynamic_cast<UnaryExpr*>(expr))
+	{
+		if (!Decompose(unary->right, term))
+		{
+			return false;
+		}
+		if (unary->op == TokenType::MINUS)
+		{
+			term.accumulators = -term.accumulators;
+			term.coefficient = Negate(term.coefficient, unary->loc);
+			term.constant = Negate(term.constant, unary->loc);
+		}
+		return unary->op == TokenType::MINUS || unary->op == TokenType::PLUS;
+	}
+
+	auto* binary = dynamic_cast<BinaryExpr*>(expr);
+	Term left, right;
+	if (binary == nullptr || !Decompose(binary->left, left) || !Decompose(binary->right, right))
+	{
+		return false;
+	}
+	switch (binary->op)
+	{
+	case TokenType::PLUS:
+		term.accumulators = left.accumulators + right.accumulators;
+		term.coefficient = Add(left.coefficient, right.coefficient, binary->loc);
+		term.constant = Add(left.constant, right.constant, binary->loc);
+		return true;
+	case TokenType::MINUS:
+		term.accumulators = left.accumulators - right.accumulators;
+		term.coefficient = Subtract(left.coefficient, right.coefficient, binary->loc);
+		term.constant = Subtract(left.constant, right.constant, binary->loc);
+		return true;
+	case TokenType::MUL:
+		if (left.accumulators == 0 && left.coefficient == nullptr) // constant factor on the left
+		{
+			std::swap(left, right);
+		}
+		if (right.accumulators != 0 || right.coefficient != nullptr || left.accumulators != 0) // product with the counter or a target
+		{
+			return false;
+		}
+		term.coefficient = Multiply(left.coefficient, right.constant, binary->loc);
+		term.constant = Multiply(left.constant, right.constant, binary->loc);
+		return true;
+	default:
+		return false;
+	}
+}
+
+void LoopReducer::Rewrite(Expr*& expr)
+{
+	reduced_expr = nullptr;
+	expr->Accept(*this);
+	if (reduced_expr != nullptr)
+	{
+		expr = reduced_expr;
+		reduced_expr = nullptr;
+	}
+}
+
+bool LoopReducer::Counter(Expr* expr) const
+{
+	auto* variable = dynamic_cast<VariableExpr*>(expr);
+	return variable != nullptr && variable->callee == nullptr && Same(variable->address, loop->address);
+}
+
+// invariants got hoisted into variables before -> a literal or a variable nothing in the body writes
+bool LoopReducer::Step(Expr* expr) const
+{
+	if (dynamic_cast<LiteralExpr*>(expr) != nullptr)
+	{
+		return true;
+	}
+	auto* variable = dynamic_cast<VariableExpr*>(expr);
+	return variable != nullptr && variable->callee == nullptr && !Counter(variable)
+		&& !std::binary_search(body_writes.begin(), body_writes.end(), SideEffects::Of(chain, variable->address));
+}
+
+Expr* LoopReducer::InductionOf(Expr* step)
+{
+	// same step -> same slot
+	auto same = [&](const Induction& induction)
+	{
+		auto* literal = dynamic_cast<LiteralExpr*>(step);
+		auto* other_literal = dynamic_cast<LiteralExpr*>(induction.step);
+		if (literal != nullptr || other_literal != nullptr)
+		{
+			return literal != nullptr && other_literal != nullptr && literal->value == other_literal->value;
+		}
+		return Same(static_cast<VariableExpr*>(step)->address, static_cast<VariableExpr*>(induction.step)->address);
+	};
+	auto found = std::find_if(inductions.begin(), inductions.end(), same);
+
+	uint32_t slot;
+	if (found != inductions.end())
+	{
+		slot = found->slot;
+	}
+	else if (inductions.size() == ForStmt::max_inductions)
+	{
+		return nullptr;
+	}
+	else
+	{
+		slot = static_cast<uint32_t>(frame.size());
+		frame.push_back(VariableType::INTEGER);
+		Induction induction;
+		induction.slot = slot;
+		induction.step = step;
+		inductions.push_back(induction);
+	}
+
+	auto* product = arena.New<VariableExpr>(Identifier{});
+	product->address = { 0, slot };
+	return product;
+}
+
+Expr* LoopReducer::Add(Expr* left, Expr* right, SourceLoc loc)
+{
+	if (left == nullptr || right == nullptr)
+	{
+		return left != nullptr ? left : right;
+	}
+	return arena.New<BinaryExpr>(left, right, TokenType::PLUS, loc);
+}
+
+Expr* LoopReducer::Subtract(Expr* left, Expr* right, SourceLoc loc)
+{
+	if (left == nullptr || right == nullptr)
+	{
+		return left != nullptr ? left : Negate(right, loc);
+	}
+	return arena.New<BinaryExpr>(left, right, TokenType::MINUS, loc);
+}
+
+Expr* LoopReducer::Multiply(Expr* left, Expr* right, SourceLoc loc)
+{
+	if (left == nullptr || right == nullptr)
+	{
+		return nullptr;
+	}
+	return arena.New<BinaryExpr>(left, right, TokenType::MUL, loc);
+}
+
+Expr* LoopReducer::Negate(Expr* right, SourceLoc loc)
+{
+	if (right == nullptr)
+	{
+		return nullptr;
+	}
+	return arena.New<UnaryExpr>(right, TokenType::MINUS, loc);
+}
+
+Expr* LoopReducer::OrZero(Expr* expr)
+{
+	return expr != nullptr ? expr : arena.New<LiteralExpr>(0);
+}
+
+bool LoopReducer::Same(Address left, Address right)
+{
+	return left.depth == right.depth && left.slot == right.slot;
+}
+
+
+Literal LoopReducer::Visit(BinaryExpr& binExpr)
+{
+	Rewrite(binExpr.left);
+	Rewrite(binExpr.right);
+	if (loop == nullptr || binExpr.op != TokenType::MUL)
+	{
+		return nullptr;
+	}
+
+	if (Counter(binExpr.left) && Step(binExpr.right))
+	{
+		reduced_expr = InductionOf(binExpr.right);
+	}
+	else if (Counter(binExpr.right) && Step(binExpr.left))
+	{
+		reduced_expr = InductionOf(binExpr.left);
+	}
+	return nullptr;
+}
+
+Literal LoopReducer::Visit(UnaryExpr& unExpr)
+{
+	Rewrite(unExpr.right);
+	return nullptr;
+}
+
+Literal LoopReducer::Visit([[maybe_unused]] LiteralExpr& litExpr)
+{
+	return nullptr;
+}
+
+Literal LoopReducer::Visit(GroupingExpr& grExpr)
+{
+	Rewrite(grExpr.expr);
+	return nullptr;
+}
+
+Literal LoopReducer::Visit([[maybe_unused]] VariableExpr& varExpr)
+{
+	return nullptr;
+}
+
+Literal LoopReducer::Visit(FunctionCallExpr& funcCallExpr)
+{
+	for (auto&& expr : funcCallExpr.exprs)
+	{
+		Rewrite(expr);
+	}
+	return nullptr;
+}
+
+Literal LoopReducer::Visit(InlinedCallExpr& inlinedCallExpr)
+{
+	Visit(*inlinedCallExpr.call);
+	return nullptr;
+}
+
+void LoopReducer::Visit(ProgramStmt& programStmt)
+{
+	ReduceRoutine(nullptr, programStmt.slots, programStmt.decl_stmts, programStmt.stmt);
+}
+
+void LoopReducer::Visit(CompoundStmt& compoundStmt)
+{
+	for (auto&& stmt : compoundStmt.statements)
+	{
+		stmt->Accept(*this);
+	}
+}
+
+void LoopReducer::Visit(WritelnStmt& writelnStmt)
+{
+	for (auto&& expr : writelnStmt.exprs)
+	{
+		Rewrite(expr);
+	}
+}
+
+void LoopReducer::Visit([[maybe_unused]] EmptyStmt& emptyStmt) {}
+
+void LoopReducer::Visit([[maybe_unused]] VarDeclStmt& varDeclStmt) {}
+
+void LoopReducer::Visit(FuncDeclStmt& funcDeclStmt)
+{
+	ReduceRoutine(funcDeclStmt.routine, funcDeclStmt.routine->slots, funcDeclStmt.decl_stmts, funcDeclStmt.body);
+}
+
+void LoopReducer::Visit(ProcDeclStmt& procDeclStmt)
+{
+	ReduceRoutine(procDeclStmt.routine, procDeclStmt.routine->slots, procDeclStmt.decl_stmts, procDeclStmt.body);
+}
+
+void LoopReducer::Visit(AssignmentStmt& assignmentStmt)
+{
+	Rewrite(assignmentStmt.value);
+}
+
+void LoopReducer::Visit(IfStmt& ifStmt)
+{
+	Rewrite(ifStmt.condition);
+	ifStmt.then_branch->Accept(*this);
+	if (ifStmt.else_branch != nullptr)
+	{
+		ifStmt.else_branch->Accept(*this);
+	}
+}
+
+void LoopReducer::Visit(WhileStmt& whileStmt)
+{
+	Rewrite(whileStmt.condition);
+	whileStmt.body->Accept(*this);
+}
+
+// loops within first, then the loop itself -> within the one being strength reduced they are only walked
+void LoopReducer::Visit(ForStmt& forStmt)
+{
+	forStmt.assignment->Accept(*this);
+	Rewrite(forStmt.expression);
+	forStmt.body->Accept(*this);
+	if (loop == nullptr && !CloseForm(forStmt))
+	{
+		StrengthReduce(forStmt);
+	}
+}
+
+void LoopReducer::Visit(ProcedureCallStmt& procedureCallStmt)
+{
+	for (auto&& expr : procedureCallStmt.arguments)
+	{
+		Rewrite(expr);
+	}
+}
+
+// copy of a body runs on slots of the caller -> its products get their slots there too
+void LoopReducer::Visit(InlinedCallStmt& inlinedCallStmt)
+{
+	for (auto&& expr : inlinedCallStmt.arguments)
+	{
+		Rewrite(expr);
+	}
+	inlinedCallStmt.body->Accept(*this);
+}
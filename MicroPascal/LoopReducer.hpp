@@ -0,0 +1,88 @@
+#ifndef LOOPREDUCER_HPP
+#define LOOPREDUCER_HPP
+
+#include <cstdint>
+#include <vector>
+
+#include "Arena.hpp"
+#include "Expr.hpp"
+#include "Stmt.hpp"
+#include "SideEffects.hpp"
+
+// optimization pass over a resolved program, after loop invariants got hoisted -> for loops whose bodies only add
+// expressions affine in the counter to integer variables run in closed form, in the others products of the counter
+// and a step the loop does not change become slots the interpreter advances by additions
+class LoopReducer : public VisitorExpr, public VisitorStmt
+{
+public:
+	LoopReducer(Arena& m_arena);
+
+	void Reduce(Stmt* program);
+
+private:
+	Literal Visit(BinaryExpr& binExpr) override;
+	Literal Visit(UnaryExpr& unExpr) override;
+	Literal Visit([[maybe_unused]] LiteralExpr& litExpr) override;
+	Literal Visit(GroupingExpr& grExpr) override;
+	Literal Visit([[maybe_unused]] VariableExpr& varExpr) override;
+	Literal Visit(FunctionCallExpr& funcCallExpr) override;
+	Literal Visit(InlinedCallExpr& inlinedCallExpr) override;
+
+	void Visit(ProgramStmt& programStmt) override;
+	void Visit(CompoundStmt& compoundStmt) override;
+	void Visit(WritelnStmt& writelnStmt) override;
+	void Visit([[maybe_unused]] EmptyStmt& emptyStmt) override;
+	void Visit([[maybe_unused]] VarDeclStmt& varDeclStmt) override;
+	void Visit(FuncDeclStmt& funcDeclStmt) override;
+	void Visit(AssignmentStmt& assignmentStmt) override;
+	void Visit(IfStmt& ifStmt) override;
+	void Visit(WhileStmt& whileStmt) override;
+	void Visit(ForStmt& forStmt) override;
+	void Visit(ProcDeclStmt& procDeclStmt) override;
+	void Visit(ProcedureCallStmt& procedureCallStmt) override;
+	void Visit(InlinedCallStmt& inlinedCallStmt) override;
+
+	// value of an expression as accumulators * target + coefficient * counter + constant, nullptr -> 0
+	struct Term
+	{
+		int32_t accumulators = 0;
+		Expr* coefficient = nullptr;
+		Expr* constant = nullptr;
+	};
+
+	void ReduceRoutine(const Routine* routine, Span<VariableType>& slots, Span<Stmt*> decl_stmts, Stmt* body);
+	bool CloseForm(ForStmt& forStmt);
+	void StrengthReduce(ForStmt& forStmt);
+	static bool Accumulations(Stmt* stmt, std::vector<AssignmentStmt*>& assignments); // false -> stmt does something else too
+	bool Decompose(Expr* expr, Term& term); // false -> not affine, or reads another target
+
+	void Rewrite(Expr*& expr); // walks expr, replaces it by the slot of its induction
+	bool Counter(Expr* expr) const; // read of the counter of loop
+	bool Step(Expr* expr) const;
+	Expr* InductionOf(Expr* step); // read of its slot, nullptr -> loop has no slot left
+
+	// nodes of closed forms, nullptr -> 0
+	Expr* Add(Expr* left, Expr* right, SourceLoc loc);
+	Expr* Subtract(Expr* left, Expr* right, SourceLoc loc);
+	Expr* Multiply(Expr* left, Expr* right, SourceLoc loc);
+	Expr* Negate(Expr* right, SourceLoc loc);
+	Expr* OrZero(Expr* expr);
+
+	static bool Same(Address left, Address right);
+
+	Arena& arena; // closed forms and slot reads go in here
+	SideEffects effects;
+	SideEffects::Chain chain; // routines being walked, innermost last
+	std::vector<VariableType> frame; // slots of the innermost one
+
+	Address counter; // of the loop being put in closed form
+	Address target; // of the accumulation being decomposed
+	std::vector<Address> targets; // of all its accumulations
+
+	ForStmt* loop = nullptr; // whose products get strength reduced, nullptr -> only looking for loops
+	std::vector<SideEffects::Variable> body_writes; // of loop
+	std::vector<Induction> inductions; // of loop
+	Expr* reduced_expr = nullptr; // replacement of the node just visited
+};
+
+#endif // !LOOPREDUCER_HPP
@@ -0,0 +1,238 @@
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+#include "ParallelLexer.hpp"
+#include "Lexer.hpp"
+#include "CharScan.hpp"
+
+ParallelLexer::ParallelLexer(std::string_view m_text, SymbolTable& m_symbols, unsigned m_jobs, size_t m_min_chunk_size) : text(m_text)
+{
+	// a few chunks per thread -> threads that finish early take over the rest
+	size_t chunk_count = 1;
+	if (m_jobs > 1)
+	{
+		chunk_count = std::max<size_t>(1, std::min<size_t>(m_jobs * 4, text.size() / std::max<size_t>(1, m_min_chunk_size)));
+	}
+
+	std::vector<size_t> boundaries = FindBoundaries(chunk_count);
+	std::vector<Chunk> chunks(boundaries.size() - 1);
+	for (size_t i = 0; i < chunks.size(); i++)
+	{
+		chunks[i].text = text.substr(boundaries[i], boundaries[i + 1] - boundaries[i]); // still points into the source buffer
+	}
+
+	// thread pool, calling thread works too
+	std::atomic<size_t> next_chunk{ 0 };
+	auto worker = [&chunks, &next_chunk]()
+	{
+		for (size_t i = next_chunk++; i < chunks.size(); i = next_chunk++)
+		{
+			LexChunk(chunks[i]);
+		}
+	};
+
+	std::vector<std::thread> threads;
+	size_t thread_count = std::min<size_t>(std::max(1u, m_jobs), chunks.size());
+	for (size_t i = 1; i < thread_count; i++)
+	{
+		threads.emplace_back(worker);
+	}
+	worker();
+	for (auto&& thread : threads)
+	{
+		thread.join();
+	}
+
+	Stitch(chunks, m_symbols);
+}
+
+Token ParallelLexer::NextToken()
+{
+	if (next_token < tokens.size())
+	{
+		Token& token = tokens[next_token];
+		if (token.type != TokenType::END_OF_FILE) // EOF repeats forever
+		{
+			next_token++;
+		}
+		return token;
+	}
+
+	// tokens only run out before EOF if there was an error -> report it where serial lexer would
+	throw *error;
+}
+
+const std::vector<Token>& ParallelLexer::GetTokens() const
+{
+	return tokens;
+}
+
+const std::optional<Error>& ParallelLexer::GetError() const
+{
+	return error;
+}
+
+
+// quick pre-scan -> chunk starts right after a newline that is outside of any comment or string
+std::vector<size_t> ParallelLexer::FindBoundaries(size_t chunk_count) const
+{
+	std::vector<size_t> boundaries{ 0 };
+
+	size_t pos = 0;
+	for (size_t k = 1; k < chunk_count && pos < text.size(); k++)
+	{
+		size_t target = text.size() / chunk_count * k;
+		if (pos < target)
+		{
+			pos = SkipCodeUntil(pos, target);
+		}
+
+		// find end of the current line, still skipping comments and strings
+		while (pos < text.size() && text[pos] != '\n')
+		{
+			if (text[pos] == '{')
+			{
+				pos = SkipComment(pos);
+			}
+			else if (text[pos] == '\'')
+			{
+				pos = CharScan::FindQuoteOrNewline(text, pos + 1);
+				if (pos < text.size() && text[pos] == '\'')
+				{
+					pos++;
+				}
+			}
+			else
+			{
+				pos++;
+			}
+		}
+
+		if (pos + 1 >= text.size())
+		{
+			break; // nothing left for another chunk
+		}
+		pos++; // chunk starts on the next line
+		boundaries.push_back(pos);
+	}
+
+	boundaries.push_back(text.size());
+	return boundaries;
+}
+
+// pos is outside of comments and strings, returns first position >= target that is too (or end of input)
+size_t ParallelLexer::SkipCodeUntil(size_t pos, size_t target) const
+{
+	while (true)
+	{
+		size_t found = CharScan::FindCommentOrString(text.substr(0, target), pos); // scan stops at target
+		if (found >= target)
+		{
+			return target;
+		}
+
+		if (text[found] == '{')
+		{
+			pos = SkipComment(found);
+		}
+		else // string cannot exceed line -> ends at ' or newline
+		{
+			pos = CharScan::FindQuoteOrNewline(text, found + 1) + 1;
+		}
+
+		if (pos >= target)
+		{
+			return std::min(pos, text.size());
+		}
+	}
+}
+
+// pos is at '{', returns position after the matching '}' (or end of input for unterminated comment)
+size_t ParallelLexer::SkipComment(size_t pos) const
+{
+	int newlines = 0; // not needed here, lines get counted by chunk lexers
+	int braces_count = 1;
+	pos++; // go past the first '{'
+
+	while (braces_count != 0)
+	{
+		pos = CharScan::FindBrace(text, pos, newlines);
+		if (pos >= text.size())
+		{
+			return text.size();
+		}
+		braces_count += (text[pos] == '{') ? 1 : -1;
+		pos++;
+	}
+	return pos;
+}
+
+
+void ParallelLexer::LexChunk(Chunk& chunk)
+{
+	Lexer lexer(chunk.text, chunk.local_symbols, 1); // lines relative to chunk start, fixed up by Stitch
+	try
+	{
+		for (Token token = lexer.NextToken(); ; token = lexer.NextToken())
+		{
+			if (token.type == TokenType::END_OF_FILE)
+			{
+				chunk.line_count = token.line_num - 1;
+				break;
+			}
+			chunk.tokens.push_back(token);
+		}
+	}
+	catch (const Error& e)
+	{
+		chunk.error = e;
+	}
+}
+
+// concatenates chunks in order -> lines and locations get shifted and local symbol ids mapped to global ones,
+// interning each chunk's names in order of first appearance gives the same ids as the serial lexer
+void ParallelLexer::Stitch(std::vector<Chunk>& chunks, SymbolTable& symbols)
+{
+	size_t total = 1;
+	for (auto&& chunk : chunks)
+	{
+		total += chunk.tokens.size();
+	}
+	tokens.reserve(total);
+
+	int line_offset = 0;
+	uint32_t loc_offset = 0;
+	std::vector<SymbolId> global_ids;
+	for (auto&& chunk : chunks)
+	{
+		global_ids.resize(chunk.local_symbols.Size());
+		for (SymbolId id = 0; id < global_ids.size(); id++)
+		{
+			global_ids[id] = symbols.Intern(chunk.local_symbols.Name(id));
+		}
+
+		for (auto&& token : chunk.tokens)
+		{
+			if (token.type == TokenType::ID)
+			{
+				token.symbol = global_ids[token.symbol];
+			}
+			token.line_num += line_offset;
+			token.loc.offset += loc_offset;
+			tokens.push_back(token);
+		}
+
+		// serial lexer would stop at the first error
+		if (chunk.error.has_value())
+		{
+			error = Error(chunk.error->Line() + line_offset, chunk.error->Message());
+			return;
+		}
+
+		line_offset += chunk.line_count;
+		loc_offset += static_cast<uint32_t>(chunk.text.size());
+	}
+
+	tokens.push_back(Token(TokenType::END_OF_FILE, std::string_view(), 1 + line_offset, SourceLoc{ loc_offset }));
+}
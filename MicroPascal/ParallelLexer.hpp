@@ -0,0 +1,49 @@
+#ifndef PARALLELLEXER_HPP
+#define PARALLELLEXER_HPP
+
+#include <optional>
+#include <string_view>
+#include <vector>
+
+#include "Error.hpp"
+#include "SymbolTable.hpp"
+#include "Token.hpp"
+#include "TokenSource.hpp"
+
+// lexes the whole input up front -> input is split at newlines outside of comments and strings,
+// chunks get lexed on a pool of threads and stitched together in order
+class ParallelLexer : public TokenSource
+{
+public:
+	static constexpr size_t default_min_chunk_size = 1 << 20;
+
+	ParallelLexer(std::string_view m_text, SymbolTable& m_symbols, unsigned m_jobs, size_t m_min_chunk_size = default_min_chunk_size);
+
+	Token NextToken() override; // throws lexical error once the tokens before it are consumed
+
+	const std::vector<Token>& GetTokens() const; // same as serial Lexer::GetTokens() up to the first lexical error
+	const std::optional<Error>& GetError() const;
+
+private:
+	struct Chunk
+	{
+		std::string_view text;
+		SymbolTable local_symbols; // chunks do not share a table -> no locking while lexing
+		std::vector<Token> tokens; // without END_OF_FILE
+		int line_count = 0; // lines started in this chunk, used to fix up lines of the following chunks
+		std::optional<Error> error;
+	};
+
+	std::vector<size_t> FindBoundaries(size_t chunk_count) const;
+	size_t SkipCodeUntil(size_t pos, size_t target) const;
+	size_t SkipComment(size_t pos) const;
+	static void LexChunk(Chunk& chunk);
+	void Stitch(std::vector<Chunk>& chunks, SymbolTable& symbols);
+
+	std::string_view text;
+	std::vector<Token> tokens;
+	std::optional<Error> error;
+	size_t next_token = 0;
+};
+
+#endif // !PARALLELLEXER_HPP
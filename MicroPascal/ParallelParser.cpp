@@ -0,0 +1,188 @@
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <thread>
+
+#include "ParallelParser.hpp"
+#include "Error.hpp"
+
+ParallelParser::ParallelParser(ParallelLexer& m_lexer, unsigned m_jobs) : lexer(m_lexer), jobs(m_jobs) {}
+
+Stmt* ParallelParser::Parse(Arena& arena)
+{
+	std::vector<std::pair<size_t, size_t>> ranges;
+	if (!lexer.GetError().has_value()) // lexical error has to come up in the middle of parsing -> serial only
+	{
+		ranges = FindDeclarations();
+	}
+	if (jobs <= 1 || ranges.size() < 2)
+	{
+		Parser parser(lexer, arena);
+		return parser.Parse();
+	}
+
+	const std::vector<Token>& tokens = lexer.GetTokens();
+	std::vector<Stmt*> decl_stmts(ranges.size());
+	std::atomic<size_t> next_range{ 0 };
+	std::atomic<bool> failed{ false };
+
+	// thread pool, calling thread works too -> every thread allocates in an arena of its own
+	size_t thread_count = std::min<size_t>(jobs, ranges.size());
+	std::vector<Arena> arenas(thread_count);
+	auto worker = [&](Arena& thread_arena)
+	{
+		for (size_t i = next_range++; i < ranges.size() && !failed; i = next_range++)
+		{
+			try
+			{
+				TokenRange range(tokens, ranges[i].first, ranges[i].second);
+				Parser parser(range, thread_arena);
+				decl_stmts[i] = parser.ParseDeclaration();
+			}
+			catch (const Error&)
+			{
+				failed = true;
+			}
+		}
+	};
+
+	std::vector<std::thread> threads;
+	for (size_t i = 1; i < thread_count; i++)
+	{
+		threads.emplace_back(worker, std::ref(arenas[i]));
+	}
+	worker(arenas[0]);
+	for (auto&& thread : threads)
+	{
+		thread.join();
+	}
+
+	// error inside of a declaration -> serial parse reports the same first error as without threads
+	if (failed)
+	{
+		TokenRange all(tokens, 0, tokens.size());
+		Parser parser(all, arena);
+		return parser.Parse();
+	}
+
+	std::unordered_map<size_t, Parser::PreparedDecl> prepared;
+	for (size_t i = 0; i < ranges.size(); i++)
+	{
+		prepared[ranges[i].first] = { decl_stmts[i], ranges[i].second };
+	}
+	for (auto&& thread_arena : arenas)
+	{
+		arena.Absorb(std::move(thread_arena));
+	}
+	TokenRange all(tokens, 0, tokens.size());
+	Parser parser(all, arena, std::move(prepared));
+	return parser.Parse();
+}
+
+
+// token ranges of top level procedures and functions, found by begin/end nesting only,
+// a wrong guess cannot change the result -> each range has to parse as exactly one declaration
+std::vector<std::pair<size_t, size_t>> ParallelParser::FindDeclarations() const
+{
+	const std::vector<Token>& tokens = lexer.GetTokens();
+	std::vector<std::pair<size_t, size_t>> ranges;
+
+	// "program" IDENTIFIER ";" declaration*
+	if (tokens.size() < 3 || tokens[0].type != TokenType::PROGRAM || tokens[1].type != TokenType::ID || tokens[2].type != TokenType::SEMICOLON)
+	{
+		return ranges;
+	}
+
+	size_t pos = 3;
+	while (pos < tokens.size())
+	{
+		switch (tokens[pos].type)
+		{
+		case TokenType::PROCEDURE:
+		case TokenType::FUNCTION:
+		{
+			size_t end = FindDeclarationEnd(pos);
+			if (end == pos) // unbalanced -> leave the rest to serial parsing
+			{
+				return ranges;
+			}
+			ranges.emplace_back(pos, end);
+			pos = end;
+			break;
+		}
+		case TokenType::BEGIN: // main compound statement
+		case TokenType::END_OF_FILE:
+			return ranges;
+		default: // variable declarations
+			pos++;
+			break;
+		}
+	}
+	return ranges;
+}
+
+// returns position after the ';' that closes the declaration, begin if there is none
+size_t ParallelParser::FindDeclarationEnd(size_t begin) const
+{
+	const std::vector<Token>& tokens = lexer.GetTokens();
+	int pending = 0; // declarations whose body has not ended yet (nested ones included)
+	int depth = 0; // begin/end nesting
+
+	for (size_t pos = begin; pos < tokens.size(); pos++)
+	{
+		switch (tokens[pos].type)
+		{
+		case TokenType::PROCEDURE:
+		case TokenType::FUNCTION:
+			pending++;
+			break;
+		case TokenType::BEGIN:
+			depth++;
+			break;
+		case TokenType::END:
+			if (--depth < 0)
+			{
+				return begin;
+			}
+			if (depth == 0 && --pending == 0) // body of the top level declaration
+			{
+				if (pos + 1 < tokens.size() && tokens[pos + 1].type == TokenType::SEMICOLON)
+				{
+					return pos + 2;
+				}
+				return begin;
+			}
+			break;
+		default:
+			break;
+		}
+	}
+	return begin;
+}
+
+
+ParallelParser::TokenRange::TokenRange(const std::vector<Token>& m_tokens, size_t m_begin, size_t m_end) : tokens(m_tokens), next(m_begin), end(m_end)
+{
+	if (end < tokens.size())
+	{
+		eof = Token(TokenType::END_OF_FILE, std::string_view(), tokens[end].line_num, tokens[end].loc);
+	}
+	else if (!tokens.empty())
+	{
+		eof = Token(TokenType::END_OF_FILE, std::string_view(), tokens.back().line_num, tokens.back().loc);
+	}
+}
+
+Token ParallelParser::TokenRange::NextToken()
+{
+	if (next < end)
+	{
+		return tokens[next++];
+	}
+	return eof;
+}
+
+void ParallelParser::TokenRange::Skip(size_t count)
+{
+	next = std::min(next + count, end);
+}
@@ -0,0 +1,47 @@
+#ifndef PARALLELPARSER_HPP
+#define PARALLELPARSER_HPP
+
+#include <utility>
+#include <vector>
+
+#include "Arena.hpp"
+#include "ParallelLexer.hpp"
+#include "Parser.hpp"
+#include "Stmt.hpp"
+#include "Token.hpp"
+#include "TokenSource.hpp"
+
+// parses top level procedure and function declarations on a pool of threads,
+// the rest of the program gets parsed as usual with the finished declarations spliced in
+class ParallelParser
+{
+public:
+	ParallelParser(ParallelLexer& m_lexer, unsigned m_jobs);
+
+	Stmt* Parse(Arena& arena); // same tree and same (first) error as the serial parser
+
+private:
+	// part of the token vector, ends with END_OF_FILE on the line of the token that follows
+	class TokenRange : public TokenSource
+	{
+	public:
+		TokenRange(const std::vector<Token>& m_tokens, size_t m_begin, size_t m_end);
+
+		Token NextToken() override;
+		void Skip(size_t count) override;
+
+	private:
+		const std::vector<Token>& tokens;
+		size_t next;
+		size_t end;
+		Token eof;
+	};
+
+	std::vector<std::pair<size_t, size_t>> FindDeclarations() const;
+	size_t FindDeclarationEnd(size_t begin) const;
+
+	ParallelLexer& lexer;
+	unsigned jobs;
+};
+
+#endif // !PARALLELPARSER_HPP
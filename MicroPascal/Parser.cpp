@@ -1,53 +1,102 @@
+#include <algorithm>
+
 #include "Parser.hpp"
 #include "Error.hpp"
 
-Parser::Parser(std::vector<Token>& m_tokens) : tokens(m_tokens) {};
+Parser::Parser(TokenSource& m_source, Arena& m_arena) : source(m_source), arena(m_arena) {};
+
+Parser::Parser(TokenSource& m_source, Arena& m_arena, std::unordered_map<size_t, PreparedDecl> m_prepared)
+    : source(m_source), arena(m_arena), prepared(std::move(m_prepared)) {};
+
+Stmt* Parser::Parse()
+{
+    return Program(nullptr);
+}
 
-std::unique_ptr<Stmt> Parser::Parse()
+Stmt* Parser::Parse(std::vector<SourceRange>& declaration_ranges)
 {
-    return Program();
+    return Program(&declaration_ranges);
+}
+
+Stmt* Parser::ParseDeclaration()
+{
+    Stmt* decl_stmt = Declaration();
+
+    if (!IsAtEnd())
+    {
+        throw Error(GetCurrTok().line_num, "EOF expected.");
+    }
+    return decl_stmt;
+}
+
+Span<Stmt*> Parser::ParseDeclarations(std::vector<SourceRange>& declaration_ranges)
+{
+    Span<Stmt*> decl_stmts = Declarations(&declaration_ranges);
+
+    if (!IsAtEnd())
+    {
+        throw Error(GetCurrTok().line_num, "declaration expected.");
+    }
+    return decl_stmts;
 }
 
 
 // program -> "program" IDENTIFIER ";" declaration* compoundStmt "." EOF;
-std::unique_ptr<Stmt> Parser::Program()
+Stmt* Parser::Program(std::vector<SourceRange>* declaration_ranges)
 {
     // header
     Eat(TokenType::PROGRAM, "'program' expected.");
     
-    std::string id = Eat(TokenType::ID, "identifier expected.").lexeme;
+    SymbolId id = Eat(TokenType::ID, "identifier expected.").symbol;
 
     Eat(TokenType::SEMICOLON, "';' expected.");
 
     // declarations
-    std::vector<std::shared_ptr<Stmt>> decl_stmts = Declarations();
+    Span<Stmt*> decl_stmts = Declarations(declaration_ranges);
     
     // comp. stmt
-    std::unique_ptr<Stmt> comp_stmt = CompoundStatement();
+    Stmt* comp_stmt = CompoundStatement();
     Eat(TokenType::DOT, "'.' expected.");
 
     if (!IsAtEnd()) // to avoid some "code" after '.'
     {
         throw Error(GetCurrTok().line_num, "EOF expected.");
     }
-    return std::make_unique<ProgramStmt>(id, std::move(comp_stmt), std::move(decl_stmts));
+    return arena.New<ProgramStmt>(id, comp_stmt, decl_stmts);
 }
 
 
 // declaration*
-std::vector<std::shared_ptr<Stmt>> Parser::Declarations()
+Span<Stmt*> Parser::Declarations(std::vector<SourceRange>* ranges)
 {
-    std::vector<std::shared_ptr<Stmt>> decl_stmts{};
+    size_t base = statements.size();
     while (CurrTokIs(TokenType::VAR) || CurrTokIs(TokenType::PROCEDURE) || CurrTokIs(TokenType::FUNCTION))
     {
-        decl_stmts.push_back(Declaration());
+        SourceLoc begin = GetCurrTok().loc;
+        statements.push_back(Declaration());
+
+        if (ranges != nullptr)
+        {
+            Token& last = GetPrevTok();
+            ranges->push_back({ begin, SourceLoc{ static_cast<uint32_t>(last.loc.offset + last.lexeme.size()) } });
+        }
     }
-    return decl_stmts;
+    return PopStatements(base);
 }
 
 // declaration -> procDecl | funcDecl | varDecl;
-std::shared_ptr<Stmt> Parser::Declaration()
+Stmt* Parser::Declaration()
 {
+    if (!prepared.empty())
+    {
+        auto found = prepared.find(curr_tok_num);
+        if (found != prepared.end())
+        {
+            SkipTo(found->second.end);
+            return found->second.stmt;
+        }
+    }
+
     switch (GetCurrTok().type)
     {
     case TokenType::PROCEDURE:
@@ -62,11 +111,11 @@ std::shared_ptr<Stmt> Parser::Declaration()
 }
 
 // procDecl -> "procedure" IDENTIFIER parameterList? ";" declaration* compoundStmt ";";
-std::shared_ptr<Stmt> Parser::ProcDecl()
+Stmt* Parser::ProcDecl()
 {
     Eat(TokenType::PROCEDURE, "'procedure' expected.");
-    Token id_token = Eat(TokenType::ID, "identifier expected.");
-    std::vector<std::pair<Token, VariableType>> parameter_list{};
+    Identifier id = EatIdentifier();
+    Span<std::pair<Identifier, VariableType>> parameter_list;
 
     // check for parameter list
     if (GetCurrTok().type == TokenType::LEFT_PAR)
@@ -77,23 +126,23 @@ std::shared_ptr<Stmt> Parser::ProcDecl()
     Eat(TokenType::SEMICOLON, "';' expected.");
 
     // declarations
-    std::vector<std::shared_ptr<Stmt>> decl_stmts = Declarations();
+    Span<Stmt*> decl_stmts = Declarations();
 
     // body
-    std::unique_ptr<Stmt> body = CompoundStatement();
+    Stmt* body = CompoundStatement();
 
     Eat(TokenType::SEMICOLON, "';' expected.");
 
-    return std::make_shared<ProcDeclStmt>(id_token, std::move(body), std::move(decl_stmts), std::move(parameter_list));
+    return arena.New<ProcDeclStmt>(id, body, decl_stmts, parameter_list);
 }
 
 // funcDecl -> "function" IDENTIFIER parameterList? ":" type ";" declaration* compoundStmt ";";
-std::shared_ptr<Stmt> Parser::FuncDecl()
+Stmt* Parser::FuncDecl()
 {
     Eat(TokenType::FUNCTION, "'function' expected.");
-    Token id_token = Eat(TokenType::ID, "identifier expected.");
+    Identifier id = EatIdentifier();
 
-    std::vector<std::pair<Token, VariableType>> parameter_list{};
+    Span<std::pair<Identifier, VariableType>> parameter_list;
 
     // check for parameter list
     if (GetCurrTok().type == TokenType::LEFT_PAR)
@@ -124,22 +173,21 @@ std::shared_ptr<Stmt> Parser::FuncDecl()
     Eat(TokenType::SEMICOLON, "';' expected.");
 
     // declarations
-    std::vector<std::shared_ptr<Stmt>> decl_stmts = Declarations();
+    Span<Stmt*> decl_stmts = Declarations();
 
     // body
-    std::unique_ptr<Stmt> body = CompoundStatement();
+    Stmt* body = CompoundStatement();
 
     Eat(TokenType::SEMICOLON, "';' expected.");
 
-    return std::make_shared<FuncDeclStmt>(id_token, return_type, std::move(body), std::move(decl_stmts), std::move(parameter_list));
+    return arena.New<FuncDeclStmt>(id, return_type, body, decl_stmts, parameter_list);
 }
 
 // varDecl -> "var" (identifierList ":" type ";")+ ;
-std::shared_ptr<Stmt> Parser::VarDecl()
+Stmt* Parser::VarDecl()
 {
     Eat(TokenType::VAR, "'var' expected.");
-    std::unordered_map<VariableType, std::vector<Token>> variables;
-
+    size_t base = identifiers.size();
 
     // no identifier found
     if (!CurrTokIs(TokenType::ID))
@@ -150,7 +198,8 @@ std::shared_ptr<Stmt> Parser::VarDecl()
     VariableType type;
     while (GetCurrTok().type == TokenType::ID)
     {
-        std::vector<Token> tokens = IdentifierList();
+        size_t first = identifiers.size();
+        IdentifierList();
 
         Eat(TokenType::COLON, "':' expected.");
 
@@ -170,22 +219,18 @@ std::shared_ptr<Stmt> Parser::VarDecl()
         }
         Advance();
 
-        if (variables.find(type) != variables.end()) // type_id is already there
+        for (size_t i = first; i < identifiers.size(); i++)
         {
-            variables[type].insert(variables[type].end(), tokens.begin(), tokens.end()); // add variables to the same type key
-        }
-        else // type_id denotes a new type
-        {
-            variables[type] = tokens;
+            identifiers[i].second = type;
         }
         Eat(TokenType::SEMICOLON, "';' expected.");
     }
-    return std::make_shared<VarDeclStmt>(variables);
+    return arena.New<VarDeclStmt>(PopVariables(base));
 }
 
 
 // statement -> writelnStmt | procedureStmt | compoundStmt | ifStmt | forStmt | whileStmt | assignStmt | emptyStmt;
-std::unique_ptr<Stmt> Parser::Statement()
+Stmt* Parser::Statement()
 {
     switch (GetCurrTok().type)
     {
@@ -212,31 +257,31 @@ std::unique_ptr<Stmt> Parser::Statement()
 }
 
 // writelnStmt -> "writeln" "(" exprList? ")";
-std::unique_ptr<Stmt> Parser::WritelnStatement()
+Stmt* Parser::WritelnStatement()
 {
     Eat(TokenType::WRITELN, "'writeln' expected.");
     Eat(TokenType::LEFT_PAR, "'(' expected.");
 
-    std::vector<std::unique_ptr<Expr>> exprs{};
+    Span<Expr*> exprs;
 
     // no expr list (i.e. empty)
     if (CurrTokIs(TokenType::RIGHT_PAR))
     {
         Advance(); // skip the ')'
-        return std::make_unique<WritelnStmt>(std::move(exprs));
+        return arena.New<WritelnStmt>(exprs);
     }
 
     exprs = ExprList();
 
     Eat(TokenType::RIGHT_PAR, "')' expected.");
-    return std::make_unique<WritelnStmt>(std::move(exprs));
+    return arena.New<WritelnStmt>(exprs);
 }
 
 // procedureStmt -> IDENTIFIER ("(" exprList ")")?;
-std::unique_ptr<Stmt> Parser::ProcStmt()
+Stmt* Parser::ProcStmt()
 {
-    Token id_token = Eat(TokenType::ID, "identifier expected.");
-    std::vector<std::unique_ptr<Expr>> exprs{};
+    Identifier id = EatIdentifier();
+    Span<Expr*> exprs;
 
     // call with arg list
     if (CurrTokIs(TokenType::LEFT_PAR))
@@ -247,7 +292,7 @@ std::unique_ptr<Stmt> Parser::ProcStmt()
         if (CurrTokIs(TokenType::RIGHT_PAR))
         {
             Advance(); // skip the ')'
-            return std::make_unique<ProcedureCallStmt>(std::move(exprs), id_token);
+            return arena.New<ProcedureCallStmt>(exprs, id);
         }
 
         exprs = ExprList();
@@ -255,50 +300,50 @@ std::unique_ptr<Stmt> Parser::ProcStmt()
         Eat(TokenType::RIGHT_PAR, "')' expected.");
     }
 
-    return std::make_unique<ProcedureCallStmt>(std::move(exprs), id_token);
+    return arena.New<ProcedureCallStmt>(exprs, id);
 }
 
 // compoundStmt -> "begin" statementList "end";
-std::unique_ptr<Stmt> Parser::CompoundStatement()
+Stmt* Parser::CompoundStatement()
 {
     Eat(TokenType::BEGIN, "'begin' expected.");
-    std::vector<std::unique_ptr<Stmt>> statement_list = StatementList();
+    Span<Stmt*> statement_list = StatementList();
     Eat(TokenType::END, "';' expected."); // end not found -> there should have been ';' separating statements
 
-    return std::make_unique<CompoundStmt>(std::move(statement_list));
+    return arena.New<CompoundStmt>(statement_list);
 }
 
 // ifStmt -> "if" expression "then" statement ("else" statement)?;
-std::unique_ptr<Stmt> Parser::IfStatement()
+Stmt* Parser::IfStatement()
 {
-    Token if_tok = Eat(TokenType::IF, "'if' expected.");
-    std::unique_ptr<Expr> condition = Expression();
+    SourceLoc loc = Eat(TokenType::IF, "'if' expected.").loc;
+    Expr* condition = Expression();
 
     Eat(TokenType::THEN, "'then' expected.");
-    std::unique_ptr<Stmt> then_branch = Statement();
+    Stmt* then_branch = Statement();
 
     if (CurrTokIs(TokenType::ELSE))
     {
         Eat(TokenType::ELSE, "'else' expected.");
-        std::unique_ptr<Stmt> else_branch = Statement();
+        Stmt* else_branch = Statement();
 
-        return std::make_unique<IfStmt>(if_tok, std::move(condition), std::move(then_branch), std::move(else_branch));
+        return arena.New<IfStmt>(loc, condition, then_branch, else_branch);
     }
-    return std::make_unique<IfStmt>(if_tok, std::move(condition), std::move(then_branch), std::nullopt);
+    return arena.New<IfStmt>(loc, condition, then_branch, nullptr);
 }
 
 // forStmt -> "for" assignStmt("to" | "downto") expression "do" statement;
-std::unique_ptr<Stmt> Parser::ForStatement()
+Stmt* Parser::ForStatement()
 {
-    Token for_tok = Eat(TokenType::FOR, "'for' expected.");
+    SourceLoc loc = Eat(TokenType::FOR, "'for' expected.").loc;
     if (!CurrTokIs(TokenType::ID))
     {
         throw Error(GetCurrTok().line_num, "identifier expected.");
     }
 
-    Token it_variable_tok = GetCurrTok(); // id of iterator variable
+    Identifier it_variable = { GetCurrTok().symbol, GetCurrTok().loc }; // id of iterator variable
 
-    std::unique_ptr<Stmt> assignment = AssignmentStatement();
+    Stmt* assignment = AssignmentStatement();
 
     // increment or decrement check
     bool increment;
@@ -316,181 +361,219 @@ std::unique_ptr<Stmt> Parser::ForStatement()
     }
     Advance();
 
-    std::unique_ptr<Expr> expression = Expression();
+    Expr* expression = Expression();
 
     Eat(TokenType::DO, "'do' expected.");
-    std::unique_ptr<Stmt> body = Statement();
+    Stmt* body = Statement();
 
-    return std::make_unique<ForStmt>(for_tok, increment, it_variable_tok, std::move(assignment), std::move(expression), std::move(body));
+    return arena.New<ForStmt>(loc, increment, it_variable, assignment, expression, body);
 }
 
 // whileStmt -> "while" expression "do" statement;
-std::unique_ptr<Stmt> Parser::WhileStatement()
+Stmt* Parser::WhileStatement()
 {
-    Token while_tok = Eat(TokenType::WHILE, "'while' expected.");
-    std::unique_ptr<Expr> condition = Expression();
+    SourceLoc loc = Eat(TokenType::WHILE, "'while' expected.").loc;
+    Expr* condition = Expression();
 
     Eat(TokenType::DO, "'do' expected.");
-    std::unique_ptr<Stmt> body = Statement();
+    Stmt* body = Statement();
 
-    return std::make_unique<WhileStmt>(while_tok, std::move(condition), std::move(body));
+    return arena.New<WhileStmt>(loc, condition, body);
 }
 
 // assignStmt -> IDENTIFIER ":=" expression;
-std::unique_ptr<Stmt> Parser::AssignmentStatement()
+Stmt* Parser::AssignmentStatement()
 {
-    Token id = Eat(TokenType::ID, "identifier expected.");
+    Identifier id = EatIdentifier();
     Eat(TokenType::ASSIGN, "':=' expected.");
-    std::unique_ptr<Expr> value = Expression();
+    Expr* value = Expression();
 
-    return std::make_unique<AssignmentStmt>(id, std::move(value));
+    return arena.New<AssignmentStmt>(id, value);
 }
 
 // emptyStmt -> ;
-std::unique_ptr<Stmt> Parser::EmptyStatement()
+Stmt* Parser::EmptyStatement()
 {
-    return std::make_unique<EmptyStmt>();
+    return arena.New<EmptyStmt>();
 }
 
 
 // expression -> simpleExpr ((">=" | "<=" | "<>" | "=" | ">" | "<") simpleExpr)?;
-std::unique_ptr<Expr> Parser::Expression()
-{
-    const std::vector<TokenType> operators
-    {
-        TokenType::GREATER_EQUAL,
-        TokenType::LESS_EQUAL,
-        TokenType::GREATER,
-        TokenType::LESS,
-        TokenType::EQUAL,
-        TokenType::NOT_EQUAL
-    };
-
-    std::unique_ptr<Expr> expr = SimpleExpr();
-    if (CurrMatchWith(operators))
-    {
-        Token op = GetPrevTok();
-        std::unique_ptr<Expr> right = SimpleExpr();
-        return std::make_unique<BinaryExpr>(std::move(expr), std::move(right), op);
-    }
-    return expr;
-}
-
 // simpleExpr -> term (("+" | "-" | "or") term)*;
-std::unique_ptr<Expr> Parser::SimpleExpr()
-{
-    const std::vector<TokenType> operators
-    {
-        TokenType::PLUS,
-        TokenType::MINUS,
-        TokenType::OR
-    };
-
-    std::unique_ptr<Expr> term = Term();
-
-    while (CurrMatchWith(operators))
-    {
-        Token op = GetPrevTok();
-        std::unique_ptr<Expr> right = Term();
-        term = std::make_unique<BinaryExpr>(std::move(term), std::move(right), op);
-    }
-    return term;
-}
-
 // term -> factor (("*" | "div" | "and") factor)*;
-std::unique_ptr<Expr> Parser::Term()
+// factor -> ("+" | "-" | "not") factor | INTEGER | STRING | "true" | "false" | "(" expression ")" | IDENTIFIER | functionExpr;
+// functionExpr -> IDENTIFIER ("(" exprList ")")?;
+// parsed by operator precedence with explicit stacks -> nesting depth is not limited by the C++ stack, each token is handled once
+Expr* Parser::Expression()
 {
-    const std::vector<TokenType> operators
-    {
-        TokenType::MUL,
-        TokenType::DIV,
-        TokenType::AND
-    };
-
-    std::unique_ptr<Expr> factor = Factor();
+    PushFrame(ExprFrame::WHOLE);
+    bool expect_operand = true;
 
-    while (CurrMatchWith(operators))
+    while (true)
     {
-        Token op = GetPrevTok();
-        std::unique_ptr<Expr> right = Factor();
-        factor = std::make_unique<BinaryExpr>(std::move(factor), std::move(right), op);
-    }
-    return factor;
-}
+        ExprFrame& frame = expr_frames.back();
 
-// factor -> ("+" | "-" | "not") factor | INTEGER | STRING | "true" | "false" | "(" expression ")" | IDENTIFIER | functionExpr;
-std::unique_ptr<Expr> Parser::Factor()
-{
-    // ("+" | "-" | "not") factor
-    if (CurrTokIs(TokenType::PLUS) || CurrTokIs(TokenType::MINUS) || CurrTokIs(TokenType::NOT))
-    {
-        Token op = Eat(GetCurrTok().type, "unary operator expected."); // will not throw
-        std::unique_ptr<Expr> fact = Factor();
-        return std::make_unique<UnaryExpr>(std::move(fact), op);
-    }
+        if (expect_operand)
+        {
+            // ("+" | "-" | "not") factor
+            if (CurrTokIs(TokenType::PLUS) || CurrTokIs(TokenType::MINUS) || CurrTokIs(TokenType::NOT))
+            {
+                Advance(); // skip the operator
+                operators.push_back({ GetPrevTok().type, GetPrevTok().loc, unary_precedence });
+            }
+            // INTEGER | STRING | "true" | "false"
+            else if (CurrTokIs(TokenType::INTEGER_VAL) || CurrTokIs(TokenType::STRING_VAL) || CurrTokIs(TokenType::TRUE) || CurrTokIs(TokenType::FALSE))
+            {
+                Advance(); // skip the value
+                operands.push_back(arena.New<LiteralExpr>(LiteralValue(GetPrevTok())));
+                expect_operand = false;
+            }
+            // "(" expression ")"
+            else if (CurrTokIs(TokenType::LEFT_PAR))
+            {
+                Advance(); // skip the '('
+                PushFrame(ExprFrame::GROUPING);
+            }
+            // functionExpr -> IDENTIFIER ("(" exprList ")")?;
+            else if (GetCurrTok().type == TokenType::ID && NextTokIs(TokenType::LEFT_PAR))
+            {
+                Identifier id = EatIdentifier();
+                Advance(); // skip the '('
+
+                // no expr list (i.e. empty)
+                if (CurrTokIs(TokenType::RIGHT_PAR))
+                {
+                    Advance(); // skip the ')'
+                    operands.push_back(arena.New<FunctionCallExpr>(Span<Expr*>(), id));
+                    expect_operand = false;
+                }
+                else
+                {
+                    PushFrame(ExprFrame::ARGUMENTS);
+                    expr_frames.back().id = id;
+                }
+            }
+            // IDENTIFIER -> still may be a function call! -> interpreter handles this, parser cannot distinguish
+            else if (GetCurrTok().type == TokenType::ID)
+            {
+                operands.push_back(arena.New<VariableExpr>(EatIdentifier()));
+                expect_operand = false;
+            }
+            else
+            {
+                throw Error(GetCurrTok().line_num, "expression expected.");
+            }
+            continue;
+        }
 
-    // INTEGER | STRING | "true" | "false"
-    if (CurrTokIs(TokenType::INTEGER_VAL) || CurrTokIs(TokenType::STRING_VAL) || CurrTokIs(TokenType::TRUE) || CurrTokIs(TokenType::FALSE))
-    {
-        Advance(); // skip the value
-        return std::make_unique<LiteralExpr>(std::move(GetPrevTok().lit));
-    }
+        // binary operator -> operators that bind at least as tight are done (left associative)
+        int precedence = Precedence(GetCurrTok().type);
+        if (precedence != 0 && !(precedence == relational_precedence && frame.relational))
+        {
+            Reduce(frame, precedence);
+            frame.relational = frame.relational || precedence == relational_precedence;
+            Advance(); // skip the operator
+            operators.push_back({ GetPrevTok().type, GetPrevTok().loc, precedence });
+            expect_operand = true;
+            continue;
+        }
 
-    // "(" expression ")"
-    if (CurrTokIs(TokenType::LEFT_PAR))
-    {
-        Advance(); // skip the ')'
-        std::unique_ptr<Expr> expr = Expression();
-        Eat(TokenType::RIGHT_PAR, "')' expected after expression.");
-        return std::make_unique<GroupingExpr>(std::move(expr));
-    }
+        // end of the expression in this frame
+        Reduce(frame, 0);
 
-    // IDENTIFIER
-    if (GetCurrTok().type == TokenType::ID)
-    {
-        // functionExpr
-        if (NextTokIs(TokenType::LEFT_PAR))
+        // exprList -> expression ("," expression)*; -> arguments stay on the operand stack until the call is complete
+        if (frame.kind == ExprFrame::ARGUMENTS && CurrTokIs(TokenType::COMMA))
         {
-            return FuncExpr();
+            Advance(); // skip the comma
+            frame.relational = false;
+            expect_operand = true;
+            continue;
         }
 
-        // returns variable expression -> still may be a function call! -> interpreter handles this, parser cannot distinguish
-        return std::make_unique<VariableExpr>(Eat(TokenType::ID, "identifier expected."));
-    }
+        Expr* expr;
+        if (frame.kind == ExprFrame::WHOLE)
+        {
+            expr = operands.back();
+            operands.pop_back();
+            expr_frames.pop_back();
+            return expr;
+        }
+        if (frame.kind == ExprFrame::GROUPING)
+        {
+            Eat(TokenType::RIGHT_PAR, "')' expected after expression.");
+            expr = arena.New<GroupingExpr>(operands.back());
+            operands.pop_back();
+        }
+        else
+        {
+            Eat(TokenType::RIGHT_PAR, "')' expected.");
+            expr = arena.New<FunctionCallExpr>(PopOperands(frame.operands_base), frame.id);
+        }
 
-    throw Error(GetCurrTok().line_num, "expression expected.");
+        // finished frame is an operand of the enclosing one
+        expr_frames.pop_back();
+        operands.push_back(expr);
+    }
 }
 
-// functionExpr -> IDENTIFIER ("(" exprList ")")?;
-std::unique_ptr<Expr> Parser::FuncExpr()
+// precedence of binary operator, 0 if token is not one
+int Parser::Precedence(TokenType token_type)
 {
-    Token id_token = Eat(TokenType::ID, "identifier expected.");
-    std::vector<std::unique_ptr<Expr>> exprs{};
-
-    if (!CurrTokIs(TokenType::LEFT_PAR)) // function can be called also without the () part (e.g. f() == f)
+    switch (token_type)
     {
-        return std::make_unique<FunctionCallExpr>(std::move(exprs), id_token);
+    case TokenType::GREATER_EQUAL:
+    case TokenType::LESS_EQUAL:
+    case TokenType::GREATER:
+    case TokenType::LESS:
+    case TokenType::EQUAL:
+    case TokenType::NOT_EQUAL:
+        return relational_precedence;
+    case TokenType::PLUS:
+    case TokenType::MINUS:
+    case TokenType::OR:
+        return relational_precedence + 1;
+    case TokenType::MUL:
+    case TokenType::DIV:
+    case TokenType::AND:
+        return relational_precedence + 2;
+    default:
+        return 0;
     }
+}
 
-    Advance(); // skip the '('
+void Parser::PushFrame(ExprFrame::Kind kind)
+{
+    expr_frames.emplace_back();
+    expr_frames.back().kind = kind;
+    expr_frames.back().operands_base = operands.size();
+    expr_frames.back().operators_base = operators.size();
+}
 
-    // no expr list (i.e. empty)
-    if (CurrTokIs(TokenType::RIGHT_PAR))
+// builds nodes of pending operators of the frame with at least passed precedence
+void Parser::Reduce(const ExprFrame& frame, int min_precedence)
+{
+    while (operators.size() > frame.operators_base && operators.back().precedence >= min_precedence)
     {
-        Advance(); // skip the ')'
-        return std::make_unique<FunctionCallExpr>(std::move(exprs), id_token);
-    }
-
-    exprs = ExprList();
+        PendingOperator op = operators.back();
+        operators.pop_back();
 
-    Eat(TokenType::RIGHT_PAR, "')' expected.");
-
-    return std::make_unique<FunctionCallExpr>(std::move(exprs), id_token);
+        Expr* right = operands.back();
+        operands.pop_back();
+        if (op.precedence == unary_precedence)
+        {
+            operands.push_back(arena.New<UnaryExpr>(right, op.type, op.loc));
+        }
+        else
+        {
+            Expr* left = operands.back();
+            operands.back() = arena.New<BinaryExpr>(left, right, op.type, op.loc);
+        }
+    }
 }
 
 
 // parameterList -> "(" (identifierList ":" type (";" identifierList ":" type)*)? ")";
-std::vector<std::pair<Token, VariableType>> Parser::ParameterList()
+Span<std::pair<Identifier, VariableType>> Parser::ParameterList()
 {
     Eat(TokenType::LEFT_PAR, "'(' expected.");
 
@@ -498,16 +581,15 @@ std::vector<std::pair<Token, VariableType>> Parser::ParameterList()
     if (!CurrTokIs(TokenType::ID))
     {
         Eat(TokenType::RIGHT_PAR, "')' expected.");
-        return {}; // return empty vector of parameters
+        return {}; // no parameters
     }
 
-    std::vector<Token> identifiers;
-    std::vector<std::pair<Token, VariableType>> parameter_list{};
-
+    size_t base = identifiers.size();
     do
     {
         // get ids
-        identifiers = IdentifierList();
+        size_t first = identifiers.size();
+        IdentifierList();
         Eat(TokenType::COLON, "':' expected.");
 
         // get type
@@ -528,68 +610,151 @@ std::vector<std::pair<Token, VariableType>> Parser::ParameterList()
         }
         Advance(); // skip type
 
-        // put all into parameter list
-        for (auto&& identifier : identifiers)
+        for (size_t i = first; i < identifiers.size(); i++)
         {
-            parameter_list.push_back(std::make_pair(identifier, type));
+            identifiers[i].second = type;
         }
 
     } while (CurrMatchWith(TokenType::SEMICOLON));
 
     Eat(TokenType::RIGHT_PAR, "')' expected.");
-    return parameter_list;
+
+    Span<std::pair<Identifier, VariableType>> parameters = arena.Copy(identifiers.data() + base, identifiers.size() - base);
+    identifiers.resize(base);
+    return parameters;
 }
 
-// identifierList -> IDENTIFIER ("," IDENTIFIER)*;
-std::vector<Token> Parser::IdentifierList()
+// identifierList -> IDENTIFIER ("," IDENTIFIER)*; -> pushed to identifiers, type gets set by caller
+void Parser::IdentifierList()
 {
-    std::vector<Token> tokens;
-    tokens.push_back(Eat(TokenType::ID, "identifier expected."));
+    identifiers.emplace_back(EatIdentifier(), VariableType::INTEGER);
     while (CurrTokIs(TokenType::COMMA))
     {
         Advance(); // skip the comma
-        tokens.push_back(Eat(TokenType::ID, "identifier expected."));
+        identifiers.emplace_back(EatIdentifier(), VariableType::INTEGER);
+    }
+}
+
+// moves variables (from base on) into the arena grouped by type, most recently introduced type first
+// -> order in which they have always been defined (duplicates get reported on the same line)
+Span<std::pair<Identifier, VariableType>> Parser::PopVariables(size_t base)
+{
+    size_t end = identifiers.size();
+
+    VariableType types[3]; // integer, bool, string in order of first appearance
+    size_t type_count = 0;
+    for (size_t i = base; i < end; i++)
+    {
+        if (std::find(types, types + type_count, identifiers[i].second) == types + type_count)
+        {
+            types[type_count++] = identifiers[i].second;
+        }
+    }
+
+    // grouped copy goes on top of the stack first
+    for (size_t t = type_count; t-- > 0;)
+    {
+        for (size_t i = base; i < end; i++)
+        {
+            if (identifiers[i].second == types[t])
+            {
+                identifiers.push_back(identifiers[i]);
+            }
+        }
     }
-    return tokens;
+
+    Span<std::pair<Identifier, VariableType>> grouped = arena.Copy(identifiers.data() + end, identifiers.size() - end);
+    identifiers.resize(base);
+    return grouped;
 }
 
 // statementList -> statement (";" statement)*;
-std::vector<std::unique_ptr<Stmt>> Parser::StatementList()
+Span<Stmt*> Parser::StatementList()
 {
-    std::vector<std::unique_ptr<Stmt>> statement_list;
-    statement_list.push_back(Statement());
+    size_t base = statements.size();
+    statements.push_back(Statement());
     while (CurrTokIs(TokenType::SEMICOLON))
     {
         Advance(); // skip the semi
-        statement_list.push_back(Statement());
+        statements.push_back(Statement());
     }
-    return statement_list;
+    return PopStatements(base);
 }
 
 // exprList -> expression ("," expression)*;
-std::vector<std::unique_ptr<Expr>> Parser::ExprList()
+Span<Expr*> Parser::ExprList()
 {
-    std::vector<std::unique_ptr<Expr>> exprs;
-
-    exprs.push_back(Expression());
+    size_t base = operands.size();
+    operands.push_back(Expression());
 
     while (CurrTokIs(TokenType::COMMA))
     {
         Advance(); // skip the comma
-        exprs.push_back(Expression());
+        operands.push_back(Expression());
     }
-    return exprs;
+    return PopOperands(base);
 }
 
+// moves top of the stack (from base on) into the arena
+Span<Stmt*> Parser::PopStatements(size_t base)
+{
+    Span<Stmt*> popped = arena.Copy(statements.data() + base, statements.size() - base);
+    statements.resize(base);
+    return popped;
+}
+
+Span<Expr*> Parser::PopOperands(size_t base)
+{
+    Span<Expr*> popped = arena.Copy(operands.data() + base, operands.size() - base);
+    operands.resize(base);
+    return popped;
+}
+
+// value of literal token, computed from its lexeme (view into source)
+Literal Parser::LiteralValue(const Token& token)
+{
+    switch (token.type)
+    {
+    case TokenType::INTEGER_VAL:
+    {
+        int number = 0;
+        for (char digit : token.lexeme)
+        {
+            number = 10 * number + (digit - '0');
+        }
+        return number;
+    }
+    case TokenType::STRING_VAL:
+        return std::string(token.lexeme.substr(1, token.lexeme.size() - 2)); // cut ' chars
+    case TokenType::TRUE:
+        return true;
+    case TokenType::FALSE:
+        return false;
+    default:
+        throw Error(token.line_num, "literal expected.");
+    }
+}
+
+
+// token with given absolute index, must not be older than window_size - 1 tokens behind the newest one
+Token& Parser::TokenAt(size_t index)
+{
+    while (fetched <= index)
+    {
+        window[fetched & (window_size - 1)] = source.NextToken();
+        fetched++;
+    }
+    return window[index & (window_size - 1)];
+}
 
 Token& Parser::GetCurrTok()
 {
-    return tokens[curr_tok_num];
+    return TokenAt(curr_tok_num);
 }
 
 Token& Parser::GetPrevTok()
 {
-    return tokens[curr_tok_num - 1];
+    return TokenAt(curr_tok_num - 1);
 }
 
 
@@ -610,12 +775,12 @@ bool Parser::NextTokIs(TokenType token_type)
     {
         return false;
     }
-    return tokens[curr_tok_num + 1].type == token_type;
+    return TokenAt(curr_tok_num + 1).type == token_type;
 }
 
 
 // checks for type among passed types and advances on match
-bool Parser::CurrMatchWith(std::vector<TokenType> token_types)
+bool Parser::CurrMatchWith(std::initializer_list<TokenType> token_types)
 {
     for (auto&& token_type : token_types)
     {
@@ -641,7 +806,7 @@ bool Parser::CurrMatchWith(TokenType token_type)
 
 
 // advances if meets expected token and returns it, otherwise throws with passed message 
-Token Parser::Eat(TokenType expected_type, std::string error_message)
+Token Parser::Eat(TokenType expected_type, const char* error_message)
 {
     if (CurrTokIs(expected_type))
     {
@@ -652,6 +817,13 @@ Token Parser::Eat(TokenType expected_type, std::string error_message)
     throw Error(GetCurrTok().line_num, error_message);
 }
 
+// identifier as kept in the tree
+Identifier Parser::EatIdentifier()
+{
+    Token id = Eat(TokenType::ID, "identifier expected.");
+    return { id.symbol, id.loc };
+}
+
 // move to next token
 void Parser::Advance()
 {
@@ -661,6 +833,17 @@ void Parser::Advance()
     }
 }
 
+// jump to token with passed number, tokens in between are not looked at
+void Parser::SkipTo(size_t index)
+{
+    if (index > fetched)
+    {
+        source.Skip(index - fetched);
+        fetched = index;
+    }
+    curr_tok_num = index;
+}
+
 bool Parser::IsAtEnd()
 {
     return GetCurrTok().type == TokenType::END_OF_FILE;
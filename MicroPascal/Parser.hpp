@@ -2,68 +2,124 @@
 #define PARSER_HPP
 
 #include <vector>
+#include <initializer_list>
 #include <memory>
 #include <string>
+#include <unordered_map>
 
 #include "Expr.hpp"
 #include "Stmt.hpp"
 #include "TokenType.hpp"
 #include "Token.hpp"
+#include "TokenSource.hpp"
 
 class Parser // syntactic analysis, creates AST, contains grammar rules
 {
 public:
-    Parser(std::vector<Token>& m_tokens);
-
-    std::unique_ptr<Stmt> Parse();
+    // declaration parsed elsewhere (i.e. on another thread) that covers tokens [start, end) of the source
+    struct PreparedDecl
+    {
+        Stmt* stmt;
+        size_t end;
+    };
+
+    // tokens get pulled on demand, nodes are allocated in the arena -> tree lives as long as it does
+    Parser(TokenSource& m_source, Arena& m_arena);
+    Parser(TokenSource& m_source, Arena& m_arena, std::unordered_map<size_t, PreparedDecl> m_prepared); // prepared ones get spliced in by start
+
+    Stmt* Parse();
+    Stmt* Parse(std::vector<SourceRange>& declaration_ranges); // also where each top level declaration is, from its first to its last token
+    Stmt* ParseDeclaration(); // source has to hold exactly one declaration
+    Span<Stmt*> ParseDeclarations(std::vector<SourceRange>& declaration_ranges); // source has to hold declarations only
 
 private:
-    std::unique_ptr<Stmt> Program();
-
-    std::vector<std::shared_ptr<Stmt>> Declarations();
-    std::shared_ptr<Stmt> Declaration();
-    std::shared_ptr<Stmt> ProcDecl();
-    std::shared_ptr<Stmt> FuncDecl();
-    std::shared_ptr<Stmt> VarDecl();
-
-    std::unique_ptr<Stmt> Statement();
-    std::unique_ptr<Stmt> WritelnStatement();
-    std::unique_ptr<Stmt> ProcStmt();
-    std::unique_ptr<Stmt> CompoundStatement();
-    std::unique_ptr<Stmt> IfStatement();
-    std::unique_ptr<Stmt> ForStatement();
-    std::unique_ptr<Stmt> WhileStatement();
-    std::unique_ptr<Stmt> AssignmentStatement();
-    std::unique_ptr<Stmt> EmptyStatement();
-
-    std::unique_ptr<Expr> Expression();
-    std::unique_ptr<Expr> SimpleExpr();
-    std::unique_ptr<Expr> Term();
-    std::unique_ptr<Expr> Factor();
-    std::unique_ptr<Expr> FuncExpr();
-
-    std::vector<std::pair<Token, VariableType>> ParameterList();
-    std::vector<Token> IdentifierList();
-    std::vector<std::unique_ptr<Stmt>> StatementList();
-    std::vector<std::unique_ptr<Expr>> ExprList();
-
-
+    Stmt* Program(std::vector<SourceRange>* declaration_ranges);
+
+    Span<Stmt*> Declarations(std::vector<SourceRange>* ranges = nullptr);
+    Stmt* Declaration();
+    Stmt* ProcDecl();
+    Stmt* FuncDecl();
+    Stmt* VarDecl();
+
+    Stmt* Statement();
+    Stmt* WritelnStatement();
+    Stmt* ProcStmt();
+    Stmt* CompoundStatement();
+    Stmt* IfStatement();
+    Stmt* ForStatement();
+    Stmt* WhileStatement();
+    Stmt* AssignmentStatement();
+    Stmt* EmptyStatement();
+
+    // unfinished part of an expression -> the whole one, one per open parenthesis and per argument list of a function call
+    struct ExprFrame
+    {
+        enum Kind { WHOLE, GROUPING, ARGUMENTS } kind;
+        size_t operands_base; // frame owns the tops of the shared stacks from here on, finished arguments included
+        size_t operators_base;
+        bool relational = false; // relational operators do not chain -> one per frame
+        Identifier id; // called function
+    };
+
+    Expr* Expression();
+    static constexpr int relational_precedence = 1;
+    static constexpr int unary_precedence = 4; // binds tighter than any binary operator
+    static int Precedence(TokenType token_type);
+    void PushFrame(ExprFrame::Kind kind);
+    void Reduce(const ExprFrame& frame, int min_precedence);
+
+    Span<std::pair<Identifier, VariableType>> ParameterList();
+    void IdentifierList();
+    Span<Stmt*> StatementList();
+    Span<Expr*> ExprList();
+    Span<Stmt*> PopStatements(size_t base);
+    Span<Expr*> PopOperands(size_t base);
+    Span<std::pair<Identifier, VariableType>> PopVariables(size_t base);
+
+    static Literal LiteralValue(const Token& token);
+
+
+    Token& TokenAt(size_t index);
     Token& GetCurrTok();
     Token& GetPrevTok();
 
     bool CurrTokIs(TokenType token_type);
     bool NextTokIs(TokenType token_type);
 
-    bool CurrMatchWith(std::vector<TokenType> token_types);
+    bool CurrMatchWith(std::initializer_list<TokenType> token_types);
     bool CurrMatchWith(TokenType token_type);
 
-    Token Eat(TokenType expected_type, std::string error_message);
+    Token Eat(TokenType expected_type, const char* error_message);
+    Identifier EatIdentifier();
     void Advance();
+    void SkipTo(size_t index);
     bool IsAtEnd();
     
 
-    std::vector<Token> tokens;
-    int curr_tok_num = 0;
+    TokenSource& source;
+    Arena& arena;
+
+    // ring buffer over the token stream -> parser only ever looks at previous, current and next token
+    static constexpr size_t window_size = 4; // power of two
+    Token window[window_size];
+    size_t fetched = 0; // number of tokens pulled from source so far
+    size_t curr_tok_num = 0;
+
+    std::unordered_map<size_t, PreparedDecl> prepared; // by number of the first token
+
+    // stacks of unfinished lists and expressions, kept between them -> no allocations once they have grown,
+    // finished lists get copied into the arena
+    std::vector<Stmt*> statements;
+    std::vector<std::pair<Identifier, VariableType>> identifiers; // of variable declaration or parameter list
+    std::vector<ExprFrame> expr_frames;
+    std::vector<Expr*> operands; // also arguments of calls and items of expression lists
+    struct PendingOperator
+    {
+        TokenType type;
+        SourceLoc loc;
+        int precedence;
+    };
+    std::vector<PendingOperator> operators;
 };
 
 #endif // !PARSER_HPP
\ No newline at end of file
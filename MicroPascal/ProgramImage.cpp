@@ -0,0 +1,902 @@
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <stdexcept>
+
+#include "ProgramImage.hpp"
+#include "SourceFile.hpp"
+
+// tags of records, each one is followed by the fields of its node -> children precede their parent
+enum NodeKind : uint32_t
+{
+	BINARY,
+	UNARY,
+	LITERAL,
+	GROUPING,
+	VARIABLE,
+	FUNCTION_CALL,
+	PROGRAM,
+	COMPOUND,
+	WRITELN,
+	EMPTY,
+	VAR_DECL,
+	FUNC_DECL,
+	PROC_DECL,
+	PROCEDURE_CALL,
+	ASSIGNMENT,
+	IF,
+	WHILE,
+	FOR
+};
+
+// header words: magic, version, source size, source hash, payload hash (64-bit ones as low and high word)
+static constexpr size_t header_words = 8;
+
+
+// walks the tree with an explicit stack -> depth of nesting is not limited by the C++ stack,
+// each node is visited twice: first to push its children, then to write its record
+class ImageWriter : public VisitorStmt, public VisitorExpr
+{
+public:
+	ImageWriter(std::vector<uint32_t>& m_words) : words(m_words) {}
+
+	void Write(Stmt* program);
+
+private:
+	struct Item
+	{
+		Stmt* stmt;
+		Expr* expr;
+		bool emit;
+	};
+
+	void Push(Stmt* stmt) { pending.push_back({ stmt, nullptr, false }); }
+	void Push(Expr* expr) { pending.push_back({ nullptr, expr, false }); }
+	template<typename T>
+	void PushAll(Span<T> nodes) // in reverse -> get written in order
+	{
+		for (size_t i = nodes.size(); i-- > 0;)
+		{
+			Push(nodes[i]);
+		}
+	}
+
+	void Put(uint32_t word) { words.push_back(word); }
+	void Put(Identifier id) { Put(id.symbol); Put(id.loc.offset); }
+	void Put(Span<std::pair<Identifier, VariableType>> variables);
+
+	Literal Visit(BinaryExpr& binExpr) override;
+	Literal Visit(UnaryExpr& unExpr) override;
+	Literal Visit(LiteralExpr& litExpr) override;
+	Literal Visit(GroupingExpr& grExpr) override;
+	Literal Visit(VariableExpr& varExpr) override;
+	Literal Visit(FunctionCallExpr& funcCallExpr) override;
+	Literal Visit([[maybe_unused]] InlinedCallExpr& inlinedCallExpr) override;
+
+	void Visit(ProgramStmt& programStmt) override;
+	void Visit(CompoundStmt& compoundStmt) override;
+	void Visit(WritelnStmt& writelnStmt) override;
+	void Visit(EmptyStmt& emptyStmt) override;
+	void Visit(VarDeclStmt& varDeclStmt) override;
+	void Visit(FuncDeclStmt& funcDeclStmt) override;
+	void Visit(AssignmentStmt& assignmentStmt) override;
+	void Visit(IfStmt& ifStmt) override;
+	void Visit(WhileStmt& whileStmt) override;
+	void Visit(ForStmt& forStmt) override;
+	void Visit(ProcDeclStmt& procDeclStmt) override;
+	void Visit(ProcedureCallStmt& procedureCallStmt) override;
+	void Visit([[maybe_unused]] InlinedCallStmt& inlinedCallStmt) override;
+
+	std::vector<uint32_t>& words;
+	std::vector<Item> pending;
+	bool emit = false; // current visit writes the record (otherwise pushes children)
+};
+
+void ImageWriter::Write(Stmt* program)
+{
+	Push(program);
+	while (!pending.empty())
+	{
+		Item item = pending.back();
+		pending.pop_back();
+
+		emit = item.emit;
+		if (item.stmt != nullptr)
+		{
+			if (!emit)
+			{
+				pending.push_back({ item.stmt, nullptr, true });
+			}
+			item.stmt->Accept(*this);
+		}
+		else
+		{
+			if (!emit)
+			{
+				pending.push_back({ nullptr, item.expr, true });
+			}
+			item.expr->Accept(*this);
+		}
+	}
+}
+
+void ImageWriter::Put(Span<std::pair<Identifier, VariableType>> variables)
+{
+	for (auto&& [identifier, type] : variables)
+	{
+		Put(identifier);
+		Put(static_cast<uint32_t>(type));
+	}
+}
+
+Literal ImageWriter::Visit(BinaryExpr& binExpr)
+{
+	if (emit)
+	{
+		Put(BINARY);
+		Put(static_cast<uint32_t>(binExpr.op));
+		Put(binExpr.loc.offset);
+		return nullptr;
+	}
+	Push(binExpr.right);
+	Push(binExpr.left);
+	return nullptr;
+}
+
+Literal ImageWriter::Visit(UnaryExpr& unExpr)
+{
+	if (emit)
+	{
+		Put(UNARY);
+		Put(static_cast<uint32_t>(unExpr.op));
+		Put(unExpr.loc.offset);
+		return nullptr;
+	}
+	Push(unExpr.right);
+	return nullptr;
+}
+
+Literal ImageWriter::Visit(LiteralExpr& litExpr)
+{
+	if (emit)
+	{
+		Put(LITERAL);
+		Put(static_cast<uint32_t>(litExpr.value.index()));
+		if (auto value = std::get_if<int>(&litExpr.value))
+		{
+			Put(static_cast<uint32_t>(*value));
+		}
+		else if (auto value = std::get_if<bool>(&litExpr.value))
+		{
+			Put(*value ? 1 : 0);
+		}
+		else if (auto value = std::get_if<std::string>(&litExpr.value))
+		{
+			Put(static_cast<uint32_t>(value->size()));
+			size_t first = words.size();
+			words.resize(first + (value->size() + 3) / 4, 0);
+			std::memcpy(words.data() + first, value->data(), value->size());
+		}
+	}
+	return nullptr;
+}
+
+Literal ImageWriter::Visit(GroupingExpr& grExpr)
+{
+	if (emit)
+	{
+		Put(GROUPING);
+		return nullptr;
+	}
+	Push(grExpr.expr);
+	return nullptr;
+}
+
+Literal ImageWriter::Visit(VariableExpr& varExpr)
+{
+	if (emit)
+	{
+		Put(VARIABLE);
+		Put(varExpr.id);
+	}
+	return nullptr;
+}
+
+Literal ImageWriter::Visit(FunctionCallExpr& funcCallExpr)
+{
+	if (emit)
+	{
+		Put(FUNCTION_CALL);
+		Put(funcCallExpr.id);
+		Put(static_cast<uint32_t>(funcCallExpr.exprs.size()));
+		return nullptr;
+	}
+	PushAll(funcCallExpr.exprs);
+	return nullptr;
+}
+
+void ImageWriter::Visit(ProgramStmt& programStmt)
+{
+	if (emit)
+	{
+		Put(PROGRAM);
+		Put(programStmt.id);
+		Put(static_cast<uint32_t>(programStmt.decl_stmts.size()));
+		return;
+	}
+	Push(programStmt.stmt);
+	PushAll(programStmt.decl_stmts);
+}
+
+void ImageWriter::Visit(CompoundStmt& compoundStmt)
+{
+	if (emit)
+	{
+		Put(COMPOUND);
+		Put(static_cast<uint32_t>(compoundStmt.statements.size()));
+		return;
+	}
+	PushAll(compoundStmt.statements);
+}
+
+void ImageWriter::Visit(WritelnStmt& writelnStmt)
+{
+	if (emit)
+	{
+		Put(WRITELN);
+		Put(static_cast<uint32_t>(writelnStmt.exprs.size()));
+		return;
+	}
+	PushAll(writelnStmt.exprs);
+}
+
+void ImageWriter::Visit([[maybe_unused]] EmptyStmt& emptyStmt)
+{
+	if (emit)
+	{
+		Put(EMPTY);
+	}
+}
+
+void ImageWriter::Visit(VarDeclStmt& varDeclStmt)
+{
+	if (emit)
+	{
+		Put(VAR_DECL);
+		Put(static_cast<uint32_t>(varDeclStmt.variables.size()));
+		Put(varDeclStmt.variables);
+	}
+}
+
+void ImageWriter::Visit(FuncDeclStmt& funcDeclStmt)
+{
+	if (emit)
+	{
+		Put(FUNC_DECL);
+		Put(funcDeclStmt.id);
+		Put(static_cast<uint32_t>(funcDeclStmt.return_type));
+		Put(static_cast<uint32_t>(funcDeclStmt.decl_stmts.size()));
+		Put(static_cast<uint32_t>(funcDeclStmt.parameters.size()));
+		Put(funcDeclStmt.parameters);
+		return;
+	}
+	Push(funcDeclStmt.body);
+	PushAll(funcDeclStmt.decl_stmts);
+}
+
+void ImageWriter::Visit(ProcDeclStmt& procDeclStmt)
+{
+	if (emit)
+	{
+		Put(PROC_DECL);
+		Put(procDeclStmt.id);
+		Put(static_cast<uint32_t>(procDeclStmt.decl_stmts.size()));
+		Put(static_cast<uint32_t>(procDeclStmt.parameters.size()));
+		Put(procDeclStmt.parameters);
+		return;
+	}
+	Push(procDeclStmt.body);
+	PushAll(procDeclStmt.decl_stmts);
+}
+
+void ImageWriter::Visit(ProcedureCallStmt& procedureCallStmt)
+{
+	if (emit)
+	{
+		Put(PROCEDURE_CALL);
+		Put(procedureCallStmt.id);
+		Put(static_cast<uint32_t>(procedureCallStmt.arguments.size()));
+		return;
+	}
+	PushAll(procedureCallStmt.arguments);
+}
+
+// images keep what the parser produced, inlining happens after loading them -> never written
+Literal ImageWriter::Visit([[maybe_unused]] InlinedCallExpr& inlinedCallExpr)
+{
+	return nullptr;
+}
+
+void ImageWriter::Visit([[maybe_unused]] InlinedCallStmt& inlinedCallStmt) {}
+
+void ImageWriter::Visit(AssignmentStmt& assignmentStmt)
+{
+	if (emit)
+	{
+		Put(ASSIGNMENT);
+		Put(assignmentStmt.id);
+		return;
+	}
+	Push(assignmentStmt.value);
+}
+
+void ImageWriter::Visit(IfStmt& ifStmt)
+{
+	if (emit)
+	{
+		Put(IF);
+		Put(ifStmt.loc.offset);
+		Put(ifStmt.else_branch != nullptr ? 1 : 0);
+		return;
+	}
+	if (ifStmt.else_branch != nullptr)
+	{
+		Push(ifStmt.else_branch);
+	}
+	Push(ifStmt.then_branch);
+	Push(ifStmt.condition);
+}
+
+void ImageWriter::Visit(WhileStmt& whileStmt)
+{
+	if (emit)
+	{
+		Put(WHILE);
+		Put(whileStmt.loc.offset);
+		return;
+	}
+	Push(whileStmt.body);
+	Push(whileStmt.condition);
+}
+
+void ImageWriter::Visit(ForStmt& forStmt)
+{
+	if (emit)
+	{
+		Put(FOR);
+		Put(forStmt.loc.offset);
+		Put(forStmt.increment ? 1 : 0);
+		Put(forStmt.id);
+		return;
+	}
+	Push(forStmt.body);
+	Push(forStmt.expression);
+	Push(forStmt.assignment);
+}
+
+
+// rebuilds nodes from records -> children are already on the stacks when their parent comes,
+// anything out of place means a damaged image
+class ImageReader
+{
+public:
+	ImageReader(std::string_view m_image, size_t m_pos, Arena& m_arena) : image(m_image), pos(m_pos), arena(m_arena) {}
+
+	void ReadSymbols(SymbolTable& symbols);
+	Stmt* ReadProgram();
+
+private:
+	bool AtEnd() const { return pos == image.size(); }
+	uint32_t Next();
+	std::string_view NextBytes(size_t count);
+	Identifier NextIdentifier();
+	VariableType NextType();
+	TokenType NextOperator(bool binary); // only ones the parser builds such nodes with
+	Span<std::pair<Identifier, VariableType>> NextVariables(uint32_t count);
+
+	Stmt* PopStmt();
+	Expr* PopExpr();
+	Span<Stmt*> PopStmts(uint32_t count);
+	Span<Expr*> PopExprs(uint32_t count);
+
+	std::string_view image;
+	size_t pos; // in bytes
+	Arena& arena;
+	size_t symbol_count = 0;
+
+	std::vector<Stmt*> stmts;
+	std::vector<Expr*> exprs;
+	std::vector<std::pair<Identifier, VariableType>> variables;
+};
+
+static void Damaged()
+{
+	throw std::runtime_error("damaged program image");
+}
+
+uint32_t ImageReader::Next()
+{
+	if (image.size() - pos < sizeof(uint32_t))
+	{
+		Damaged();
+	}
+	uint32_t word;
+	std::memcpy(&word, image.data() + pos, sizeof(word)); // mapping need not be aligned for every buffer
+	pos += sizeof(word);
+	return word;
+}
+
+// bytes padded to whole words
+std::string_view ImageReader::NextBytes(size_t count)
+{
+	size_t padded = (count + 3) / 4 * 4;
+	if (image.size() - pos < padded)
+	{
+		Damaged();
+	}
+	std::string_view bytes = image.substr(pos, count);
+	pos += padded;
+	return bytes;
+}
+
+Identifier ImageReader::NextIdentifier()
+{
+	SymbolId symbol = Next();
+	if (symbol >= symbol_count)
+	{
+		Damaged();
+	}
+	return { symbol, SourceLoc{ Next() } };
+}
+
+VariableType ImageReader::NextType()
+{
+	uint32_t type = Next();
+	if (type > static_cast<uint32_t>(VariableType::STRING))
+	{
+		Damaged();
+	}
+	return static_cast<VariableType>(type);
+}
+
+TokenType ImageReader::NextOperator(bool binary)
+{
+	auto op = static_cast<TokenType>(Next());
+	switch (op)
+	{
+	case TokenType::PLUS:
+	case TokenType::MINUS:
+		return op;
+	case TokenType::NOT:
+		if (binary)
+		{
+			Damaged();
+		}
+		return op;
+	case TokenType::MUL:
+	case TokenType::DIV:
+	case TokenType::EQUAL:
+	case TokenType::NOT_EQUAL:
+	case TokenType::LESS:
+	case TokenType::LESS_EQUAL:
+	case TokenType::GREATER:
+	case TokenType::GREATER_EQUAL:
+	case TokenType::AND:
+	case TokenType::OR:
+		if (!binary)
+		{
+			Damaged();
+		}
+		return op;
+	default:
+		Damaged();
+	}
+	return op;
+}
+
+Span<std::pair<Identifier, VariableType>> ImageReader::NextVariables(uint32_t count)
+{
+	variables.clear();
+	for (uint32_t i = 0; i < count; i++)
+	{
+		Identifier identifier = NextIdentifier();
+		variables.emplace_back(identifier, NextType());
+	}
+	return arena.Copy(variables);
+}
+
+Stmt* ImageReader::PopStmt()
+{
+	if (stmts.empty())
+	{
+		Damaged();
+	}
+	Stmt* stmt = stmts.back();
+	stmts.pop_back();
+	return stmt;
+}
+
+Expr* ImageReader::PopExpr()
+{
+	if (exprs.empty())
+	{
+		Damaged();
+	}
+	Expr* expr = exprs.back();
+	exprs.pop_back();
+	return expr;
+}
+
+Span<Stmt*> ImageReader::PopStmts(uint32_t count)
+{
+	if (count > stmts.size())
+	{
+		Damaged();
+	}
+	Span<Stmt*> popped = arena.Copy(stmts.data() + stmts.size() - count, count);
+	stmts.resize(stmts.size() - count);
+	return popped;
+}
+
+Span<Expr*> ImageReader::PopExprs(uint32_t count)
+{
+	if (count > exprs.size())
+	{
+		Damaged();
+	}
+	Span<Expr*> popped = arena.Copy(exprs.data() + exprs.size() - count, count);
+	exprs.resize(exprs.size() - count);
+	return popped;
+}
+
+// interned in order of their ids -> ids in the records stay valid
+void ImageReader::ReadSymbols(SymbolTable& symbols)
+{
+	symbol_count = Next();
+	for (size_t i = 0; i < symbol_count; i++)
+	{
+		uint32_t length = Next();
+		if (symbols.Intern(NextBytes(length)) != i)
+		{
+			Damaged();
+		}
+	}
+}
+
+Stmt* ImageReader::ReadProgram()
+{
+	while (!AtEnd())
+	{
+		switch (Next())
+		{
+		case BINARY:
+		{
+			TokenType op = NextOperator(true);
+			SourceLoc loc{ Next() };
+			Expr* right = PopExpr();
+			Expr* left = PopExpr();
+			exprs.push_back(arena.New<BinaryExpr>(left, right, op, loc));
+			break;
+		}
+		case UNARY:
+		{
+			TokenType op = NextOperator(false);
+			SourceLoc loc{ Next() };
+			exprs.push_back(arena.New<UnaryExpr>(PopExpr(), op, loc));
+			break;
+		}
+		case LITERAL:
+		{
+			Literal value;
+			switch (Next()) // index in variant
+			{
+			case 0:
+				value = nullptr;
+				break;
+			case 1:
+				value = static_cast<int>(Next());
+				break;
+			case 2:
+				value = Next() != 0;
+				break;
+			case 3:
+				value = std::string(NextBytes(Next()));
+				break;
+			default:
+				Damaged();
+			}
+			exprs.push_back(arena.New<LiteralExpr>(std::move(value)));
+			break;
+		}
+		case GROUPING:
+			exprs.push_back(arena.New<GroupingExpr>(PopExpr()));
+			break;
+		case VARIABLE:
+			exprs.push_back(arena.New<VariableExpr>(NextIdentifier()));
+			break;
+		case FUNCTION_CALL:
+		{
+			Identifier id = NextIdentifier();
+			Span<Expr*> arguments = PopExprs(Next());
+			exprs.push_back(arena.New<FunctionCallExpr>(arguments, id));
+			break;
+		}
+		case PROGRAM:
+		{
+			SymbolId id = Next();
+			uint32_t decl_count = Next();
+			if (id >= symbol_count)
+			{
+				Damaged();
+			}
+			Stmt* stmt = PopStmt();
+			Span<Stmt*> decl_stmts = PopStmts(decl_count);
+			stmts.push_back(arena.New<ProgramStmt>(id, stmt, decl_stmts));
+			if (!AtEnd()) // root -> last record
+			{
+				Damaged();
+			}
+			break;
+		}
+		case COMPOUND:
+			stmts.push_back(arena.New<CompoundStmt>(PopStmts(Next())));
+			break;
+		case WRITELN:
+			stmts.push_back(arena.New<WritelnStmt>(PopExprs(Next())));
+			break;
+		case EMPTY:
+			stmts.push_back(arena.New<EmptyStmt>());
+			break;
+		case VAR_DECL:
+			stmts.push_back(arena.New<VarDeclStmt>(NextVariables(Next())));
+			break;
+		case FUNC_DECL:
+		{
+			Identifier id = NextIdentifier();
+			VariableType return_type = NextType();
+			uint32_t decl_count = Next();
+			Span<std::pair<Identifier, VariableType>> parameters = NextVariables(Next());
+			Stmt* body = PopStmt();
+			Span<Stmt*> decl_stmts = PopStmts(decl_count);
+			stmts.push_back(arena.New<FuncDeclStmt>(id, return_type, body, decl_stmts, parameters));
+			break;
+		}
+		case PROC_DECL:
+		{
+			Identifier id = NextIdentifier();
+			uint32_t decl_count = Next();
+			Span<std::pair<Identifier, VariableType>> parameters = NextVariables(Next());
+			Stmt* body = PopStmt();
+			Span<Stmt*> decl_stmts = PopStmts(decl_count);
+			stmts.push_back(arena.New<ProcDeclStmt>(id, body, decl_stmts, parameters));
+			break;
+		}
+		case PROCEDURE_CALL:
+		{
+			Identifier id = NextIdentifier();
+			Span<Expr*> arguments = PopExprs(Next());
+			stmts.push_back(arena.New<ProcedureCallStmt>(arguments, id));
+			break;
+		}
+		case ASSIGNMENT:
+		{
+			Identifier id = NextIdentifier();
+			stmts.push_back(arena.New<AssignmentStmt>(id, PopExpr()));
+			break;
+		}
+		case IF:
+		{
+			SourceLoc loc{ Next() };
+			Stmt* else_branch = (Next() != 0) ? PopStmt() : nullptr;
+			Stmt* then_branch = PopStmt();
+			Expr* condition = PopExpr();
+			stmts.push_back(arena.New<IfStmt>(loc, condition, then_branch, else_branch));
+			break;
+		}
+		case WHILE:
+		{
+			SourceLoc loc{ Next() };
+			Stmt* body = PopStmt();
+			stmts.push_back(arena.New<WhileStmt>(loc, PopExpr(), body));
+			break;
+		}
+		case FOR:
+		{
+			SourceLoc loc{ Next() };
+			bool increment = Next() != 0;
+			Identifier id = NextIdentifier();
+			Stmt* body = PopStmt();
+			Expr* expression = PopExpr();
+			Stmt* assignment = PopStmt();
+			if (dynamic_cast<AssignmentStmt*>(assignment) == nullptr) // the interpreter runs it as the counter's one
+			{
+				Damaged();
+			}
+			stmts.push_back(arena.New<ForStmt>(loc, increment, id, assignment, expression, body));
+			break;
+		}
+		default:
+			Damaged();
+		}
+	}
+
+	if (stmts.size() != 1 || !exprs.empty() || dynamic_cast<ProgramStmt*>(stmts.back()) == nullptr)
+	{
+		Damaged();
+	}
+	return stmts.back();
+}
+
+
+static uint64_t Rotate(uint64_t value, int bits)
+{
+	return (value << bits) | (value >> (64 - bits));
+}
+
+static uint64_t Avalanche(uint64_t hash)
+{
+	hash ^= hash >> 33;
+	hash *= 0xFF51AFD7ED558CCDull;
+	hash ^= hash >> 33;
+	hash *= 0xC4CEB9FE1A85EC53ull;
+	hash ^= hash >> 33;
+	return hash;
+}
+
+// four independent lanes over 32-byte blocks -> multiplications overlap, hashing takes a fraction of a parse
+uint64_t ProgramImage::Hash(std::string_view data)
+{
+	constexpr uint64_t prime1 = 0x9E3779B185EBCA87ull;
+	constexpr uint64_t prime2 = 0xC2B2AE3D27D4EB4Full;
+
+	uint64_t lanes[4] = { prime1 + prime2, prime2, 0, 0 - prime1 };
+	const char* bytes = data.data();
+	size_t size = data.size();
+
+	size_t pos = 0;
+	for (; pos + 32 <= size; pos += 32)
+	{
+		for (int i = 0; i < 4; i++)
+		{
+			uint64_t word;
+			std::memcpy(&word, bytes + pos + 8 * i, sizeof(word));
+			lanes[i] = Rotate(lanes[i] + word * prime2, 31) * prime1;
+		}
+	}
+
+	uint64_t hash = size * prime1;
+	for (uint64_t lane : lanes)
+	{
+		hash = (hash ^ Avalanche(lane)) * prime1;
+	}
+	for (; pos < size; pos += 8)
+	{
+		uint64_t word = 0;
+		std::memcpy(&word, bytes + pos, std::min<size_t>(8, size - pos));
+		hash = Rotate(hash ^ (word * prime2), 27) * prime1;
+	}
+	return Avalanche(hash);
+}
+
+std::vector<uint32_t> ProgramImage::Encode(Stmt* program, const SymbolTable& symbols, uint64_t source_hash, uint64_t source_size)
+{
+	std::vector<uint32_t> words(header_words, 0);
+
+	words.push_back(static_cast<uint32_t>(symbols.Size()));
+	for (SymbolId id = 0; id < symbols.Size(); id++)
+	{
+		const std::string& name = symbols.Name(id);
+		words.push_back(static_cast<uint32_t>(name.size()));
+		size_t first = words.size();
+		words.resize(first + (name.size() + 3) / 4, 0);
+		std::memcpy(words.data() + first, name.data(), name.size());
+	}
+
+	ImageWriter(words).Write(program);
+
+	uint64_t payload_hash = Hash(std::string_view(reinterpret_cast<const char*>(words.data() + header_words), (words.size() - header_words) * sizeof(uint32_t)));
+	uint64_t header[] = { source_size, source_hash, payload_hash };
+	words[0] = magic;
+	words[1] = version;
+	std::memcpy(words.data() + 2, header, sizeof(header));
+	return words;
+}
+
+Stmt* ProgramImage::Decode(std::string_view image, uint64_t source_hash, uint64_t source_size, Arena& arena, SymbolTable& symbols)
+{
+	size_t header_size = header_words * sizeof(uint32_t);
+	if (image.size() < header_size || image.size() % sizeof(uint32_t) != 0)
+	{
+		return nullptr;
+	}
+
+	uint32_t head[2];
+	uint64_t header[3];
+	std::memcpy(head, image.data(), sizeof(head));
+	std::memcpy(header, image.data() + sizeof(head), sizeof(header));
+	if (head[0] != magic || head[1] != version || header[0] != source_size || header[1] != source_hash ||
+		header[2] != Hash(image.substr(header_size)))
+	{
+		return nullptr;
+	}
+
+	// built aside -> nothing of a damaged image leaks into the caller's arena and symbols
+	Arena built;
+	SymbolTable read_symbols;
+	Stmt* program;
+	try
+	{
+		ImageReader reader(image, header_size, built);
+		reader.ReadSymbols(read_symbols);
+		program = reader.ReadProgram();
+	}
+	catch (const std::runtime_error&)
+	{
+		return nullptr;
+	}
+
+	arena.Absorb(std::move(built));
+	symbols = std::move(read_symbols);
+	return program;
+}
+
+
+ProgramCache::ProgramCache(std::string m_dir, std::string_view m_source)
+	: dir(std::move(m_dir)), source_hash(ProgramImage::Hash(m_source)), source_size(m_source.size())
+{
+	static const char digits[] = "0123456789abcdef";
+	std::string name(16, '0');
+	for (int i = 0; i < 16; i++)
+	{
+		name[i] = digits[(source_hash >> (60 - 4 * i)) & 0xF];
+	}
+	path = (std::filesystem::path(dir) / (name + ".mpi")).string();
+}
+
+Stmt* ProgramCache::Load(Arena& arena, SymbolTable& symbols)
+{
+	std::error_code error;
+	if (!std::filesystem::is_regular_file(path, error))
+	{
+		return nullptr;
+	}
+
+	try
+	{
+		SourceFile image(path); // mapped, only the records get read
+		return ProgramImage::Decode(image.Text(), source_hash, source_size, arena, symbols);
+	}
+	catch (const std::runtime_error&)
+	{
+		return nullptr;
+	}
+}
+
+// written aside and renamed -> concurrent runs see either no image or a whole one
+void ProgramCache::Store(Stmt* program, const SymbolTable& symbols)
+{
+	std::vector<uint32_t> words = ProgramImage::Encode(program, symbols, source_hash, source_size);
+
+	std::error_code error;
+	std::filesystem::create_directories(dir, error);
+
+	std::string temporary = path + ".tmp" + std::to_string(std::random_device()());
+	{
+		std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+		file.write(reinterpret_cast<const char*>(words.data()), static_cast<std::streamsize>(words.size() * sizeof(uint32_t)));
+		if (!file)
+		{
+			file.close();
+			std::filesystem::remove(temporary, error);
+			return;
+		}
+	}
+
+	std::filesystem::rename(temporary, path, error);
+	if (error)
+	{
+		std::filesystem::remove(temporary, error);
+	}
+}
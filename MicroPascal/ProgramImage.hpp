@@ -0,0 +1,45 @@
+#ifndef PROGRAMIMAGE_HPP
+#define PROGRAMIMAGE_HPP
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Arena.hpp"
+#include "Stmt.hpp"
+#include "SymbolTable.hpp"
+
+// versioned binary form of a parsed program -> symbols and nodes in post-order, 32-bit words,
+// rebuilt into an arena without lexing or parsing (nodes have vtables, so they cannot be used in place)
+class ProgramImage
+{
+public:
+	static constexpr uint32_t magic = 0x4D49504D; // "MPIM"
+	static constexpr uint32_t version = 1; // bump on any change of the layout or of the nodes
+
+	static uint64_t Hash(std::string_view data); // not cryptographic, only tells sources apart
+
+	static std::vector<uint32_t> Encode(Stmt* program, const SymbolTable& symbols, uint64_t source_hash, uint64_t source_size);
+
+	// nullptr if the image does not belong to the source or is damaged -> arena and symbols stay untouched then
+	static Stmt* Decode(std::string_view image, uint64_t source_hash, uint64_t source_size, Arena& arena, SymbolTable& symbols);
+};
+
+// directory of program images named by hash of their source
+class ProgramCache
+{
+public:
+	ProgramCache(std::string m_dir, std::string_view m_source);
+
+	Stmt* Load(Arena& arena, SymbolTable& symbols); // nullptr on miss
+	void Store(Stmt* program, const SymbolTable& symbols); // best effort -> failures only cost the next run a parse
+
+private:
+	std::string dir;
+	std::string path;
+	uint64_t source_hash;
+	uint64_t source_size;
+};
+
+#endif // !PROGRAMIMAGE_HPP
@@ -0,0 +1,204 @@
+#include <algorithm>
+#include <utility>
+
+#include "PurityAnalyzer.hpp"
+
+// routines on their own first, then impurity spreads from callees to callers until nothing changes
+void PurityAnalyzer::Analyze(Stmt* program)
+{
+	routines.clear();
+	indices.clear();
+	pure_functions.clear();
+	program->Accept(*this);
+
+	bool changed = true;
+	while (changed)
+	{
+		changed = false;
+		for (auto&& facts : routines)
+		{
+			if (facts.pure && std::any_of(facts.callees.begin(), facts.callees.end(), [&](const Routine* callee)
+				{
+					auto found = indices.find(callee);
+					return found == indices.end() || !routines[found->second].pure;
+				}))
+			{
+				facts.pure = false;
+				changed = true;
+			}
+		}
+	}
+
+	for (auto&& facts : routines)
+	{
+		facts.routine->pure = facts.pure && facts.routine->is_function;
+		if (facts.routine->pure)
+		{
+			pure_functions.push_back({ facts.routine, facts.name });
+		}
+	}
+}
+
+void PurityAnalyzer::AnalyzeRoutine(Routine* routine, SymbolId name, Span<Stmt*> decl_stmts, Stmt* body)
+{
+	for (auto&& decl : decl_stmts)
+	{
+		decl->Accept(*this);
+	}
+
+	size_t outer = current;
+	current = routines.size();
+	indices[routine] = current;
+	Facts facts;
+	facts.routine = routine;
+	facts.name = name;
+	routines.push_back(std::move(facts));
+	body->Accept(*this);
+	current = outer;
+}
+
+// variable of an enclosing routine or of the program -> result would depend on (or change) more than the arguments
+void PurityAnalyzer::Touch(Address address)
+{
+	if (address.depth > 0)
+	{
+		routines[current].pure = false;
+	}
+}
+
+
+Literal PurityAnalyzer::Visit(BinaryExpr& binExpr)
+{
+	binExpr.left->Accept(*this);
+	binExpr.right->Accept(*this);
+	return nullptr;
+}
+
+Literal PurityAnalyzer::Visit(UnaryExpr& unExpr)
+{
+	unExpr.right->Accept(*this);
+	return nullptr;
+}
+
+Literal PurityAnalyzer::Visit([[maybe_unused]] LiteralExpr& litExpr)
+{
+	return nullptr;
+}
+
+Literal PurityAnalyzer::Visit(GroupingExpr& grExpr)
+{
+	grExpr.expr->Accept(*this);
+	return nullptr;
+}
+
+Literal PurityAnalyzer::Visit(VariableExpr& varExpr)
+{
+	if (varExpr.callee != nullptr) // function without parameters
+	{
+		routines[current].callees.push_back(varExpr.callee);
+	}
+	else
+	{
+		Touch(varExpr.address);
+	}
+	return nullptr;
+}
+
+Literal PurityAnalyzer::Visit(FunctionCallExpr& funcCallExpr)
+{
+	for (auto&& expr : funcCallExpr.exprs)
+	{
+		expr->Accept(*this);
+	}
+	routines[current].callees.push_back(funcCallExpr.callee);
+	return nullptr;
+}
+
+Literal PurityAnalyzer::Visit(InlinedCallExpr& inlinedCallExpr)
+{
+	Visit(*inlinedCallExpr.call);
+	return nullptr;
+}
+
+// body of the program is never called -> only its declarations matter
+void PurityAnalyzer::Visit(ProgramStmt& programStmt)
+{
+	for (auto&& decl : programStmt.decl_stmts)
+	{
+		decl->Accept(*this);
+	}
+}
+
+void PurityAnalyzer::Visit(CompoundStmt& compoundStmt)
+{
+	for (auto&& stmt : compoundStmt.statements)
+	{
+		stmt->Accept(*this);
+	}
+}
+
+void PurityAnalyzer::Visit([[maybe_unused]] WritelnStmt& writelnStmt)
+{
+	routines[current].pure = false;
+}
+
+void PurityAnalyzer::Visit([[maybe_unused]] EmptyStmt& emptyStmt) {}
+
+void PurityAnalyzer::Visit([[maybe_unused]] VarDeclStmt& varDeclStmt) {}
+
+void PurityAnalyzer::Visit(FuncDeclStmt& funcDeclStmt)
+{
+	AnalyzeRoutine(funcDeclStmt.routine, funcDeclStmt.id.symbol, funcDeclStmt.decl_stmts, funcDeclStmt.body);
+}
+
+void PurityAnalyzer::Visit(ProcDeclStmt& procDeclStmt)
+{
+	AnalyzeRoutine(procDeclStmt.routine, procDeclStmt.id.symbol, procDeclStmt.decl_stmts, procDeclStmt.body);
+}
+
+void PurityAnalyzer::Visit(AssignmentStmt& assignmentStmt)
+{
+	assignmentStmt.value->Accept(*this);
+	Touch(assignmentStmt.address);
+}
+
+void PurityAnalyzer::Visit(IfStmt& ifStmt)
+{
+	ifStmt.condition->Accept(*this);
+	ifStmt.then_branch->Accept(*this);
+	if (ifStmt.else_branch != nullptr)
+	{
+		ifStmt.else_branch->Accept(*this);
+	}
+}
+
+void PurityAnalyzer::Visit(WhileStmt& whileStmt)
+{
+	whileStmt.condition->Accept(*this);
+	whileStmt.body->Accept(*this);
+}
+
+void PurityAnalyzer::Visit(ForStmt& forStmt)
+{
+	forStmt.assignment->Accept(*this);
+	forStmt.expression->Accept(*this);
+	forStmt.body->Accept(*this);
+}
+
+void PurityAnalyzer::Visit(ProcedureCallStmt& procedureCallStmt)
+{
+	for (auto&& expr : procedureCallStmt.arguments)
+	{
+		expr->Accept(*this);
+	}
+	routines[current].callees.push_back(procedureCallStmt.callee);
+}
+
+void PurityAnalyzer::Visit(InlinedCallStmt& inlinedCallStmt)
+{
+	for (auto&& expr : inlinedCallStmt.arguments)
+	{
+		expr->Accept(*this);
+	}
+	inlinedCallStmt.body->Accept(*this);
+}
@@ -0,0 +1,60 @@
+#ifndef PURITYANALYZER_HPP
+#define PURITYANALYZER_HPP
+
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "Expr.hpp"
+#include "Stmt.hpp"
+
+// analysis of a resolved program -> functions that touch no variables but those of their own environment, print nothing
+// and call only routines like that are marked pure, the interpreter remembers their results
+class PurityAnalyzer : public VisitorExpr, public VisitorStmt
+{
+public:
+	void Analyze(Stmt* program);
+
+	std::vector<std::pair<const Routine*, SymbolId>> pure_functions; // in the order they are declared in
+
+private:
+	Literal Visit(BinaryExpr& binExpr) override;
+	Literal Visit(UnaryExpr& unExpr) override;
+	Literal Visit([[maybe_unused]] LiteralExpr& litExpr) override;
+	Literal Visit(GroupingExpr& grExpr) override;
+	Literal Visit(VariableExpr& varExpr) override;
+	Literal Visit(FunctionCallExpr& funcCallExpr) override;
+	Literal Visit(InlinedCallExpr& inlinedCallExpr) override;
+
+	void Visit(ProgramStmt& programStmt) override;
+	void Visit(CompoundStmt& compoundStmt) override;
+	void Visit([[maybe_unused]] WritelnStmt& writelnStmt) override;
+	void Visit([[maybe_unused]] EmptyStmt& emptyStmt) override;
+	void Visit([[maybe_unused]] VarDeclStmt& varDeclStmt) override;
+	void Visit(FuncDeclStmt& funcDeclStmt) override;
+	void Visit(AssignmentStmt& assignmentStmt) override;
+	void Visit(IfStmt& ifStmt) override;
+	void Visit(WhileStmt& whileStmt) override;
+	void Visit(ForStmt& forStmt) override;
+	void Visit(ProcDeclStmt& procDeclStmt) override;
+	void Visit(ProcedureCallStmt& procedureCallStmt) override;
+	void Visit(InlinedCallStmt& inlinedCallStmt) override;
+
+	// routine as seen by this pass
+	struct Facts
+	{
+		Routine* routine = nullptr;
+		SymbolId name = 0;
+		bool pure = true; // on its own, until a callee turns out not to be
+		std::vector<const Routine*> callees;
+	};
+
+	void AnalyzeRoutine(Routine* routine, SymbolId name, Span<Stmt*> decl_stmts, Stmt* body);
+	void Touch(Address address); // read or write
+
+	std::vector<Facts> routines;
+	std::unordered_map<const Routine*, size_t> indices; // into routines
+	size_t current = 0; // routine whose body is being walked
+};
+
+#endif // !PURITYANALYZER_HPP
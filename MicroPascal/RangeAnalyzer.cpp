@@ -0,0 +1,513 @@
+#include <algorithm>
+#include <cstdlib>
+#include <utility>
+#include <variant>
+
+#include "RangeAnalyzer.hpp"
+
+void RangeAnalyzer::Analyze(Stmt* program)
+{
+	program->Accept(*this);
+}
+
+// every activation starts with zeroed locals -> the only bounds known on entry, parameters can be anything
+void RangeAnalyzer::AnalyzeRoutine(const Routine* routine, Span<VariableType> slots, Span<Stmt*> decl_stmts, Stmt* body, uint32_t locals)
+{
+	chain.push_back(routine);
+	for (auto&& decl : decl_stmts)
+	{
+		decl->Accept(*this);
+	}
+
+	State outer_known = std::move(known);
+	known.clear();
+	for (uint32_t slot = locals; slot < slots.size(); slot++)
+	{
+		if (slots[slot] == VariableType::INTEGER)
+		{
+			known[{ routine, slot }] = { 0, 0 };
+		}
+	}
+	body->Accept(*this);
+
+	known = std::move(outer_known);
+	chain.pop_back();
+}
+
+RangeAnalyzer::Range RangeAnalyzer::Of(Expr* expr)
+{
+	expr->Accept(*this);
+	return range;
+}
+
+RangeAnalyzer::Range RangeAnalyzer::Peek(Expr* expr) const
+{
+	if (auto* grouping = dynamic_cast<GroupingExpr*>(expr))
+	{
+		return Peek(grouping->expr);
+	}
+	if (auto* literal = dynamic_cast<LiteralExpr*>(expr))
+	{
+		if (const int* value = std::get_if<int>(&literal->value))
+		{
+			return { *value, *value };
+		}
+	}
+	if (auto* variable = dynamic_cast<VariableExpr*>(expr))
+	{
+		if (variable->callee == nullptr)
+		{
+			return Known(variable->address);
+		}
+	}
+	return {};
+}
+
+RangeAnalyzer::Range RangeAnalyzer::Known(Address address) const
+{
+	auto found = known.find(SideEffects::Of(chain, address));
+	return found != known.end() ? found->second : Range();
+}
+
+void RangeAnalyzer::Set(Address address, Range value)
+{
+	known[SideEffects::Of(chain, address)] = value;
+}
+
+void RangeAnalyzer::Forget(const std::vector<SideEffects::Variable>& writes)
+{
+	for (auto&& variable : writes)
+	{
+		known.erase(variable);
+	}
+}
+
+// only conditions that change nothing -> values compared are still those of the variables afterwards
+void RangeAnalyzer::Refine(Expr* condition, bool holds)
+{
+	if (auto* grouping = dynamic_cast<GroupingExpr*>(condition))
+	{
+		Refine(grouping->expr, holds);
+		return;
+	}
+	if (auto* unary = dynamic_cast<UnaryExpr*>(condition))
+	{
+		if (unary->op == TokenType::NOT)
+		{
+			Refine(unary->right, !holds);
+		}
+		return;
+	}
+	auto* binary = dynamic_cast<BinaryExpr*>(condition);
+	if (binary == nullptr)
+	{
+		return;
+	}
+
+	// both operands get evaluated -> and that holds (or that does not) tells about both
+	if ((binary->op == TokenType::AND && holds) || (binary->op == TokenType::OR && !holds))
+	{
+		Refine(binary->left, holds);
+		Refine(binary->right, holds);
+		return;
+	}
+	if (binary->left->type != VariableType::INTEGER)
+	{
+		return;
+	}
+
+	TokenType op = binary->op;
+	TokenType mirrored;
+	if (!holds) // negated comparison
+	{
+		switch (op)
+		{
+		case TokenType::LESS: op = TokenType::GREATER_EQUAL; break;
+		case TokenType::LESS_EQUAL: op = TokenType::GREATER; break;
+		case TokenType::GREATER: op = TokenType::LESS_EQUAL; break;
+		case TokenType::GREATER_EQUAL: op = TokenType::LESS; break;
+		case TokenType::EQUAL: op = TokenType::NOT_EQUAL; break;
+		case TokenType::NOT_EQUAL: op = TokenType::EQUAL; break;
+		default: return;
+		}
+	}
+	switch (op) // same comparison with operands swapped
+	{
+	case TokenType::LESS: mirrored = TokenType::GREATER; break;
+	case TokenType::LESS_EQUAL: mirrored = TokenType::GREATER_EQUAL; break;
+	case TokenType::GREATER: mirrored = TokenType::LESS; break;
+	case TokenType::GREATER_EQUAL: mirrored = TokenType::LESS_EQUAL; break;
+	case TokenType::EQUAL: mirrored = TokenType::EQUAL; break;
+	case TokenType::NOT_EQUAL: mirrored = TokenType::NOT_EQUAL; break;
+	default: return;
+	}
+
+	Narrow(binary->left, op, Peek(binary->right));
+	Narrow(binary->right, mirrored, Peek(binary->left));
+}
+
+void RangeAnalyzer::Narrow(Expr* operand, TokenType op, Range other)
+{
+	if (auto* grouping = dynamic_cast<GroupingExpr*>(operand))
+	{
+		Narrow(grouping->expr, op, other);
+		return;
+	}
+	auto* variable = dynamic_cast<VariableExpr*>(operand);
+	if (variable == nullptr || variable->callee != nullptr)
+	{
+		return;
+	}
+
+	Range value = Known(variable->address);
+	switch (op)
+	{
+	case TokenType::LESS:
+		value.high = std::min(value.high, other.high - 1);
+		break;
+	case TokenType::LESS_EQUAL:
+		value.high = std::min(value.high, other.high);
+		break;
+	case TokenType::GREATER:
+		value.low = std::max(value.low, other.low + 1);
+		break;
+	case TokenType::GREATER_EQUAL:
+		value.low = std::max(value.low, other.low);
+		break;
+	case TokenType::EQUAL:
+		value.low = std::max(value.low, other.low);
+		value.high = std::min(value.high, other.high);
+		break;
+	default: // not equal -> only a single value can be cut off, at either end
+		if (other.low == other.high && value.low == other.low)
+		{
+			value.low++;
+		}
+		if (other.low == other.high && value.high == other.high)
+		{
+			value.high--;
+		}
+		break;
+	}
+	Set(variable->address, value);
+}
+
+// bounds in 64 bits -> exact, within those of an integer nothing can wrap around
+void RangeAnalyzer::Arithmetic(BinaryExpr& binExpr, int64_t low, int64_t high)
+{
+	overflows.total++;
+	if (low >= INT32_MIN && high <= INT32_MAX)
+	{
+		binExpr.proven = true;
+		overflows.removed++;
+		range = { low, high };
+	}
+	else
+	{
+		range = {};
+	}
+}
+
+// variable known in one of the states only -> can be anything after they meet
+RangeAnalyzer::State RangeAnalyzer::Join(const State& left, const State& right)
+{
+	State joined;
+	for (auto&& [variable, value] : left)
+	{
+		auto found = right.find(variable);
+		if (found == right.end())
+		{
+			continue;
+		}
+		const Range& other = found->second;
+		if (value.low > value.high) // not reached from the left
+		{
+			joined[variable] = other;
+		}
+		else if (other.low > other.high)
+		{
+			joined[variable] = value;
+		}
+		else
+		{
+			joined[variable] = { std::min(value.low, other.low), std::max(value.high, other.high) };
+		}
+	}
+	return joined;
+}
+
+
+Literal RangeAnalyzer::Visit(BinaryExpr& binExpr)
+{
+	Range left = Of(binExpr.left);
+	Range right = Of(binExpr.right);
+
+	range = {};
+	if (binExpr.left->type != VariableType::INTEGER) // string concat, boolean operators
+	{
+		return nullptr;
+	}
+
+	switch (binExpr.op)
+	{
+	case TokenType::PLUS:
+		Arithmetic(binExpr, left.low + right.low, left.high + right.high);
+		break;
+	case TokenType::MINUS:
+		Arithmetic(binExpr, left.low - right.high, left.high - right.low);
+		break;
+	case TokenType::MUL:
+	{
+		int64_t corners[] = { left.low * right.low, left.low * right.high, left.high * right.low, left.high * right.high };
+		Arithmetic(binExpr, *std::min_element(std::begin(corners), std::end(corners)), *std::max_element(std::begin(corners), std::end(corners)));
+		break;
+	}
+	case TokenType::DIV:
+	{
+		divisions.total++;
+		if (right.low > 0 || right.high < 0)
+		{
+			binExpr.proven = true;
+			divisions.removed++;
+		}
+		// quotient is never further from zero than the dividend
+		int64_t furthest = std::max(std::abs(left.low), std::abs(left.high));
+		if (left.low >= 0 && right.low > 0 && right.low <= right.high)
+		{
+			range = { left.low / right.high, left.high / right.low };
+		}
+		else
+		{
+			range = { std::max<int64_t>(-furthest, INT32_MIN), std::min<int64_t>(furthest, INT32_MAX) };
+		}
+		break;
+	}
+	default: // comparisons
+		break;
+	}
+	return nullptr;
+}
+
+Literal RangeAnalyzer::Visit(UnaryExpr& unExpr)
+{
+	Range right = Of(unExpr.right);
+	if (unExpr.op == TokenType::PLUS)
+	{
+		range = right;
+	}
+	else if (unExpr.op == TokenType::MINUS && right.low > INT32_MIN)
+	{
+		range = { -right.high, -right.low };
+	}
+	else
+	{
+		range = {};
+	}
+	return nullptr;
+}
+
+Literal RangeAnalyzer::Visit(LiteralExpr& litExpr)
+{
+	range = {};
+	if (const int* value = std::get_if<int>(&litExpr.value))
+	{
+		range = { *value, *value };
+	}
+	return nullptr;
+}
+
+Literal RangeAnalyzer::Visit(GroupingExpr& grExpr)
+{
+	grExpr.expr->Accept(*this);
+	return nullptr;
+}
+
+Literal RangeAnalyzer::Visit(VariableExpr& varExpr)
+{
+	if (varExpr.callee != nullptr) // function without parameters
+	{
+		Forget(effects.Writes(&varExpr, chain));
+		range = {};
+		return nullptr;
+	}
+	range = Known(varExpr.address);
+	return nullptr;
+}
+
+Literal RangeAnalyzer::Visit(FunctionCallExpr& funcCallExpr)
+{
+	for (auto&& expr : funcCallExpr.exprs)
+	{
+		expr->Accept(*this);
+	}
+	Forget(effects.Writes(&funcCallExpr, chain));
+	range = {};
+	return nullptr;
+}
+
+Literal RangeAnalyzer::Visit(InlinedCallExpr& inlinedCallExpr)
+{
+	Visit(*inlinedCallExpr.call);
+	range = Known({ 0, inlinedCallExpr.result });
+	return nullptr;
+}
+
+void RangeAnalyzer::Visit(ProgramStmt& programStmt)
+{
+	AnalyzeRoutine(nullptr, programStmt.slots, programStmt.decl_stmts, programStmt.stmt, 0);
+}
+
+void RangeAnalyzer::Visit(CompoundStmt& compoundStmt)
+{
+	for (auto&& stmt : compoundStmt.statements)
+	{
+		stmt->Accept(*this);
+	}
+}
+
+void RangeAnalyzer::Visit(WritelnStmt& writelnStmt)
+{
+	for (auto&& expr : writelnStmt.exprs)
+	{
+		expr->Accept(*this);
+	}
+}
+
+void RangeAnalyzer::Visit([[maybe_unused]] EmptyStmt& emptyStmt) {}
+
+void RangeAnalyzer::Visit([[maybe_unused]] VarDeclStmt& varDeclStmt) {}
+
+void RangeAnalyzer::Visit(FuncDeclStmt& funcDeclStmt)
+{
+	Routine* routine = funcDeclStmt.routine;
+	AnalyzeRoutine(routine, routine->slots, funcDeclStmt.decl_stmts, funcDeclStmt.body, routine->parameter_count);
+}
+
+void RangeAnalyzer::Visit(ProcDeclStmt& procDeclStmt)
+{
+	Routine* routine = procDeclStmt.routine;
+	AnalyzeRoutine(routine, routine->slots, procDeclStmt.decl_stmts, procDeclStmt.body, routine->parameter_count);
+}
+
+void RangeAnalyzer::Visit(AssignmentStmt& assignmentStmt)
+{
+	Range value = Of(assignmentStmt.value);
+	if (assignmentStmt.value->type == VariableType::INTEGER)
+	{
+		Set(assignmentStmt.address, value);
+	}
+}
+
+void RangeAnalyzer::Visit(IfStmt& ifStmt)
+{
+	ifStmt.condition->Accept(*this);
+	bool refined = effects.Writes(ifStmt.condition, chain).empty();
+
+	State before = known;
+	if (refined)
+	{
+		Refine(ifStmt.condition, true);
+	}
+	ifStmt.then_branch->Accept(*this);
+
+	State after_then = std::move(known);
+	known = std::move(before);
+	if (refined)
+	{
+		Refine(ifStmt.condition, false);
+	}
+	if (ifStmt.else_branch != nullptr)
+	{
+		ifStmt.else_branch->Accept(*this);
+	}
+	known = Join(after_then, known);
+}
+
+// anything the loop writes can have any value when an iteration starts -> one walk of the body is enough
+void RangeAnalyzer::Visit(WhileStmt& whileStmt)
+{
+	Forget(effects.Writes(&whileStmt, chain));
+	whileStmt.condition->Accept(*this);
+	bool refined = effects.Writes(whileStmt.condition, chain).empty();
+
+	State before = known;
+	if (refined)
+	{
+		Refine(whileStmt.condition, true);
+	}
+	whileStmt.body->Accept(*this);
+
+	known = std::move(before);
+	if (refined)
+	{
+		Refine(whileStmt.condition, false);
+	}
+}
+
+void RangeAnalyzer::Visit(ForStmt& forStmt)
+{
+	Range limit = Of(forStmt.expression); // evaluated first, as by the interpreter
+	forStmt.assignment->Accept(*this);
+	Range first = Known(forStmt.address);
+
+	std::vector<SideEffects::Variable> body_writes = effects.Writes(forStmt.body, chain);
+	bool moved = std::binary_search(body_writes.begin(), body_writes.end(), SideEffects::Of(chain, forStmt.address));
+	Forget(body_writes);
+
+	// counter not moved by the body, nor wrapping around past the limit -> between the first value and the limit
+	bool bounded = !moved && (forStmt.increment ? limit.high < INT32_MAX : limit.low > INT32_MIN);
+	State before = known;
+	if (bounded)
+	{
+		Set(forStmt.address, forStmt.increment ? Range{ first.low, limit.high } : Range{ limit.low, first.high });
+	}
+	else
+	{
+		known.erase(SideEffects::Of(chain, forStmt.address));
+	}
+	forStmt.body->Accept(*this);
+
+	// first value if the body never ran, one past the limit otherwise
+	known = std::move(before);
+	int64_t past = forStmt.increment ? 1 : -1;
+	if (bounded)
+	{
+		Set(forStmt.address, { std::min(first.low, limit.low + past), std::max(first.high, limit.high + past) });
+	}
+	else
+	{
+		known.erase(SideEffects::Of(chain, forStmt.address));
+	}
+}
+
+void RangeAnalyzer::Visit(ProcedureCallStmt& procedureCallStmt)
+{
+	for (auto&& expr : procedureCallStmt.arguments)
+	{
+		expr->Accept(*this);
+	}
+	Forget(effects.Writes(&procedureCallStmt, chain));
+}
+
+// arguments go to the first slots, the rest is reset like a fresh environment
+void RangeAnalyzer::Visit(InlinedCallStmt& inlinedCallStmt)
+{
+	for (uint32_t i = 0; i < inlinedCallStmt.slots.size(); i++)
+	{
+		Address address = { 0, inlinedCallStmt.base + i };
+		if (i < inlinedCallStmt.arguments.size())
+		{
+			Range value = Of(inlinedCallStmt.arguments[i]);
+			Set(address, value);
+		}
+		else
+		{
+			Set(address, { 0, 0 });
+		}
+		if (inlinedCallStmt.slots[i] != VariableType::INTEGER)
+		{
+			known.erase(SideEffects::Of(chain, address));
+		}
+	}
+	inlinedCallStmt.body->Accept(*this);
+}
@@ -0,0 +1,79 @@
+#ifndef RANGEANALYZER_HPP
+#define RANGEANALYZER_HPP
+
+#include <cstdint>
+#include <map>
+#include <vector>
+
+#include "Expr.hpp"
+#include "Stmt.hpp"
+#include "SideEffects.hpp"
+
+// analysis of a resolved program -> bounds of integer variables follow from constants, for loop bounds and conditions
+// of if and while statements, divisions by something that cannot be zero and additions, subtractions and
+// multiplications that cannot overflow get marked as proven
+class RangeAnalyzer : public VisitorExpr, public VisitorStmt
+{
+public:
+	void Analyze(Stmt* program);
+
+	// operations that could fail and those of them proven not to
+	struct Checks
+	{
+		uint32_t total = 0;
+		uint32_t removed = 0;
+	};
+
+	Checks divisions;
+	Checks overflows;
+
+private:
+	Literal Visit(BinaryExpr& binExpr) override;
+	Literal Visit(UnaryExpr& unExpr) override;
+	Literal Visit(LiteralExpr& litExpr) override;
+	Literal Visit(GroupingExpr& grExpr) override;
+	Literal Visit(VariableExpr& varExpr) override;
+	Literal Visit(FunctionCallExpr& funcCallExpr) override;
+	Literal Visit(InlinedCallExpr& inlinedCallExpr) override;
+
+	void Visit(ProgramStmt& programStmt) override;
+	void Visit(CompoundStmt& compoundStmt) override;
+	void Visit(WritelnStmt& writelnStmt) override;
+	void Visit([[maybe_unused]] EmptyStmt& emptyStmt) override;
+	void Visit([[maybe_unused]] VarDeclStmt& varDeclStmt) override;
+	void Visit(FuncDeclStmt& funcDeclStmt) override;
+	void Visit(AssignmentStmt& assignmentStmt) override;
+	void Visit(IfStmt& ifStmt) override;
+	void Visit(WhileStmt& whileStmt) override;
+	void Visit(ForStmt& forStmt) override;
+	void Visit(ProcDeclStmt& procDeclStmt) override;
+	void Visit(ProcedureCallStmt& procedureCallStmt) override;
+	void Visit(InlinedCallStmt& inlinedCallStmt) override;
+
+	// values an integer can have, low > high -> code is never reached
+	struct Range
+	{
+		int64_t low = INT32_MIN;
+		int64_t high = INT32_MAX;
+	};
+
+	using State = std::map<SideEffects::Variable, Range>; // variable missing -> any value
+
+	void AnalyzeRoutine(const Routine* routine, Span<VariableType> slots, Span<Stmt*> decl_stmts, Stmt* body, uint32_t locals);
+	Range Of(Expr* expr); // walks expr
+	Range Peek(Expr* expr) const; // literal or variable only, not walked
+	Range Known(Address address) const;
+	void Set(Address address, Range value);
+	void Forget(const std::vector<SideEffects::Variable>& writes);
+	void Refine(Expr* condition, bool holds); // known as it is where condition evaluated to holds
+	void Narrow(Expr* operand, TokenType op, Range other); // operand op other holds
+	void Arithmetic(BinaryExpr& binExpr, int64_t low, int64_t high);
+	static State Join(const State& left, const State& right);
+
+	SideEffects effects;
+	SideEffects::Chain chain; // routines being walked, innermost last
+	State known;
+	Range range; // of the expression just visited
+};
+
+#endif // !RANGEANALYZER_HPP
@@ -0,0 +1,511 @@
+#include <algorithm>
+
+#include "Resolver.hpp"
+#include "Error.hpp"
+
+Resolver::Resolver(Arena& m_arena) : arena(m_arena) {}
+
+void Resolver::Resolve(Stmt* program)
+{
+	bindings.clear();
+	visible.clear();
+	scope_starts.clear();
+	slots.clear();
+	level = 0;
+	declaring = false;
+
+	program->Accept(*this);
+}
+
+void Resolver::Resolve(ProgramStmt& program, size_t first, size_t count)
+{
+	for (size_t i = first; i < first + count; i++)
+	{
+		program.decl_stmts[i]->Accept(*this);
+	}
+}
+
+bool Resolver::Replace(Stmt* replaced, Stmt* replacement)
+{
+	auto same_types = [](auto&& a, auto&& b)
+	{
+		return std::equal(a.begin(), a.end(), b.begin(), b.end(),
+			[](auto&& x, auto&& y) { return x.second == y.second; });
+	};
+
+	if (auto* old_var = dynamic_cast<VarDeclStmt*>(replaced))
+	{
+		auto* new_var = dynamic_cast<VarDeclStmt*>(replacement);
+		return new_var != nullptr && std::equal(old_var->variables.begin(), old_var->variables.end(), new_var->variables.begin(), new_var->variables.end(),
+			[](auto&& x, auto&& y) { return x.first.symbol == y.first.symbol && x.second == y.second; });
+	}
+	if (auto* old_func = dynamic_cast<FuncDeclStmt*>(replaced))
+	{
+		auto* new_func = dynamic_cast<FuncDeclStmt*>(replacement);
+		if (new_func == nullptr || old_func->routine == nullptr || new_func->id.symbol != old_func->id.symbol ||
+			new_func->return_type != old_func->return_type || !same_types(old_func->parameters, new_func->parameters))
+		{
+			return false;
+		}
+		new_func->routine = old_func->routine;
+		new_func->routine->body = nullptr; // laid out again from the replacement
+		return true;
+	}
+	if (auto* old_proc = dynamic_cast<ProcDeclStmt*>(replaced))
+	{
+		auto* new_proc = dynamic_cast<ProcDeclStmt*>(replacement);
+		if (new_proc == nullptr || old_proc->routine == nullptr || new_proc->id.symbol != old_proc->id.symbol ||
+			!same_types(old_proc->parameters, new_proc->parameters))
+		{
+			return false;
+		}
+		new_proc->routine = old_proc->routine;
+		new_proc->routine->body = nullptr;
+		return true;
+	}
+	return false;
+}
+
+
+Literal Resolver::Visit(BinaryExpr& binExpr)
+{
+	binExpr.left->Accept(*this);
+	binExpr.right->Accept(*this);
+	VariableType left = binExpr.left->type;
+	VariableType right = binExpr.right->type;
+
+	switch (binExpr.op)
+	{
+	case TokenType::PLUS: // string concat too
+		if (left == right && left != VariableType::BOOL)
+		{
+			binExpr.type = left;
+			return nullptr;
+		}
+		break;
+	case TokenType::MINUS:
+	case TokenType::MUL:
+	case TokenType::DIV:
+		if (left == VariableType::INTEGER && right == VariableType::INTEGER)
+		{
+			binExpr.type = VariableType::INTEGER;
+			return nullptr;
+		}
+		break;
+	case TokenType::GREATER_EQUAL:
+	case TokenType::GREATER:
+	case TokenType::LESS_EQUAL:
+	case TokenType::LESS:
+		if (left == VariableType::INTEGER && right == VariableType::INTEGER)
+		{
+			binExpr.type = VariableType::BOOL;
+			return nullptr;
+		}
+		break;
+	case TokenType::EQUAL:
+	case TokenType::NOT_EQUAL:
+		if (left == right)
+		{
+			binExpr.type = VariableType::BOOL;
+			return nullptr;
+		}
+		break;
+	case TokenType::AND:
+	case TokenType::OR:
+		if (left == VariableType::BOOL && right == VariableType::BOOL)
+		{
+			binExpr.type = VariableType::BOOL;
+			return nullptr;
+		}
+		break;
+	default:
+		break;
+	}
+	throw Error(binExpr.loc, "types incompatible with given operator.");
+}
+
+Literal Resolver::Visit(UnaryExpr& unExpr)
+{
+	unExpr.right->Accept(*this);
+
+	switch (unExpr.op)
+	{
+	case TokenType::MINUS: // + and - only on integers
+	case TokenType::PLUS:
+		if (unExpr.right->type == VariableType::INTEGER)
+		{
+			unExpr.type = VariableType::INTEGER;
+			return nullptr;
+		}
+		break;
+	case TokenType::NOT: // NOT only on booleans
+		if (unExpr.right->type == VariableType::BOOL)
+		{
+			unExpr.type = VariableType::BOOL;
+			return nullptr;
+		}
+		break;
+	default:
+		break;
+	}
+	throw Error(unExpr.loc, "type incompatible with given operator.");
+}
+
+Literal Resolver::Visit(LiteralExpr& litExpr)
+{
+	// 1 .. int, 2 .. bool, 3 .. string -> according to order of types in variant Literal in Token.hpp
+	switch (litExpr.value.index())
+	{
+	case 1:
+		litExpr.type = VariableType::INTEGER;
+		return nullptr;
+	case 2:
+		litExpr.type = VariableType::BOOL;
+		return nullptr;
+	case 3:
+		litExpr.type = VariableType::STRING;
+		return nullptr;
+	default:
+		throw Error(0, "invalid literal value.");
+	}
+}
+
+Literal Resolver::Visit(GroupingExpr& grExpr)
+{
+	grExpr.expr->Accept(*this);
+	grExpr.type = grExpr.expr->type;
+	return nullptr;
+}
+
+Literal Resolver::Visit(VariableExpr& varExpr)
+{
+	auto&& binding = Find(varExpr.id);
+	varExpr.address = { level - binding.level, binding.slot };
+	varExpr.callee = binding.routine;
+	varExpr.type = binding.type;
+
+	// function without parameters gets called, procedure has no value
+	if (binding.routine != nullptr)
+	{
+		if (!binding.routine->is_function)
+		{
+			throw Error(varExpr.id.loc, "literal expected.");
+		}
+		CheckArguments(binding, Span<Expr*>(), varExpr.id);
+	}
+	return nullptr;
+}
+
+Literal Resolver::Visit(FunctionCallExpr& funcCallExpr)
+{
+	for (auto&& expr : funcCallExpr.exprs)
+	{
+		expr->Accept(*this);
+	}
+
+	auto&& binding = FindRoutine(funcCallExpr.id);
+	if (!binding.routine->is_function)
+	{
+		throw Error(funcCallExpr.id.loc, "literal expected.");
+	}
+	CheckArguments(binding, funcCallExpr.exprs, funcCallExpr.id);
+	funcCallExpr.callee = binding.routine;
+	funcCallExpr.depth = level - binding.level;
+	funcCallExpr.type = binding.type;
+	return nullptr;
+}
+
+
+void Resolver::Visit(ProgramStmt& programStmt)
+{
+	OpenScope();
+
+	// all names of the scope first -> routines can use the ones declared after them
+	declaring = true;
+	for (auto&& declStmt : programStmt.decl_stmts)
+	{
+		declStmt->Accept(*this);
+	}
+	declaring = false;
+	programStmt.slots = arena.Copy(slots);
+
+	for (auto&& declStmt : programStmt.decl_stmts)
+	{
+		declStmt->Accept(*this);
+	}
+	programStmt.stmt->Accept(*this);
+	// scope stays open -> declarations can get resolved again against it
+}
+
+void Resolver::Visit(CompoundStmt& compoundStmt)
+{
+	for (auto&& stmt : compoundStmt.statements)
+	{
+		stmt->Accept(*this);
+	}
+}
+
+void Resolver::Visit(WritelnStmt& writelnStmt)
+{
+	for (auto&& expr : writelnStmt.exprs)
+	{
+		expr->Accept(*this);
+	}
+}
+
+void Resolver::Visit([[maybe_unused]] EmptyStmt& emptyStmt) {}
+
+void Resolver::Visit(VarDeclStmt& varDeclStmt)
+{
+	if (declaring)
+	{
+		for (auto&& [identifier, type] : varDeclStmt.variables)
+		{
+			Declare(identifier, static_cast<uint32_t>(slots.size()), type);
+			slots.push_back(type);
+		}
+	}
+}
+
+void Resolver::Visit(FuncDeclStmt& funcDeclStmt)
+{
+	if (declaring)
+	{
+		if (funcDeclStmt.routine == nullptr)
+		{
+			funcDeclStmt.routine = arena.New<Routine>();
+		}
+		funcDeclStmt.routine->is_function = true; // known before the routine gets resolved -> calls declared earlier can check it
+		Declare(funcDeclStmt.id, 0, funcDeclStmt.return_type, funcDeclStmt.routine, funcDeclStmt.parameters);
+		return;
+	}
+	ResolveRoutine(*funcDeclStmt.routine, funcDeclStmt.id, funcDeclStmt.body, funcDeclStmt.decl_stmts,
+		funcDeclStmt.parameters, funcDeclStmt.return_type);
+}
+
+void Resolver::Visit(ProcDeclStmt& procDeclStmt)
+{
+	if (declaring)
+	{
+		if (procDeclStmt.routine == nullptr)
+		{
+			procDeclStmt.routine = arena.New<Routine>();
+		}
+		Declare(procDeclStmt.id, 0, VariableType::INTEGER, procDeclStmt.routine, procDeclStmt.parameters);
+		return;
+	}
+	ResolveRoutine(*procDeclStmt.routine, procDeclStmt.id, procDeclStmt.body, procDeclStmt.decl_stmts,
+		procDeclStmt.parameters, std::nullopt);
+}
+
+void Resolver::Visit(ProcedureCallStmt& procedureCallStmt)
+{
+	for (auto&& expr : procedureCallStmt.arguments)
+	{
+		expr->Accept(*this);
+	}
+
+	auto&& binding = FindRoutine(procedureCallStmt.id); // function result gets dropped
+	CheckArguments(binding, procedureCallStmt.arguments, procedureCallStmt.id);
+	procedureCallStmt.callee = binding.routine;
+	procedureCallStmt.depth = level - binding.level;
+}
+
+// inliner makes these from resolved calls -> nothing left to bind
+Literal Resolver::Visit([[maybe_unused]] InlinedCallExpr& inlinedCallExpr)
+{
+	return nullptr;
+}
+
+void Resolver::Visit([[maybe_unused]] InlinedCallStmt& inlinedCallStmt) {}
+
+void Resolver::Visit(AssignmentStmt& assignmentStmt)
+{
+	assignmentStmt.value->Accept(*this);
+
+	auto&& binding = FindVariable(assignmentStmt.id);
+	if (assignmentStmt.value->type != binding.type) // types have to be the same
+	{
+		throw Error(assignmentStmt.id.loc, "incompatible types.");
+	}
+	assignmentStmt.address = { level - binding.level, binding.slot };
+}
+
+void Resolver::Visit(IfStmt& ifStmt)
+{
+	ifStmt.condition->Accept(*this);
+	if (ifStmt.condition->type != VariableType::BOOL)
+	{
+		throw Error(ifStmt.loc, "expected boolean value.");
+	}
+	ifStmt.then_branch->Accept(*this);
+	if (ifStmt.else_branch != nullptr)
+	{
+		ifStmt.else_branch->Accept(*this);
+	}
+}
+
+void Resolver::Visit(WhileStmt& whileStmt)
+{
+	whileStmt.condition->Accept(*this);
+	if (whileStmt.condition->type != VariableType::BOOL)
+	{
+		throw Error(whileStmt.loc, "expected boolean value.");
+	}
+	whileStmt.body->Accept(*this);
+}
+
+void Resolver::Visit(ForStmt& forStmt)
+{
+	// same order as the interpreter evaluates them
+	forStmt.expression->Accept(*this);
+	forStmt.assignment->Accept(*this);
+
+	auto&& counter = FindVariable(forStmt.id);
+	if (forStmt.expression->type != VariableType::INTEGER || counter.type != VariableType::INTEGER)
+	{
+		throw Error(forStmt.loc, "expected integer value.");
+	}
+	forStmt.address = { level - counter.level, counter.slot };
+	forStmt.body->Accept(*this);
+}
+
+
+void Resolver::Declare(Identifier name, uint32_t slot, VariableType type, Routine* routine,
+	Span<std::pair<Identifier, VariableType>> parameters)
+{
+	if (name.symbol >= visible.size())
+	{
+		visible.resize(name.symbol + 1, -1);
+	}
+
+	int32_t& innermost = visible[name.symbol];
+	if (innermost >= 0 && bindings[innermost].level == level)
+	{
+		throw Error(name.loc, "duplicate identifier.");
+	}
+	bindings.push_back({ name.symbol, level, slot, type, routine, parameters, innermost });
+	innermost = static_cast<int32_t>(bindings.size() - 1);
+}
+
+void Resolver::ResolveRoutine(Routine& routine, Identifier name, Stmt* body, Span<Stmt*> decl_stmts,
+	Span<std::pair<Identifier, VariableType>> parameters, std::optional<VariableType> return_type)
+{
+	std::vector<VariableType> enclosing_slots;
+	slots.swap(enclosing_slots);
+	OpenScope();
+
+	// parameters and return variable get the first slots -> a call finds them without the layout of the locals
+	for (auto&& [identifier, type] : parameters)
+	{
+		slots.push_back(type);
+	}
+	if (return_type.has_value())
+	{
+		slots.push_back(return_type.value());
+	}
+
+	// names get bound in the order a call used to define them -> declarations, parameters, return variable
+	declaring = true;
+	for (auto&& declStmt : decl_stmts)
+	{
+		declStmt->Accept(*this);
+	}
+	declaring = false;
+	for (size_t i = 0; i < parameters.size(); i++)
+	{
+		Declare(parameters[i].first, static_cast<uint32_t>(i), parameters[i].second);
+	}
+	if (return_type.has_value())
+	{
+		Declare(name, static_cast<uint32_t>(parameters.size()), return_type.value());
+	}
+
+	// layout depends only on the declaration itself -> done once even if the tree gets resolved again
+	if (routine.body == nullptr)
+	{
+		routine.slots = arena.Copy(slots);
+		routine.frame.clear(); // zeros of the old layout, if a replaced declaration had one
+		routine.parameter_count = static_cast<uint32_t>(parameters.size());
+		routine.body = body;
+	}
+
+	for (auto&& declStmt : decl_stmts)
+	{
+		declStmt->Accept(*this);
+	}
+	body->Accept(*this);
+
+	CloseScope();
+	slots.swap(enclosing_slots);
+}
+
+
+void Resolver::OpenScope()
+{
+	scope_starts.push_back(bindings.size());
+	level = static_cast<uint32_t>(scope_starts.size() - 1);
+}
+
+void Resolver::CloseScope()
+{
+	while (bindings.size() > scope_starts.back())
+	{
+		visible[bindings.back().symbol] = bindings.back().shadowed;
+		bindings.pop_back();
+	}
+	scope_starts.pop_back();
+	level = scope_starts.empty() ? 0 : static_cast<uint32_t>(scope_starts.size() - 1);
+}
+
+
+const Resolver::Binding& Resolver::Find(Identifier name) const
+{
+	if (name.symbol >= visible.size() || visible[name.symbol] < 0)
+	{
+		throw Error(name.loc, "identifier not found.");
+	}
+	return bindings[visible[name.symbol]];
+}
+
+const Resolver::Binding& Resolver::FindRoutine(Identifier name) const
+{
+	Find(name); // unknown at all -> not found rather than not callable
+	for (int32_t index = visible[name.symbol]; index >= 0; index = bindings[index].shadowed)
+	{
+		if (bindings[index].routine != nullptr)
+		{
+			return bindings[index];
+		}
+	}
+	throw Error(name.loc, "callable expected.");
+}
+
+const Resolver::Binding& Resolver::FindVariable(Identifier name) const
+{
+	auto&& binding = Find(name);
+	if (binding.routine != nullptr)
+	{
+		throw Error(name.loc, "literal expected.");
+	}
+	return binding;
+}
+
+
+void Resolver::CheckArguments(const Binding& callee, Span<Expr*> arguments, Identifier id)
+{
+	// arity check
+	if (arguments.size() != callee.parameters.size())
+	{
+		throw Error(id.loc, "invalid number of arguments.");
+	}
+
+	// type check
+	for (size_t i = 0; i < arguments.size(); i++)
+	{
+		if (arguments[i]->type != callee.parameters[i].second)
+		{
+			throw Error(id.loc, "incompatible type for argument.");
+		}
+	}
+}
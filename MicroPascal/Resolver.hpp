@@ -0,0 +1,86 @@
+#ifndef RESOLVER_HPP
+#define RESOLVER_HPP
+
+#include <cstdint>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "Arena.hpp"
+#include "Expr.hpp"
+#include "Stmt.hpp"
+
+// pass between parser and interpreter, binds every name to its declaration by the lexical scopes and checks types ->
+// variables get (depth, slot) addresses, call sites their routine and expressions their type,
+// unknown names and ill-typed code are reported before anything runs (interpreter does not check again)
+class Resolver : public VisitorExpr, public VisitorStmt
+{
+public:
+	Resolver(Arena& m_arena);
+
+	void Resolve(Stmt* program); // whole program, names of its scope stay bound afterwards
+	void Resolve(ProgramStmt& program, size_t first, size_t count); // only some top level declarations again, after a resolve that went through
+
+	// replacement declares the same names with the same types as replaced -> takes over its routine,
+	// so declarations resolved against replaced stay valid and only replacement needs resolving
+	static bool Replace(Stmt* replaced, Stmt* replacement);
+
+private:
+	Literal Visit(BinaryExpr& binExpr) override;
+	Literal Visit(UnaryExpr& unExpr) override;
+	Literal Visit(LiteralExpr& litExpr) override;
+	Literal Visit(GroupingExpr& grExpr) override;
+	Literal Visit(VariableExpr& varExpr) override;
+	Literal Visit(FunctionCallExpr& funcCallExpr) override;
+	Literal Visit([[maybe_unused]] InlinedCallExpr& inlinedCallExpr) override;
+
+	void Visit(ProgramStmt& programStmt) override;
+	void Visit(CompoundStmt& compoundStmt) override;
+	void Visit(WritelnStmt& writelnStmt) override;
+	void Visit([[maybe_unused]] EmptyStmt& emptyStmt) override;
+	void Visit(VarDeclStmt& varDeclStmt) override;
+	void Visit(FuncDeclStmt& funcDeclStmt) override;
+	void Visit(AssignmentStmt& assignmentStmt) override;
+	void Visit(IfStmt& ifStmt) override;
+	void Visit(WhileStmt& whileStmt) override;
+	void Visit(ForStmt& forStmt) override;
+	void Visit(ProcDeclStmt& procDeclStmt) override;
+	void Visit(ProcedureCallStmt& procedureCallStmt) override;
+	void Visit([[maybe_unused]] InlinedCallStmt& inlinedCallStmt) override;
+
+	// what a name stands for in one scope
+	struct Binding
+	{
+		SymbolId symbol;
+		uint32_t level; // of the scope it was declared in
+		uint32_t slot; // variables only
+		VariableType type; // of a variable or of the result of a function
+		Routine* routine; // nullptr -> variable
+		Span<std::pair<Identifier, VariableType>> parameters; // of a routine
+		int32_t shadowed; // binding of the same name in an enclosing scope, -1 if none
+	};
+
+	void Declare(Identifier name, uint32_t slot, VariableType type, Routine* routine = nullptr,
+		Span<std::pair<Identifier, VariableType>> parameters = {});
+	void ResolveRoutine(Routine& routine, Identifier name, Stmt* body, Span<Stmt*> decl_stmts,
+		Span<std::pair<Identifier, VariableType>> parameters, std::optional<VariableType> return_type);
+
+	void OpenScope();
+	void CloseScope();
+
+	const Binding& Find(Identifier name) const; // innermost
+	const Binding& FindRoutine(Identifier name) const; // skips variables -> function finds itself next to its return variable
+	const Binding& FindVariable(Identifier name) const;
+
+	static void CheckArguments(const Binding& callee, Span<Expr*> arguments, Identifier id);
+
+	Arena& arena; // slot layouts go in here
+	std::vector<Binding> bindings; // of all open scopes, innermost last
+	std::vector<int32_t> visible; // innermost binding of each symbol, -1 if none
+	std::vector<size_t> scope_starts; // index into bindings where each open scope begins
+	std::vector<VariableType> slots; // of the scope being declared
+	uint32_t level = 0; // of the innermost open scope, program is 0
+	bool declaring = false; // declarations only bind their names -> bodies get resolved once all names of a scope are known
+};
+
+#endif // !RESOLVER_HPP
@@ -0,0 +1,246 @@
+#include <algorithm>
+#include <iterator>
+
+#include "SideEffects.hpp"
+
+// variables a piece of code writes itself and routines it calls, declarations within it are not entered
+class WriteFinder : public VisitorExpr, public VisitorStmt
+{
+public:
+	WriteFinder(const SideEffects::Chain& m_chain) : chain(m_chain) {}
+
+	std::vector<SideEffects::Variable> writes;
+	std::vector<std::pair<const Routine*, uint32_t>> calls;
+
+private:
+	Literal Visit(BinaryExpr& binExpr) override;
+	Literal Visit(UnaryExpr& unExpr) override;
+	Literal Visit([[maybe_unused]] LiteralExpr& litExpr) override;
+	Literal Visit(GroupingExpr& grExpr) override;
+	Literal Visit(VariableExpr& varExpr) override;
+	Literal Visit(FunctionCallExpr& funcCallExpr) override;
+	Literal Visit(InlinedCallExpr& inlinedCallExpr) override;
+
+	void Visit([[maybe_unused]] ProgramStmt& programStmt) override;
+	void Visit(CompoundStmt& compoundStmt) override;
+	void Visit(WritelnStmt& writelnStmt) override;
+	void Visit([[maybe_unused]] EmptyStmt& emptyStmt) override;
+	void Visit([[maybe_unused]] VarDeclStmt& varDeclStmt) override;
+	void Visit([[maybe_unused]] FuncDeclStmt& funcDeclStmt) override;
+	void Visit(AssignmentStmt& assignmentStmt) override;
+	void Visit(IfStmt& ifStmt) override;
+	void Visit(WhileStmt& whileStmt) override;
+	void Visit(ForStmt& forStmt) override;
+	void Visit([[maybe_unused]] ProcDeclStmt& procDeclStmt) override;
+	void Visit(ProcedureCallStmt& procedureCallStmt) override;
+	void Visit(InlinedCallStmt& inlinedCallStmt) override;
+
+	void Written(Address address)
+	{
+		writes.push_back(SideEffects::Of(chain, address));
+	}
+
+	const SideEffects::Chain& chain;
+};
+
+Literal WriteFinder::Visit(BinaryExpr& binExpr)
+{
+	binExpr.left->Accept(*this);
+	binExpr.right->Accept(*this);
+	return nullptr;
+}
+
+Literal WriteFinder::Visit(UnaryExpr& unExpr)
+{
+	unExpr.right->Accept(*this);
+	return nullptr;
+}
+
+Literal WriteFinder::Visit([[maybe_unused]] LiteralExpr& litExpr)
+{
+	return nullptr;
+}
+
+Literal WriteFinder::Visit(GroupingExpr& grExpr)
+{
+	grExpr.expr->Accept(*this);
+	return nullptr;
+}
+
+Literal WriteFinder::Visit(VariableExpr& varExpr)
+{
+	if (varExpr.callee != nullptr) // function without parameters
+	{
+		calls.push_back({ varExpr.callee, varExpr.address.depth });
+	}
+	return nullptr;
+}
+
+Literal WriteFinder::Visit(FunctionCallExpr& funcCallExpr)
+{
+	for (auto&& expr : funcCallExpr.exprs)
+	{
+		expr->Accept(*this);
+	}
+	calls.push_back({ funcCallExpr.callee, funcCallExpr.depth });
+	return nullptr;
+}
+
+Literal WriteFinder::Visit(InlinedCallExpr& inlinedCallExpr)
+{
+	Visit(*inlinedCallExpr.call);
+	return nullptr;
+}
+
+void WriteFinder::Visit([[maybe_unused]] ProgramStmt& programStmt) {}
+
+void WriteFinder::Visit(CompoundStmt& compoundStmt)
+{
+	for (auto&& stmt : compoundStmt.statements)
+	{
+		stmt->Accept(*this);
+	}
+}
+
+void WriteFinder::Visit(WritelnStmt& writelnStmt)
+{
+	for (auto&& expr : writelnStmt.exprs)
+	{
+		expr->Accept(*this);
+	}
+}
+
+void WriteFinder::Visit([[maybe_unused]] EmptyStmt& emptyStmt) {}
+
+void WriteFinder::Visit([[maybe_unused]] VarDeclStmt& varDeclStmt) {}
+
+void WriteFinder::Visit([[maybe_unused]] FuncDeclStmt& funcDeclStmt) {}
+
+void WriteFinder::Visit([[maybe_unused]] ProcDeclStmt& procDeclStmt) {}
+
+void WriteFinder::Visit(AssignmentStmt& assignmentStmt)
+{
+	assignmentStmt.value->Accept(*this);
+	Written(assignmentStmt.address);
+}
+
+void WriteFinder::Visit(IfStmt& ifStmt)
+{
+	ifStmt.condition->Accept(*this);
+	ifStmt.then_branch->Accept(*this);
+	if (ifStmt.else_branch != nullptr)
+	{
+		ifStmt.else_branch->Accept(*this);
+	}
+}
+
+void WriteFinder::Visit(WhileStmt& whileStmt)
+{
+	whileStmt.condition->Accept(*this);
+	whileStmt.body->Accept(*this);
+}
+
+void WriteFinder::Visit(ForStmt& forStmt)
+{
+	forStmt.assignment->Accept(*this);
+	forStmt.expression->Accept(*this);
+	forStmt.body->Accept(*this);
+	Written(forStmt.address);
+}
+
+void WriteFinder::Visit(ProcedureCallStmt& procedureCallStmt)
+{
+	for (auto&& expr : procedureCallStmt.arguments)
+	{
+		expr->Accept(*this);
+	}
+	calls.push_back({ procedureCallStmt.callee, procedureCallStmt.depth });
+}
+
+void WriteFinder::Visit(InlinedCallStmt& inlinedCallStmt)
+{
+	for (auto&& expr : inlinedCallStmt.arguments)
+	{
+		expr->Accept(*this);
+	}
+	for (uint32_t i = 0; i < inlinedCallStmt.slots.size(); i++)
+	{
+		Written({ 0, inlinedCallStmt.base + i });
+	}
+	inlinedCallStmt.body->Accept(*this);
+}
+
+
+std::vector<SideEffects::Variable> SideEffects::Writes(Stmt* code, const Chain& chain)
+{
+	WriteFinder finder(chain);
+	code->Accept(finder);
+	return Writes(finder, chain);
+}
+
+std::vector<SideEffects::Variable> SideEffects::Writes(Expr* code, const Chain& chain)
+{
+	WriteFinder finder(chain);
+	code->Accept(finder);
+	return Writes(finder, chain);
+}
+
+std::vector<SideEffects::Variable> SideEffects::Writes(WriteFinder& finder, const Chain& chain)
+{
+	std::vector<Variable> writes = std::move(finder.writes);
+
+	// everything the calls lead to, each routine once
+	searches++;
+	std::vector<Summary*> pending;
+	for (auto&& [callee, depth] : finder.calls)
+	{
+		pending.push_back(&Summarize(callee, chain, depth));
+	}
+	while (!pending.empty())
+	{
+		Summary* summary = pending.back();
+		pending.pop_back();
+		if (summary->visited == searches)
+		{
+			continue;
+		}
+		summary->visited = searches;
+		writes.insert(writes.end(), summary->writes.begin(), summary->writes.end());
+		for (auto&& [callee, depth] : summary->calls)
+		{
+			pending.push_back(&Summarize(callee, summary->chain, depth));
+		}
+	}
+
+	std::sort(writes.begin(), writes.end());
+	writes.erase(std::unique(writes.begin(), writes.end()), writes.end());
+	return writes;
+}
+
+SideEffects::Variable SideEffects::Of(const Chain& chain, Address address)
+{
+	return { chain[chain.size() - 1 - address.depth], address.slot };
+}
+
+// each call gets a new environment -> what a routine writes in its own one does not matter to anyone else
+SideEffects::Summary& SideEffects::Summarize(const Routine* routine, const Chain& caller_chain, uint32_t depth)
+{
+	auto found = summaries.find(routine);
+	if (found != summaries.end())
+	{
+		return found->second;
+	}
+
+	Summary& summary = summaries[routine];
+	summary.chain.assign(caller_chain.begin(), caller_chain.end() - depth); // up to where routine is declared
+	summary.chain.push_back(routine);
+
+	WriteFinder finder(summary.chain);
+	routine->body->Accept(finder);
+	std::copy_if(finder.writes.begin(), finder.writes.end(), std::back_inserter(summary.writes),
+		[&](const Variable& variable) { return variable.first != routine; });
+	std::sort(summary.writes.begin(), summary.writes.end());
+	summary.writes.erase(std::unique(summary.writes.begin(), summary.writes.end()), summary.writes.end());
+	summary.calls = std::move(finder.calls);
+	return summary;
+}
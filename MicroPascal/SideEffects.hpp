@@ -0,0 +1,44 @@
+#ifndef SIDEEFFECTS_HPP
+#define SIDEEFFECTS_HPP
+
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "Expr.hpp"
+#include "Stmt.hpp"
+
+class WriteFinder;
+
+// what running a piece of a resolved program can change -> variables it writes, including the ones of enclosing
+// routines that routines it calls write; routines get summarized once, on the first call that leads to them
+class SideEffects
+{
+public:
+	using Variable = std::pair<const Routine*, uint32_t>; // declaring routine (nullptr -> program) and slot
+	using Chain = std::vector<const Routine*>; // routine code belongs to, then those it is declared in, program (nullptr) first
+
+	std::vector<Variable> Writes(Stmt* code, const Chain& chain); // sorted
+	std::vector<Variable> Writes(Expr* code, const Chain& chain);
+
+	static Variable Of(const Chain& chain, Address address); // as read or written by code of the last routine of chain
+
+private:
+	// what a routine does on its own
+	struct Summary
+	{
+		Chain chain; // of the routine itself
+		std::vector<Variable> writes; // outside of its own environment
+		std::vector<std::pair<const Routine*, uint32_t>> calls; // callee and depth of the call
+		uint32_t visited = 0; // by the search of that number
+	};
+
+	std::vector<Variable> Writes(WriteFinder& finder, const Chain& chain); // of what finder walked
+	Summary& Summarize(const Routine* routine, const Chain& caller_chain, uint32_t depth);
+
+	std::unordered_map<const Routine*, Summary> summaries;
+	uint32_t searches = 0;
+};
+
+#endif // !SIDEEFFECTS_HPP
@@ -0,0 +1,126 @@
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#include <io.h>
+#define open _open
+#define read _read
+#define close _close
+#define fstat _fstat
+#define stat _stat
+#define O_RDONLY (_O_RDONLY | _O_BINARY)
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include "SourceFile.hpp"
+
+// "-" stands for standard input
+SourceFile::SourceFile(const std::string& m_path)
+{
+	int fd = (m_path == "-") ? 0 : open(m_path.c_str(), O_RDONLY);
+	if (fd < 0)
+	{
+		throw std::runtime_error("cannot open " + m_path);
+	}
+
+	struct stat info;
+	if (fstat(fd, &info) != 0)
+	{
+		if (fd != 0)
+		{
+			close(fd);
+		}
+		throw std::runtime_error("cannot stat " + m_path);
+	}
+
+	bool regular = (info.st_mode & S_IFMT) == S_IFREG;
+
+#ifndef _WIN32
+	// regular non-empty file -> map it, pages get loaded lazily as the lexer walks through them
+	if (regular && info.st_size > 0)
+	{
+		void* mem = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+		if (mem != MAP_FAILED)
+		{
+			madvise(mem, static_cast<size_t>(info.st_size), MADV_SEQUENTIAL);
+			data = static_cast<const char*>(mem);
+			size = static_cast<size_t>(info.st_size);
+			mapped = true;
+		}
+	}
+#endif
+
+	if (!mapped)
+	{
+		try
+		{
+			ReadAll(fd, regular ? static_cast<size_t>(info.st_size) : 0);
+		}
+		catch (...)
+		{
+			if (fd != 0)
+			{
+				close(fd);
+			}
+			throw;
+		}
+	}
+
+	if (fd != 0)
+	{
+		close(fd); // mapping stays valid after close
+	}
+}
+
+SourceFile::~SourceFile()
+{
+#ifndef _WIN32
+	if (mapped)
+	{
+		munmap(const_cast<char*>(data), size);
+	}
+#endif
+}
+
+std::string_view SourceFile::Text() const
+{
+	return std::string_view(data, size);
+}
+
+// one sized read for regular files, growing reads for pipes where the size is unknown
+void SourceFile::ReadAll(int fd, size_t size_hint)
+{
+	buffer.resize(size_hint > 0 ? size_hint : 64 * 1024);
+
+	size_t filled = 0;
+	while (true)
+	{
+		if (filled == buffer.size())
+		{
+			if (size_hint > 0 && filled == size_hint)
+			{
+				break; // got exactly what fstat promised
+			}
+			buffer.resize(buffer.size() * 2);
+		}
+
+		auto count = read(fd, &buffer[filled], static_cast<unsigned>(buffer.size() - filled));
+		if (count < 0)
+		{
+			throw std::runtime_error("read failed");
+		}
+		if (count == 0)
+		{
+			break; // EOF
+		}
+		filled += static_cast<size_t>(count);
+	}
+
+	buffer.resize(filled);
+	data = buffer.data();
+	size = buffer.size();
+}
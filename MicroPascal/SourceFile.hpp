@@ -0,0 +1,28 @@
+#ifndef SOURCEFILE_HPP
+#define SOURCEFILE_HPP
+
+#include <string>
+#include <string_view>
+
+class SourceFile // read-only view of the whole input, memory-mapped when possible
+{
+public:
+	SourceFile(const std::string& m_path);
+	~SourceFile();
+
+	SourceFile(const SourceFile&) = delete;
+	SourceFile& operator=(const SourceFile&) = delete;
+
+	std::string_view Text() const;
+
+private:
+	void ReadAll(int fd, size_t size_hint);
+
+	const char* data = nullptr;
+	size_t size = 0;
+
+	bool mapped = false; // true -> data points to mmapped memory, buffer unused
+	std::string buffer; // used for pipes, stdin and when mmap is not available
+};
+
+#endif // !SOURCEFILE_HPP
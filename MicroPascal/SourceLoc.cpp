@@ -0,0 +1,22 @@
+#include <algorithm>
+#include <cstring>
+
+#include "SourceLoc.hpp"
+
+LineTable::LineTable(std::string_view text)
+{
+	line_starts.push_back(0);
+
+	const char* begin = text.data();
+	const char* end = begin + text.size();
+	for (const char* found = begin; (found = static_cast<const char*>(std::memchr(found, '\n', end - found))) != nullptr; found++)
+	{
+		line_starts.push_back(static_cast<uint32_t>(found - begin + 1));
+	}
+}
+
+int LineTable::Line(SourceLoc loc) const
+{
+	// number of lines that start at or before loc
+	return static_cast<int>(std::upper_bound(line_starts.begin(), line_starts.end(), loc.offset) - line_starts.begin());
+}
@@ -0,0 +1,35 @@
+#ifndef SOURCELOC_HPP
+#define SOURCELOC_HPP
+
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+// position in the source as byte offset -> 4 bytes in a node instead of a whole token,
+// lines get counted only when an error is reported
+struct SourceLoc
+{
+	uint32_t offset = 0;
+};
+
+struct SourceRange
+{
+	SourceLoc begin;
+	SourceLoc end; // exclusive
+};
+
+// starts of all lines of a source, built once on demand
+class LineTable
+{
+public:
+	LineTable(std::string_view text);
+
+	int Line(SourceLoc loc) const; // numbered from 1, like line_num of tokens
+
+	static constexpr size_t max_source_size = UINT32_MAX; // larger sources cannot be addressed by SourceLoc
+
+private:
+	std::vector<uint32_t> line_starts;
+};
+
+#endif // !SOURCELOC_HPP
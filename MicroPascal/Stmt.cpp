@@ -1,7 +1,7 @@
 #include "Stmt.hpp"
 
-ProgramStmt::ProgramStmt(std::string m_id, std::unique_ptr<Stmt> m_stmt, std::vector<std::shared_ptr<Stmt>> m_decl_stmts)
-	: id(m_id), stmt(std::move(m_stmt)), decl_stmts(std::move(m_decl_stmts)) {};
+ProgramStmt::ProgramStmt(SymbolId m_id, Stmt* m_stmt, Span<Stmt*> m_decl_stmts)
+	: id(m_id), stmt(m_stmt), decl_stmts(m_decl_stmts) {};
 
 void ProgramStmt::Accept(VisitorStmt& visitor)
 {
@@ -9,7 +9,7 @@ void ProgramStmt::Accept(VisitorStmt& visitor)
 }
 
 
-CompoundStmt::CompoundStmt(std::vector<std::unique_ptr<Stmt>> m_statements) : statements(std::move(m_statements)) {};
+CompoundStmt::CompoundStmt(Span<Stmt*> m_statements) : statements(m_statements) {};
 
 void CompoundStmt::Accept(VisitorStmt& visitor)
 {
@@ -17,7 +17,7 @@ void CompoundStmt::Accept(VisitorStmt& visitor)
 }
 
 
-WritelnStmt::WritelnStmt(std::vector<std::unique_ptr<Expr>> m_exprs) : exprs(std::move(m_exprs)) {};
+WritelnStmt::WritelnStmt(Span<Expr*> m_exprs) : exprs(m_exprs) {};
 
 void WritelnStmt::Accept(VisitorStmt& visitor)
 {
@@ -33,7 +33,7 @@ void EmptyStmt::Accept(VisitorStmt& visitor)
 }
 
 
-VarDeclStmt::VarDeclStmt(std::unordered_map<VariableType, std::vector<Token>> m_variables) : variables(m_variables) {};
+VarDeclStmt::VarDeclStmt(Span<std::pair<Identifier, VariableType>> m_variables) : variables(m_variables) {};
 
 void VarDeclStmt::Accept(VisitorStmt& visitor)
 {
@@ -41,8 +41,8 @@ void VarDeclStmt::Accept(VisitorStmt& visitor)
 }
 
 
-FuncDeclStmt::FuncDeclStmt(Token m_id_token, VariableType m_return_type, std::shared_ptr<Stmt> m_body, std::vector<std::shared_ptr<Stmt>> m_decl_stmts, std::vector<std::pair<Token, VariableType>> m_parameters)
-	: id_token(m_id_token), return_type(m_return_type), body(std::move(m_body)), decl_stmts(std::move(m_decl_stmts)), parameters(m_parameters) {};
+FuncDeclStmt::FuncDeclStmt(Identifier m_id, VariableType m_return_type, Stmt* m_body, Span<Stmt*> m_decl_stmts, Span<std::pair<Identifier, VariableType>> m_parameters)
+	: id(m_id), return_type(m_return_type), body(m_body), decl_stmts(m_decl_stmts), parameters(m_parameters) {};
 
 void FuncDeclStmt::Accept(VisitorStmt& visitor)
 {
@@ -50,7 +50,7 @@ void FuncDeclStmt::Accept(VisitorStmt& visitor)
 }
 
 
-AssignmentStmt::AssignmentStmt(Token m_token, std::unique_ptr<Expr> m_value) : token(m_token), value(std::move(m_value)) {};
+AssignmentStmt::AssignmentStmt(Identifier m_id, Expr* m_value) : id(m_id), value(m_value) {};
 
 void AssignmentStmt::Accept(VisitorStmt& visitor)
 {
@@ -58,8 +58,8 @@ void AssignmentStmt::Accept(VisitorStmt& visitor)
 }
 
 
-IfStmt::IfStmt(Token m_token, std::unique_ptr<Expr> m_condition, std::unique_ptr<Stmt> m_then_branch, std::optional<std::unique_ptr<Stmt>> m_else_branch)
-	: token(m_token), condition(std::move(m_condition)), then_branch(std::move(m_then_branch)), else_branch(std::move(m_else_branch)) {};
+IfStmt::IfStmt(SourceLoc m_loc, Expr* m_condition, Stmt* m_then_branch, Stmt* m_else_branch)
+	: loc(m_loc), condition(m_condition), then_branch(m_then_branch), else_branch(m_else_branch) {};
 
 void IfStmt::Accept(VisitorStmt& visitor)
 {
@@ -67,8 +67,8 @@ void IfStmt::Accept(VisitorStmt& visitor)
 }
 
 
-WhileStmt::WhileStmt(Token m_token, std::unique_ptr<Expr> m_condition, std::unique_ptr<Stmt> m_body)
-	: token(m_token), condition(std::move(m_condition)), body(std::move(m_body)) {};
+WhileStmt::WhileStmt(SourceLoc m_loc, Expr* m_condition, Stmt* m_body)
+	: loc(m_loc), condition(m_condition), body(m_body) {};
 
 void WhileStmt::Accept(VisitorStmt& visitor)
 {
@@ -76,8 +76,8 @@ void WhileStmt::Accept(VisitorStmt& visitor)
 }
 
 
-ForStmt::ForStmt(Token m_for_token, bool m_increment, Token m_id_token, std::unique_ptr<Stmt> m_assignment, std::unique_ptr<Expr> m_expression, std::unique_ptr<Stmt> m_body) :
-	for_token(m_for_token), increment(m_increment), id_token(m_id_token), assignment(std::move(m_assignment)), expression(std::move(m_expression)), body(std::move(m_body)) {}
+ForStmt::ForStmt(SourceLoc m_loc, bool m_increment, Identifier m_id, Stmt* m_assignment, Expr* m_expression, Stmt* m_body) :
+	loc(m_loc), increment(m_increment), id(m_id), assignment(m_assignment), expression(m_expression), body(m_body) {}
 
 void ForStmt::Accept(VisitorStmt& visitor)
 {
@@ -85,8 +85,8 @@ void ForStmt::Accept(VisitorStmt& visitor)
 }
 
 
-ProcDeclStmt::ProcDeclStmt(Token m_id_token, std::shared_ptr<Stmt> m_body, std::vector<std::shared_ptr<Stmt>> m_decl_stmts, std::vector<std::pair<Token, VariableType>> m_parameters)
-	: id_token(m_id_token), body(std::move(m_body)), decl_stmts(std::move(m_decl_stmts)), parameters(m_parameters) {};
+ProcDeclStmt::ProcDeclStmt(Identifier m_id, Stmt* m_body, Span<Stmt*> m_decl_stmts, Span<std::pair<Identifier, VariableType>> m_parameters)
+	: id(m_id), body(m_body), decl_stmts(m_decl_stmts), parameters(m_parameters) {};
 
 void ProcDeclStmt::Accept(VisitorStmt& visitor)
 {
@@ -94,10 +94,19 @@ void ProcDeclStmt::Accept(VisitorStmt& visitor)
 }
 
 
-ProcedureCallStmt::ProcedureCallStmt(std::vector<std::unique_ptr<Expr>> m_arguments, Token m_id_token)
-	: arguments(std::move(m_arguments)), id_token(m_id_token) {};
+ProcedureCallStmt::ProcedureCallStmt(Span<Expr*> m_arguments, Identifier m_id)
+	: arguments(m_arguments), id(m_id) {};
 
 void ProcedureCallStmt::Accept(VisitorStmt& visitor)
 {
 	return visitor.Visit(*this);
 }
+
+
+InlinedCallStmt::InlinedCallStmt(Span<Expr*> m_arguments, Stmt* m_body, Span<VariableType> m_slots, uint32_t m_base)
+	: arguments(m_arguments), body(m_body), slots(m_slots), base(m_base) {};
+
+void InlinedCallStmt::Accept(VisitorStmt& visitor)
+{
+	return visitor.Visit(*this);
+}
@@ -1,10 +1,10 @@
 #ifndef STMT_HPP
 #define STMT_HPP
 
-#include <optional>
+#include <utility>
 #include <vector>
-#include <unordered_map>
 
+#include "Arena.hpp"
 #include "Token.hpp"
 #include "Expr.hpp"
 
@@ -20,6 +20,8 @@ class WhileStmt;
 class ForStmt;
 class ProcDeclStmt;
 class ProcedureCallStmt;
+class InlinedCallStmt;
+class Stmt;
 
 class VisitorStmt
 {
@@ -36,47 +38,63 @@ public:
 	virtual void Visit(ForStmt& forStmt) = 0;
 	virtual void Visit(ProcDeclStmt& procDeclStmt) = 0;
 	virtual void Visit(ProcedureCallStmt& procedureCallStmt) = 0;
+	virtual void Visit(InlinedCallStmt& inlinedCallStmt) = 0;
 };
 
 
-class Stmt
+// what a call needs to know about a routine, filled in by the resolver
+struct Routine
 {
-public:
-	virtual ~Stmt() {};
+	Stmt* body = nullptr; // nullptr -> not laid out yet
+	Span<VariableType> slots; // environment of one activation -> parameters first, then the return variable of a function, then local variables
+	uint32_t parameter_count = 0;
+	bool is_function = false; // return variable in slot parameter_count
+	bool pure = false; // function of its arguments alone -> results get memoized, filled in by the purity analyzer
+	bool stack_check = true; // declared in a {$S+} region -> calls check the depth of nesting
+	std::vector<Literal> frame; // zero values of slots, filled in by the interpreter on the first call -> later ones copy it, cleared with a new layout
+};
+
 
+class Stmt // nodes live in an arena -> never deleted through this base
+{
+public:
 	virtual void Accept(VisitorStmt& visitor) = 0;
+
+protected:
+	~Stmt() = default;
 };
 
 class ProgramStmt : public Stmt
 {
 public:
-	ProgramStmt(std::string m_id, std::unique_ptr<Stmt> m_stmt, std::vector<std::shared_ptr<Stmt>> m_decl_stmts);
+	ProgramStmt(SymbolId m_id, Stmt* m_stmt, Span<Stmt*> m_decl_stmts);
 
 	void Accept(VisitorStmt& visitor) override;
 
-	std::string id;
-	std::unique_ptr<Stmt> stmt;
-	std::vector<std::shared_ptr<Stmt>> decl_stmts;
+	SymbolId id;
+	Stmt* stmt;
+	Span<Stmt*> decl_stmts;
+	Span<VariableType> slots; // global environment, filled in by the resolver
 };
 
 class CompoundStmt : public Stmt
 {
 public:
-	CompoundStmt(std::vector<std::unique_ptr<Stmt>> m_statements);
+	CompoundStmt(Span<Stmt*> m_statements);
 
 	void Accept(VisitorStmt& visitor) override;
 
-	std::vector<std::unique_ptr<Stmt>> statements;
+	Span<Stmt*> statements;
 };
 
 class WritelnStmt : public Stmt
 {
 public:
-	WritelnStmt(std::vector<std::unique_ptr<Expr>> m_exprs);
+	WritelnStmt(Span<Expr*> m_exprs);
 
 	void Accept(VisitorStmt& visitor) override;
 
-	std::vector<std::unique_ptr<Expr>> exprs;
+	Span<Expr*> exprs;
 };
 
 class EmptyStmt : public Stmt
@@ -90,52 +108,57 @@ public:
 class VarDeclStmt : public Stmt
 {
 public:
-	VarDeclStmt(std::unordered_map<VariableType, std::vector<Token>> m_variables);
+	VarDeclStmt(Span<std::pair<Identifier, VariableType>> m_variables);
 
 	void Accept(VisitorStmt& visitor) override;
 
-	std::unordered_map<VariableType, std::vector<Token>> variables;
+	Span<std::pair<Identifier, VariableType>> variables; // grouped by type
 };
 
 class FuncDeclStmt : public Stmt
 {
 public:
-	FuncDeclStmt(Token m_id_token, VariableType m_return_type, std::shared_ptr<Stmt> m_body, std::vector<std::shared_ptr<Stmt>> m_decl_stmts,
-		std::vector<std::pair<Token, VariableType>> m_parameters);
+	FuncDeclStmt(Identifier m_id, VariableType m_return_type, Stmt* m_body, Span<Stmt*> m_decl_stmts,
+		Span<std::pair<Identifier, VariableType>> m_parameters);
 
 	void Accept(VisitorStmt& visitor) override;
 
-	Token id_token;
+	Identifier id;
 	VariableType return_type;
-	std::shared_ptr<Stmt> body;
-	std::vector<std::shared_ptr<Stmt>> decl_stmts;
-	std::vector<std::pair<Token, VariableType>> parameters;
+	Stmt* body;
+	Span<Stmt*> decl_stmts;
+	Span<std::pair<Identifier, VariableType>> parameters;
+	Routine* routine = nullptr; // shared with the declaration it replaced in watch mode -> calls elsewhere stay valid
 };
 
 
 class ProcDeclStmt : public Stmt
 {
 public:
-	ProcDeclStmt(Token m_id_token, std::shared_ptr<Stmt> m_body, std::vector<std::shared_ptr<Stmt>> m_decl_stmts,
-		std::vector<std::pair<Token, VariableType>> m_parameters);
+	ProcDeclStmt(Identifier m_id, Stmt* m_body, Span<Stmt*> m_decl_stmts,
+		Span<std::pair<Identifier, VariableType>> m_parameters);
 
 	void Accept(VisitorStmt& visitor) override;
 
-	Token id_token;
-	std::shared_ptr<Stmt> body;
-	std::vector<std::shared_ptr<Stmt>> decl_stmts;
-	std::vector<std::pair<Token, VariableType>> parameters;
+	Identifier id;
+	Stmt* body;
+	Span<Stmt*> decl_stmts;
+	Span<std::pair<Identifier, VariableType>> parameters;
+	Routine* routine = nullptr;
 };
 
 class ProcedureCallStmt : public Stmt
 {
 public:
-	ProcedureCallStmt(std::vector<std::unique_ptr<Expr>> m_arguments, Token m_id_token);
+	ProcedureCallStmt(Span<Expr*> m_arguments, Identifier m_id);
 
 	void Accept(VisitorStmt& visitor) override;
 
-	std::vector<std::unique_ptr<Expr>> arguments;
-	Token id_token;
+	Span<Expr*> arguments;
+	Identifier id;
+	Routine* callee = nullptr;
+	uint32_t depth = 0; // environments to go up from the caller's one to the one callee was declared in
+	bool tail = false; // caller calling itself as the last thing it does -> reuses its environment, filled in by the tail call finder
 };
 
 
@@ -143,52 +166,90 @@ public:
 class AssignmentStmt : public Stmt
 {
 public:
-	AssignmentStmt(Token m_token, std::unique_ptr<Expr> m_value);
+	AssignmentStmt(Identifier m_id, Expr* m_value);
 
 	void Accept(VisitorStmt& visitor) override;
 
-	Token token;
-	std::unique_ptr<Expr> value;
+	Identifier id;
+	Expr* value;
+	Address address;
 };
 
 class IfStmt : public Stmt
 {
 public:
-	IfStmt(Token m_token, std::unique_ptr<Expr> m_condition, std::unique_ptr<Stmt> m_then_branch, std::optional<std::unique_ptr<Stmt>> m_else_branch);
+	IfStmt(SourceLoc m_loc, Expr* m_condition, Stmt* m_then_branch, Stmt* m_else_branch);
 
 	void Accept(VisitorStmt& visitor) override;
 
-	Token token;
-	std::unique_ptr<Expr> condition;
-	std::unique_ptr<Stmt> then_branch;
-	std::optional<std::unique_ptr<Stmt>> else_branch;
+	SourceLoc loc;
+	Expr* condition;
+	Stmt* then_branch;
+	Stmt* else_branch; // nullptr if there is none
 };
 
 class WhileStmt : public Stmt
 {
 public:
-	WhileStmt(Token m_token, std::unique_ptr<Expr> m_condition, std::unique_ptr<Stmt> m_body);
+	WhileStmt(SourceLoc m_loc, Expr* m_condition, Stmt* m_body);
 
 	void Accept(VisitorStmt& visitor) override;
 
-	Token token;
-	std::unique_ptr<Expr> condition;
-	std::unique_ptr<Stmt> body;
+	SourceLoc loc;
+	Expr* condition;
+	Stmt* body;
+};
+
+// accumulation a for body does on every iteration -> target := target + coefficient * counter + constant
+struct Reduction
+{
+	Address target;
+	Expr* coefficient; // both read nothing the loop writes
+	Expr* constant;
+};
+
+// product of a for counter and a step the loop does not change -> kept in a slot by adding the step on every iteration
+struct Induction
+{
+	uint32_t slot; // in the environment the loop runs in
+	Expr* step; // literal or variable
 };
 
 class ForStmt : public Stmt
 {
 public:
-	ForStmt(Token m_for_token, bool m_increment, Token m_id_token, std::unique_ptr<Stmt> m_assignment, std::unique_ptr<Expr> m_expression, std::unique_ptr<Stmt> m_body);
+	ForStmt(SourceLoc m_loc, bool m_increment, Identifier m_id, Stmt* m_assignment, Expr* m_expression, Stmt* m_body);
 
 	void Accept(VisitorStmt& visitor) override;
 
-	Token for_token;
+	SourceLoc loc;
 	bool increment;
-	Token id_token;
-	std::unique_ptr<Stmt> assignment;
-	std::unique_ptr<Expr> expression;
-	std::unique_ptr<Stmt> body;
+	Identifier id;
+	Stmt* assignment;
+	Expr* expression;
+	Stmt* body;
+	Address address; // of the counter
+	bool closed_form = false; // body does nothing but reductions -> all iterations run at once, filled in by the loop reducer
+	Span<Reduction> reductions;
+	Span<Induction> inductions; // few enough for the interpreter to keep them at hand
+
+	static constexpr size_t max_inductions = 4;
+};
+
+// call the inliner replaced by a copy of the callee's body, which runs on slots of the caller's environment
+// -> made after resolving, never parsed
+class InlinedCallStmt : public Stmt
+{
+public:
+	InlinedCallStmt(Span<Expr*> m_arguments, Stmt* m_body, Span<VariableType> m_slots, uint32_t m_base);
+
+	void Accept(VisitorStmt& visitor) override;
+
+	Span<Expr*> arguments; // go to the first slots
+	Stmt* body;
+	Span<VariableType> slots; // of the callee -> reset on every call, like a fresh environment
+	uint32_t base; // slot of the caller's environment where those of the callee begin
+	bool stack_check = true; // of the callee
 };
 
 #endif // !STMT_HPP
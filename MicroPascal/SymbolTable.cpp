@@ -0,0 +1,101 @@
+#include "SymbolTable.hpp"
+
+SymbolTable::SymbolTable() : slots(256, 0) {}
+
+SymbolId SymbolTable::Intern(std::string_view name)
+{
+	uint32_t hash = Hash(name);
+	size_t mask = slots.size() - 1;
+
+	// linear probing
+	for (size_t i = hash & mask; ; i = (i + 1) & mask)
+	{
+		if (slots[i] == 0) // not there yet -> new symbol
+		{
+			SymbolId id = static_cast<SymbolId>(names.size());
+
+			std::string lowered(name);
+			for (char& c : lowered)
+			{
+				c = ToLower(c);
+			}
+			names.push_back(std::move(lowered));
+			hashes.push_back(hash);
+			slots[i] = id + 1;
+
+			if (names.size() * 2 > slots.size()) // keep load factor under 1/2
+			{
+				Grow();
+			}
+			return id;
+		}
+
+		SymbolId id = slots[i] - 1;
+		if (hashes[id] == hash && Matches(id, name))
+		{
+			return id;
+		}
+	}
+}
+
+const std::string& SymbolTable::Name(SymbolId id) const
+{
+	return names[id];
+}
+
+size_t SymbolTable::Size() const
+{
+	return names.size();
+}
+
+
+// FNV-1a over lowercased chars -> "Foo" and "foo" hash the same without making a lowercased copy
+uint32_t SymbolTable::Hash(std::string_view name)
+{
+	uint32_t hash = 2166136261u;
+	for (char c : name)
+	{
+		hash ^= static_cast<unsigned char>(ToLower(c));
+		hash *= 16777619u;
+	}
+	return hash;
+}
+
+// identifiers are ASCII letters, digits and '_' only
+char SymbolTable::ToLower(char c)
+{
+	return (c >= 'A' && c <= 'Z') ? static_cast<char>(c + ('a' - 'A')) : c;
+}
+
+bool SymbolTable::Matches(SymbolId id, std::string_view name) const
+{
+	const std::string& stored = names[id];
+	if (stored.size() != name.size())
+	{
+		return false;
+	}
+	for (size_t i = 0; i < name.size(); i++)
+	{
+		if (stored[i] != ToLower(name[i]))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+void SymbolTable::Grow()
+{
+	slots.assign(slots.size() * 2, 0);
+	size_t mask = slots.size() - 1;
+
+	for (SymbolId id = 0; id < names.size(); id++)
+	{
+		size_t i = hashes[id] & mask;
+		while (slots[i] != 0)
+		{
+			i = (i + 1) & mask;
+		}
+		slots[i] = id + 1;
+	}
+}
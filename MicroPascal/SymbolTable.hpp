@@ -0,0 +1,31 @@
+#ifndef SYMBOLTABLE_HPP
+#define SYMBOLTABLE_HPP
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using SymbolId = uint32_t;
+
+class SymbolTable // interns identifiers, each distinct lowercased name gets a dense id in order of first appearance
+{
+public:
+	SymbolTable();
+
+	SymbolId Intern(std::string_view name); // case insensitive, lowercases only names seen for the first time
+	const std::string& Name(SymbolId id) const;
+	size_t Size() const;
+
+private:
+	static uint32_t Hash(std::string_view name);
+	static char ToLower(char c);
+	bool Matches(SymbolId id, std::string_view name) const;
+	void Grow();
+
+	std::vector<std::string> names; // lowercased, indexed by id
+	std::vector<uint32_t> hashes; // indexed by id, kept for rehashing
+	std::vector<SymbolId> slots; // open addressing, id + 1 (0 -> empty slot)
+};
+
+#endif // !SYMBOLTABLE_HPP
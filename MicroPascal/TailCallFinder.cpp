@@ -0,0 +1,78 @@
+#include "TailCallFinder.hpp"
+
+void TailCallFinder::Find(Stmt* program)
+{
+	FindInDecls(static_cast<ProgramStmt*>(program)->decl_stmts);
+}
+
+void TailCallFinder::FindInDecls(Span<Stmt*> decl_stmts)
+{
+	for (auto&& decl : decl_stmts)
+	{
+		if (auto* funcDecl = dynamic_cast<FuncDeclStmt*>(decl))
+		{
+			FindInRoutine(funcDecl->routine, funcDecl->decl_stmts, funcDecl->body);
+		}
+		else if (auto* procDecl = dynamic_cast<ProcDeclStmt*>(decl))
+		{
+			FindInRoutine(procDecl->routine, procDecl->decl_stmts, procDecl->body);
+		}
+	}
+}
+
+void TailCallFinder::FindInRoutine(Routine* routine, Span<Stmt*> decl_stmts, Stmt* body)
+{
+	FindInDecls(decl_stmts);
+	Mark(routine, body);
+}
+
+// calls of routine from its own body go one environment up -> the same one the interpreter's current call came from
+void TailCallFinder::Mark(Routine* routine, Stmt* stmt)
+{
+	if (auto* compound = dynamic_cast<CompoundStmt*>(stmt))
+	{
+		for (size_t i = compound->statements.size(); i > 0; i--)
+		{
+			if (dynamic_cast<EmptyStmt*>(compound->statements[i - 1]) == nullptr)
+			{
+				Mark(routine, compound->statements[i - 1]);
+				return;
+			}
+		}
+		return;
+	}
+
+	if (auto* ifStmt = dynamic_cast<IfStmt*>(stmt))
+	{
+		Mark(routine, ifStmt->then_branch);
+		if (ifStmt->else_branch != nullptr)
+		{
+			Mark(routine, ifStmt->else_branch);
+		}
+		return;
+	}
+
+	// a function calling itself as a statement -> running the body again would reset the result it already assigned
+	if (auto* call = dynamic_cast<ProcedureCallStmt*>(stmt))
+	{
+		call->tail = call->callee == routine && !routine->is_function;
+		return;
+	}
+
+	// result of the call becomes the result of the function -> nothing left to do with it
+	auto* assignment = dynamic_cast<AssignmentStmt*>(stmt);
+	if (assignment == nullptr || !routine->is_function
+		|| assignment->address.depth != 0 || assignment->address.slot != routine->parameter_count)
+	{
+		return;
+	}
+	Expr* value = assignment->value;
+	while (auto* grouping = dynamic_cast<GroupingExpr*>(value))
+	{
+		value = grouping->expr;
+	}
+	if (auto* call = dynamic_cast<FunctionCallExpr*>(value))
+	{
+		call->tail = call->callee == routine;
+	}
+}
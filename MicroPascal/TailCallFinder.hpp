@@ -0,0 +1,21 @@
+#ifndef TAILCALLFINDER_HPP
+#define TAILCALLFINDER_HPP
+
+#include "Expr.hpp"
+#include "Stmt.hpp"
+
+// pass over a resolved program -> a routine calling itself as the last thing its body does (a procedure calling itself
+// to end its body, an assignment of a call to the function's result ending it) gets the call marked, the interpreter then
+// runs the body again in the same environment instead of nesting a new one
+class TailCallFinder
+{
+public:
+	void Find(Stmt* program);
+
+private:
+	void FindInRoutine(Routine* routine, Span<Stmt*> decl_stmts, Stmt* body);
+	void FindInDecls(Span<Stmt*> decl_stmts);
+	static void Mark(Routine* routine, Stmt* stmt); // stmt ends the body of routine
+};
+
+#endif // !TAILCALLFINDER_HPP
@@ -1,14 +1,19 @@
 #ifndef TOKEN_HPP
 #define TOKEN_HPP
 
+#include <cstdint>
 #include <variant>
 #include <iostream>
+#include <string>
+#include <string_view>
 
 #include "TokenType.hpp"
+#include "SourceLoc.hpp"
+#include "SymbolTable.hpp"
 
 using Literal = std::variant<std::nullptr_t, int, bool, std::string>;
 
-enum class VariableType
+enum class VariableType : uint8_t
 {
 	INTEGER,
 	BOOL,
@@ -18,8 +23,9 @@ enum class VariableType
 class Token
 {
 public:
-	Token(TokenType m_type, std::string m_lexeme, Literal m_lit, int m_line_num)
-		: type(m_type), lexeme(m_lexeme), lit(m_lit), line_num(m_line_num) {}
+	Token() : type(TokenType::END_OF_FILE), line_num(0), symbol(0) {}
+	Token(TokenType m_type, std::string_view m_lexeme, int m_line_num, SourceLoc m_loc, SymbolId m_symbol = 0)
+		: type(m_type), line_num(m_line_num), lexeme(m_lexeme), loc(m_loc), symbol(m_symbol) {}
 
 	void Print()
 	{
@@ -27,9 +33,17 @@ public:
 	}
 
 	TokenType type;
-	std::string lexeme; // what lexer read, identifiers converted to lower case
-	Literal lit;
-	int line_num; // for error handling
+	int line_num; // for error handling, next to type -> no padding
+	std::string_view lexeme; // view into the source buffer (must outlive the tokens), identifiers keep their original case
+	SourceLoc loc; // what the tree keeps instead of the token
+	SymbolId symbol; // interned lowercased name, only meaningful for ID tokens
+};
+
+// identifier as kept in the tree -> interned name and where it was written
+struct Identifier
+{
+	SymbolId symbol;
+	SourceLoc loc;
 };
 
 #endif // !TOKEN_HPP
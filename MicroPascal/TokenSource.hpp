@@ -0,0 +1,25 @@
+#ifndef TOKENSOURCE_HPP
+#define TOKENSOURCE_HPP
+
+#include <cstddef>
+
+#include "Token.hpp"
+
+class TokenSource // stream of tokens the parser pulls from, ends with END_OF_FILE forever
+{
+public:
+	virtual ~TokenSource() {};
+
+	virtual Token NextToken() = 0;
+
+	// drops next count tokens, sources with random access can jump instead
+	virtual void Skip(size_t count)
+	{
+		for (size_t i = 0; i < count; i++)
+		{
+			NextToken();
+		}
+	}
+};
+
+#endif // !TOKENSOURCE_HPP
@@ -1,9 +1,10 @@
 #ifndef TOKENTYPE_HPP
 #define TOKENTYPE_HPP
 
+#include <cstdint>
 #include <ostream>
 
-enum class TokenType
+enum class TokenType : uint8_t // kept in tree nodes -> one byte
 {
 	// single char
 	SEMICOLON,
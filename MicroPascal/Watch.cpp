@@ -0,0 +1,372 @@
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <stdexcept>
+#include <thread>
+
+#include "Watch.hpp"
+#include "Lexer.hpp"
+#include "Parser.hpp"
+#include "TailCallFinder.hpp"
+#include "Interpreter.hpp"
+#include "SourceFile.hpp"
+
+using Clock = std::chrono::steady_clock;
+
+static constexpr size_t compare_block = 4096;
+
+// length of the common start of two texts, compared blockwise -> memcmp instead of a loop over chars
+static size_t CommonPrefix(const std::string& a, const std::string& b)
+{
+	size_t limit = std::min(a.size(), b.size());
+	size_t pos = 0;
+	while (pos + compare_block <= limit && std::memcmp(a.data() + pos, b.data() + pos, compare_block) == 0)
+	{
+		pos += compare_block;
+	}
+	while (pos < limit && a[pos] == b[pos])
+	{
+		pos++;
+	}
+	return pos;
+}
+
+// length of the common end of two texts, at most limit
+static size_t CommonSuffix(const std::string& a, const std::string& b, size_t limit)
+{
+	size_t length = 0;
+	while (length + compare_block <= limit &&
+		std::memcmp(a.data() + a.size() - length - compare_block, b.data() + b.size() - length - compare_block, compare_block) == 0)
+	{
+		length += compare_block;
+	}
+	while (length < limit && a[a.size() - 1 - length] == b[b.size() - 1 - length])
+	{
+		length++;
+	}
+	return length;
+}
+
+
+WatchSession::WatchSession(std::string m_path, bool m_print_timings, Switches m_switches) : path(std::move(m_path)), print_timings(m_print_timings), switches(m_switches) {}
+
+void WatchSession::Run()
+{
+	std::filesystem::file_time_type seen_time;
+	uintmax_t seen_size = 0;
+	bool first = true;
+
+	while (true)
+	{
+		std::error_code error;
+		auto time = std::filesystem::last_write_time(path, error);
+		uintmax_t size = error ? 0 : std::filesystem::file_size(path, error);
+
+		if (!error && (first || time != seen_time || size != seen_size))
+		{
+			seen_time = time;
+			seen_size = size;
+
+			bool read = true;
+			try
+			{
+				SourceFile source(path);
+				if (source.Text().size() > LineTable::max_source_size)
+				{
+					throw std::length_error("source too large");
+				}
+				next_text.assign(source.Text()); // own copy -> next version gets compared to it
+			}
+			catch (const std::exception&)
+			{
+				std::cerr << "Error: file error." << std::endl;
+				read = false;
+			}
+
+			if (read)
+			{
+				if (!first)
+				{
+					std::cerr << "--- " << path << " changed" << std::endl;
+				}
+				if (Update())
+				{
+					Execute();
+				}
+				std::cout.flush();
+			}
+			first = false;
+		}
+
+		std::this_thread::sleep_for(std::chrono::milliseconds(100));
+	}
+}
+
+bool WatchSession::Update()
+{
+	auto start = Clock::now();
+
+	// replaced declarations stay in the arena -> parse all again once they outweigh the live tree
+	if (program != nullptr && nodes->Size() <= 2 * parsed_size && ParseChanged())
+	{
+		if (print_timings)
+		{
+			std::chrono::duration<double, std::milli> elapsed = Clock::now() - start;
+			std::cerr << "reparse: " << elapsed.count() << " ms" << std::endl;
+		}
+		return true;
+	}
+
+	try
+	{
+		ParseAll();
+	}
+	catch (Error& e)
+	{
+		Report(e);
+		return false;
+	}
+
+	if (print_timings)
+	{
+		std::chrono::duration<double, std::milli> elapsed = Clock::now() - start;
+		std::cerr << "lex+parse: " << elapsed.count() << " ms" << std::endl;
+	}
+	return true;
+}
+
+// whole text, each declaration segment reaches from where the previous one ended
+void WatchSession::ParseAll()
+{
+	auto new_nodes = std::make_unique<Arena>();
+	auto new_symbols = std::make_unique<SymbolTable>();
+	std::vector<SourceRange> ranges;
+
+	Lexer lex(next_text, *new_symbols);
+	Parser par(lex, *new_nodes);
+	program = static_cast<ProgramStmt*>(par.Parse(ranges));
+
+	text.swap(next_text);
+	nodes = std::move(new_nodes);
+	symbols = std::move(new_symbols);
+	parsed_size = nodes->Size();
+	resolver = std::make_unique<Resolver>(*nodes);
+	resolve_all = true;
+
+	uint32_t size = static_cast<uint32_t>(text.size());
+	declarations.clear();
+	for (auto&& range : ranges)
+	{
+		SourceLoc begin = declarations.empty() ? range.begin : declarations.back().range.end;
+		declarations.push_back({ { begin, range.end }, begin.offset });
+	}
+
+	uint32_t decls_begin = declarations.empty() ? size : declarations.front().range.begin.offset;
+	uint32_t decls_end = declarations.empty() ? size : declarations.back().range.end.offset;
+	head = { { SourceLoc{ 0 }, SourceLoc{ decls_begin } }, 0 };
+	tail = { { SourceLoc{ decls_end }, SourceLoc{ size } }, decls_end };
+	next_origin = size + 1;
+}
+
+bool WatchSession::ParseChanged()
+{
+	// edited part of the old text
+	size_t prefix = CommonPrefix(text, next_text);
+	if (prefix == text.size() && prefix == next_text.size())
+	{
+		return true; // only touched
+	}
+	if (declarations.empty())
+	{
+		return false;
+	}
+	size_t suffix = CommonSuffix(text, next_text, std::min(text.size(), next_text.size()) - prefix);
+	size_t change_begin = prefix;
+	size_t change_end = text.size() - suffix;
+	if (change_begin < head.range.end.offset || change_end > tail.range.begin.offset)
+	{
+		return false; // header or main statement
+	}
+
+	// declarations touched by the edit, including the ones it borders on
+	auto first = std::partition_point(declarations.begin(), declarations.end(),
+		[&](const Segment& segment) { return segment.range.end.offset < change_begin; }) - declarations.begin();
+	auto last = std::partition_point(declarations.begin(), declarations.end(),
+		[&](const Segment& segment) { return segment.range.begin.offset <= change_end; }) - declarations.begin() - 1;
+	auto count = static_cast<decltype(first)>(declarations.size());
+	auto low = std::clamp<decltype(first)>(std::min(first, last), 0, count - 1);
+	auto high = std::clamp<decltype(first)>(std::max(first, last), 0, count - 1);
+
+	size_t span_begin = std::min<size_t>(declarations[low].range.begin.offset, change_begin);
+	size_t span_end = std::max<size_t>(declarations[high].range.end.offset, change_end) + next_text.size() - text.size();
+	size_t span_size = span_end - span_begin;
+	if (static_cast<uint64_t>(next_origin) + span_size + 1 > LineTable::max_source_size)
+	{
+		return false; // locations used up
+	}
+
+	// lexed on its own with locations nobody uses yet, lines only matter for syntax errors -> those get reported by a full parse
+	std::vector<SourceRange> ranges;
+	Span<Stmt*> parsed;
+	try
+	{
+		Lexer lex(std::string_view(next_text).substr(span_begin, span_size), *symbols, 1, SourceLoc{ next_origin });
+		Parser par(lex, *nodes);
+		parsed = par.ParseDeclarations(ranges);
+	}
+	catch (const Error&)
+	{
+		return false; // full parse reports it the way a normal run would
+	}
+
+	// splice into the program, in place if the number of declarations stays
+	Span<Stmt*> old_decls = program->decl_stmts;
+	if (parsed.size() == static_cast<size_t>(high - low + 1))
+	{
+		for (size_t i = 0; i < parsed.size(); i++)
+		{
+			resolve_all = resolve_all || !Resolver::Replace(old_decls[low + i], parsed[i]);
+		}
+		changed_first = low;
+		changed_count = parsed.size();
+		std::copy(parsed.begin(), parsed.end(), old_decls.begin() + low);
+	}
+	else
+	{
+		resolve_all = true;
+		std::vector<Stmt*> decls(old_decls.begin(), old_decls.begin() + low);
+		decls.insert(decls.end(), parsed.begin(), parsed.end());
+		decls.insert(decls.end(), old_decls.begin() + high + 1, old_decls.end());
+		program->decl_stmts = nodes->Copy(decls);
+	}
+
+	// segments of the new declarations cover the whole span, the following ones move
+	std::vector<Segment> fresh;
+	for (size_t i = 0; i < ranges.size(); i++)
+	{
+		uint32_t begin = fresh.empty() ? static_cast<uint32_t>(span_begin) : fresh.back().range.end.offset;
+		uint32_t end = (i + 1 == ranges.size()) ? static_cast<uint32_t>(span_end) : static_cast<uint32_t>(ranges[i].end.offset - next_origin + span_begin);
+		fresh.push_back({ { SourceLoc{ begin }, SourceLoc{ end } }, static_cast<uint32_t>(next_origin + begin - span_begin) });
+	}
+
+	uint32_t delta = static_cast<uint32_t>(next_text.size() - text.size()); // wraps around for deletions
+	for (auto it = declarations.begin() + high + 1; it != declarations.end(); ++it)
+	{
+		it->range.begin.offset += delta;
+		it->range.end.offset += delta;
+	}
+	tail.range.begin.offset += delta;
+	tail.range.end.offset += delta;
+
+	if (fresh.size() == static_cast<size_t>(high - low + 1))
+	{
+		std::copy(fresh.begin(), fresh.end(), declarations.begin() + low);
+	}
+	else
+	{
+		declarations.erase(declarations.begin() + low, declarations.begin() + high + 1);
+		declarations.insert(declarations.begin() + low, fresh.begin(), fresh.end());
+	}
+
+	next_origin += static_cast<uint32_t>(span_size + 1);
+	text.swap(next_text);
+
+	if (print_timings)
+	{
+		std::cerr << "reparsed " << ranges.size() << " of " << declarations.size() << " declarations" << std::endl;
+	}
+	return true;
+}
+
+void WatchSession::Execute()
+{
+	auto start = Clock::now();
+	try
+	{
+		// untouched declarations keep their addresses as long as the names they refer to stay
+		bool all = resolve_all;
+		resolve_all = true; // until resolving went through
+		if (all)
+		{
+			resolver->Resolve(program);
+		}
+		else
+		{
+			resolver->Resolve(*program, changed_first, changed_count);
+		}
+		resolve_all = false;
+		changed_count = 0;
+		TailCallFinder tail_calls; // right after resolving, as in a normal run -> how deep recursion may go does not depend on the mode
+		tail_calls.Find(program);
+
+		// switches of untouched declarations may have changed with an edit elsewhere -> marked again unless all are default ones
+		Directives directives(switches);
+		Lexer::ScanDirectives(text, directives);
+		if (!directives.Default() || switched)
+		{
+			for (size_t i = 0; i < declarations.size(); i++)
+			{
+				directives.Apply(program->decl_stmts[i], declarations[i].range.begin.offset - declarations[i].origin);
+			}
+			directives.Apply(program->stmt, tail.range.begin.offset - tail.origin);
+		}
+		switched = !directives.Default();
+		if (print_timings)
+		{
+			std::chrono::duration<double, std::milli> elapsed = Clock::now() - start;
+			std::cerr << "resolve: " << elapsed.count() << " ms" << std::endl;
+			start = Clock::now();
+		}
+
+		Interpreter interpreter;
+		interpreter.Interpret(program);
+	}
+	catch (Error& e)
+	{
+		Report(e);
+	}
+
+	if (print_timings)
+	{
+		std::chrono::duration<double, std::milli> elapsed = Clock::now() - start;
+		std::cerr << "run: " << elapsed.count() << " ms" << std::endl;
+	}
+}
+
+SourceLoc WatchSession::Locate(SourceLoc loc) const
+{
+	auto contains = [&](const Segment& segment, bool closed)
+	{
+		uint32_t size = segment.range.end.offset - segment.range.begin.offset;
+		return loc.offset >= segment.origin && (loc.offset - segment.origin < size || (closed && loc.offset - segment.origin == size));
+	};
+	auto moved = [&](const Segment& segment)
+	{
+		return SourceLoc{ loc.offset - segment.origin + segment.range.begin.offset };
+	};
+
+	if (contains(head, false))
+	{
+		return moved(head);
+	}
+	for (auto&& segment : declarations) // only on errors -> no index kept
+	{
+		if (contains(segment, false))
+		{
+			return moved(segment);
+		}
+	}
+	return contains(tail, true) ? moved(tail) : loc;
+}
+
+void WatchSession::Report(Error& e) const
+{
+	if (!e.HasLine())
+	{
+		e = Error(Locate(e.Loc()), e.Message());
+		e.ResolveLine(LineTable(text));
+	}
+	std::cout << e.what() << std::endl;
+}
@@ -0,0 +1,66 @@
+#ifndef WATCH_HPP
+#define WATCH_HPP
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Arena.hpp"
+#include "Directives.hpp"
+#include "Error.hpp"
+#include "Resolver.hpp"
+#include "SourceLoc.hpp"
+#include "Stmt.hpp"
+#include "SymbolTable.hpp"
+
+// runs a source file again on every change, keeping the tree of its last version ->
+// only top level declarations touched by an edit get lexed and parsed again and are spliced into the program
+class WatchSession
+{
+public:
+	WatchSession(std::string m_path, bool m_print_timings, Switches m_switches);
+
+	[[noreturn]] void Run(); // polls the file
+
+private:
+	// part of the current text whose nodes got their locations when it started at origin,
+	// edits elsewhere only move it -> nodes keep their locations, Locate maps them
+	struct Segment
+	{
+		SourceRange range;
+		uint32_t origin;
+	};
+
+	bool Update(); // next_text -> text, false if it does not parse (last version stays then)
+	void ParseAll();
+	bool ParseChanged(); // false -> edit is not confined to declarations or they do not parse on their own
+	void Execute();
+
+	SourceLoc Locate(SourceLoc loc) const; // location of a node -> offset in the current text
+	void Report(Error& e) const;
+
+	std::string path;
+	bool print_timings;
+	Switches switches; // before any directive of the source
+	bool switched = false; // nodes carry flags of switches other than the default ones
+
+	std::string text; // last version that parsed
+	std::string next_text; // swapped with text -> buffers get reused, no fresh pages for every version
+	std::unique_ptr<Arena> nodes;
+	std::unique_ptr<SymbolTable> symbols;
+	ProgramStmt* program = nullptr;
+
+	Segment head; // header, up to the first declaration
+	std::vector<Segment> declarations; // one per top level declaration, parallel to decl_stmts of the program
+	Segment tail; // main statement, after the last declaration
+	uint32_t next_origin = 0; // locations from here on are not used by any node yet
+	size_t parsed_size = 0; // of the arena after the last full parse -> replaced declarations are garbage beyond it
+
+	std::unique_ptr<Resolver> resolver; // keeps the names of the program's scope bound between runs
+	bool resolve_all = true; // unless only declarations got replaced by ones declaring the same names
+	size_t changed_first = 0;
+	size_t changed_count = 0;
+};
+
+#endif // !WATCH_HPP
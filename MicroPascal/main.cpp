@@ -1,64 +1,257 @@
+#include <algorithm>
 #include <iostream>
-#include <fstream>
-#include <sstream>
+#include <chrono>
+#include <memory>
+#include <stdexcept>
+#include <thread>
 
 #include "Error.hpp"
+#include "CharScan.hpp"
+#include "SourceFile.hpp"
+#include "SymbolTable.hpp"
 #include "Lexer.hpp"
+#include "ParallelLexer.hpp"
 #include "Parser.hpp"
+#include "ParallelParser.hpp"
+#include "ProgramImage.hpp"
+#include "Watch.hpp"
+#include "Resolver.hpp"
+#include "Directives.hpp"
+#include "Inliner.hpp"
+#include "ConstantFolder.hpp"
+#include "DeadCodeEliminator.hpp"
+#include "RangeAnalyzer.hpp"
+#include "LoopHoister.hpp"
+#include "LoopReducer.hpp"
+#include "PurityAnalyzer.hpp"
+#include "TailCallFinder.hpp"
 #include "Interpreter.hpp"
 
-int main(int argc, char const* argv[])
-{
-	std::string input;
-	std::stringstream ss;
+using Clock = std::chrono::steady_clock;
 
-	// read input
-	if (argc != 2) // wrong usage
+static bool print_timings = false;
+
+// report how long a phase took (on stderr so that program output stays clean)
+static void ReportPhase(const char* phase, Clock::time_point start)
+{
+	if (print_timings)
 	{
-		std::cout << "Usage: provide a name of the file that is to be interpreted as an argument." << std::endl;
-		return 1;
+		std::chrono::duration<double, std::milli> elapsed = Clock::now() - start;
+		std::cerr << phase << ": " << elapsed.count() << " ms" << std::endl;
 	}
-	else // read file
+}
+
+int main(int argc, char const* argv[])
+{
+	auto launch = Clock::now();
+	std::string file_name;
+	std::string cache_dir;
+	unsigned jobs = 1;
+	size_t inline_budget = 40; // nodes of a body
+	bool watch = false;
+	bool print_stats = false;
+	Switches switches; // before any directive of the source
+
+	// read arguments
+	for (int i = 1; i < argc; i++)
 	{
-		try
+		std::string arg = argv[i];
+		if (arg == "--timings")
 		{
-			std::ifstream file(argv[1]);
-
-			if (file.fail()) {
-				throw std::exception();
+			print_timings = true;
+		}
+		else if (arg.rfind("--jobs=", 0) == 0 && arg.size() > 7 && arg.size() <= 10 && arg.find_first_not_of("0123456789", 7) == std::string::npos) // up to 3 digits
+		{
+			jobs = std::stoul(arg.substr(7));
+			unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+			if (jobs == 0 || jobs > cores) // threads beyond the cores only add splitting and stitching -> one core runs serially
+			{
+				jobs = cores;
 			}
-
-			std::string line;
-			while (std::getline(file, line)) {
-				ss << line << '\n';
+		}
+		else if (arg.rfind("--inline-budget=", 0) == 0 && arg.size() > 16 && arg.size() <= 20 && arg.find_first_not_of("0123456789", 16) == std::string::npos) // up to 4 digits
+		{
+			inline_budget = std::stoul(arg.substr(16));
+		}
+		else if (arg == "--stats")
+		{
+			print_stats = true;
+		}
+		else if (arg.rfind("--switches=", 0) == 0)
+		{
+			if (!Directives::Parse(std::string_view(arg).substr(11), switches)) // wrong switches -> usage
+			{
+				file_name.clear();
+				break;
 			}
 		}
-		catch (const std::exception&)
+		else if (arg == "--watch")
+		{
+			watch = true;
+		}
+		else if (arg.rfind("--cache-dir=", 0) == 0 && arg.size() > 12)
+		{
+			cache_dir = arg.substr(12);
+		}
+		else if (file_name.empty() && (arg == "-" || arg.rfind("--", 0) != 0))
+		{
+			file_name = arg;
+		}
+		else // unknown option or second file
 		{
-			std::cerr << "Error: file error." << std::endl;
-			return 1;
+			file_name.clear();
+			break;
 		}
 	}
 
-	input = ss.str();
+	if (file_name.empty() || (watch && file_name == "-")) // wrong usage
+	{
+		std::cout << "Usage: provide a name of the file that is to be interpreted as an argument ('-' reads standard input)." << std::endl;
+		std::cout << "Options: --timings           print duration of each phase to stderr" << std::endl;
+		std::cout << "         --stats             print lexer kernels in use, runtime checks the optimizations removed and memo hits of pure functions to stderr" << std::endl;
+		std::cout << "         --jobs=N            lex and parse on N threads (0 or more than there are = all hardware threads)" << std::endl;
+		std::cout << "         --cache-dir=DIR     keep parsed programs in DIR, reused while the source stays the same" << std::endl;
+		std::cout << "         --inline-budget=N   copy bodies of routines up to N nodes into their callers (0 = none, default 40)" << std::endl;
+		std::cout << "         --switches=B-,S-,R- start with these compiler switches, as if {$B-,S-,R-} opened the source (all + by default)" << std::endl;
+		std::cout << "         --watch             run again whenever the file changes, parsing only edited declarations" << std::endl;
+		return 1;
+	}
+
+	if (watch)
+	{
+		WatchSession(file_name, print_timings, switches).Run();
+	}
+
+	// read file -> mmapped or read at once, lexer works directly on this buffer
+	std::unique_ptr<SourceFile> source;
+	auto start = Clock::now();
+	try
+	{
+		source = std::make_unique<SourceFile>(file_name);
+		if (source->Text().size() > LineTable::max_source_size) // locations in the tree are 32-bit
+		{
+			throw std::length_error("source too large");
+		}
+	}
+	catch (const std::exception&)
+	{
+		std::cerr << "Error: file error." << std::endl;
+		return 1;
+	}
+	ReportPhase("load", start);
 
 	// interpreting
 	try
 	{
-		Lexer lex(input);
-		
-		std::vector<Token> tokens = lex.GetTokens();
+		// lexer runs on demand of the parser -> both phases are timed together,
+		// parallel lexer does its work up front and top level declarations get parsed on threads too
+		SymbolTable symbols; // identifiers of the whole program
+		Arena nodes; // whole syntax tree lives in here, freed at once at the end
+		Stmt* program = nullptr;
+
+		// image of the same source from an earlier run -> no lexing and parsing (warm start)
+		std::unique_ptr<ProgramCache> cache;
+		if (!cache_dir.empty())
+		{
+			start = Clock::now();
+			cache = std::make_unique<ProgramCache>(cache_dir, source->Text());
+			program = cache->Load(nodes, symbols);
+			ReportPhase(program != nullptr ? "cache hit" : "cache miss", start);
+		}
+
+		if (program == nullptr)
+		{
+			start = Clock::now();
+			if (jobs > 1)
+			{
+				ParallelLexer lex(source->Text(), symbols, jobs);
+				ParallelParser par(lex, jobs);
+				program = par.Parse(nodes);
+			}
+			else
+			{
+				Lexer lex(source->Text(), symbols);
+				Parser par(lex, nodes);
+				program = par.Parse();
+			}
+			ReportPhase("lex+parse", start);
+			if (print_stats)
+			{
+				std::cerr << "lexer kernels: " << CharScan::Implementation() << std::endl;
+			}
 
-		Parser par(tokens);
+			if (cache != nullptr)
+			{
+				start = Clock::now();
+				cache->Store(program, symbols);
+				ReportPhase("cache store", start);
+			}
+		}
+
+		// names get bound to their declarations for every run -> images keep only what the parser produced
+		start = Clock::now();
+		Resolver resolver(nodes);
+		resolver.Resolve(program);
+		TailCallFinder tail_calls; // on the tree as written -> the same calls as in watch mode, later passes only drop code after them
+		tail_calls.Find(program);
+		ReportPhase("resolve", start);
+
+		// switches come from the text -> the same for a warm start, nodes of the default regions are already as they should be
+		Directives directives(switches);
+		Lexer::ScanDirectives(source->Text(), directives);
+		if (!directives.Default())
+		{
+			directives.Apply(program);
+		}
+
+		start = Clock::now();
+		DeadCodeEliminator eliminator(nodes);
+		eliminator.Eliminate(program); // before anything else spends time on routines nothing calls
+		Inliner inliner(nodes, inline_budget);
+		inliner.Inline(program);
+		ConstantFolder folder(nodes);
+		folder.Fold(program);
+		eliminator.Eliminate(program); // routines inlined everywhere, variables whose reads got folded
+		RangeAnalyzer analyzer; // before hoisting -> expressions still sit under the conditions guarding them
+		analyzer.Analyze(program);
+		LoopHoister hoister(nodes);
+		hoister.Hoist(program);
+		LoopReducer reducer(nodes);
+		reducer.Reduce(program);
+		PurityAnalyzer purity;
+		purity.Analyze(program);
+		ReportPhase("optimize", start);
+		if (print_stats)
+		{
+			std::cerr << "division checks removed: " << analyzer.divisions.removed << " of " << analyzer.divisions.total << std::endl;
+			std::cerr << "overflow-free +, -, *: " << analyzer.overflows.removed << " of " << analyzer.overflows.total << std::endl;
+		}
+		ReportPhase("startup", launch);
+
+		start = Clock::now();
 		Interpreter interpreter;
 
-		interpreter.Interpret(par.Parse());
+		interpreter.Interpret(program);
+		ReportPhase("run", start);
+		if (print_stats)
+		{
+			for (auto&& [routine, name] : purity.pure_functions)
+			{
+				Interpreter::MemoCounters counters = interpreter.Counters(routine);
+				std::cerr << "memo " << symbols.Name(name) << ": " << counters.hits << " hits, " << counters.misses << " misses"
+					<< (counters.off ? ", turned off" : "") << std::endl;
+			}
+		}
 	}
-	catch (const Error& e)
+	catch (Error& e)
 	{
+		if (!e.HasLine()) // error from the tree -> lines of the source get counted only now
+		{
+			e.ResolveLine(LineTable(source->Text()));
+		}
 		std::cout << e.what() << std::endl;
 		return 1;
 	}
-	
+
 	return 0;
-}
\ No newline at end of file
+}
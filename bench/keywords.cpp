@@ -0,0 +1,115 @@
+// lookup of reserved keywords -> perfect hash of Keywords against the unordered_map the lexer used before it
+// build and run: make bench
+
+#include <cctype>
+#include <chrono>
+#include <cstddef>
+#include <iostream>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "../MicroPascal/Keywords.hpp"
+
+using Clock = std::chrono::steady_clock;
+
+// copy of the old lookup -> lowercase copy on the stack, then the map
+class OldKeywords
+{
+public:
+	TokenType Lookup(std::string_view lexeme) const
+	{
+		constexpr size_t max_keyword_length = 9; // "procedure"
+		if (lexeme.size() > max_keyword_length)
+		{
+			return TokenType::ID;
+		}
+		char lowered[max_keyword_length];
+		for (size_t i = 0; i < lexeme.size(); i++)
+		{
+			lowered[i] = static_cast<char>(std::tolower(static_cast<unsigned char>(lexeme[i])));
+		}
+		auto keyword = reserved_keywords.find(std::string_view(lowered, lexeme.size()));
+		return keyword != reserved_keywords.end() ? keyword->second : TokenType::ID;
+	}
+
+private:
+	const std::unordered_map<std::string_view, TokenType> reserved_keywords =
+	{
+		{"program", TokenType::PROGRAM},
+		{"begin", TokenType::BEGIN},
+		{"end", TokenType::END},
+		{"var", TokenType::VAR},
+		{"true", TokenType::TRUE},
+		{"false", TokenType::FALSE},
+		{"and", TokenType::AND},
+		{"or", TokenType::OR},
+		{"not", TokenType::NOT},
+		{"for", TokenType::FOR},
+		{"to", TokenType::TO},
+		{"downto", TokenType::DOWNTO},
+		{"do", TokenType::DO},
+		{"while", TokenType::WHILE},
+		{"if", TokenType::IF},
+		{"then", TokenType::THEN},
+		{"else", TokenType::ELSE},
+		{"procedure", TokenType::PROCEDURE},
+		{"function", TokenType::FUNCTION},
+		{"writeln", TokenType::WRITELN},
+		{"string", TokenType::STRING_TYPE},
+		{"integer", TokenType::INTEGER_TYPE},
+		{"boolean", TokenType::BOOL_TYPE},
+		{"div", TokenType::DIV}
+	};
+};
+
+// runs lookup over all words rounds times -> ns per lookup, sum of token types keeps the work from being optimized away
+template <typename Lookup>
+static double Measure(const std::vector<std::string_view>& words, size_t rounds, Lookup lookup, size_t& checksum)
+{
+	auto start = Clock::now();
+	for (size_t round = 0; round < rounds; round++)
+	{
+		for (auto&& word : words)
+		{
+			checksum += static_cast<size_t>(lookup(word));
+		}
+	}
+	std::chrono::duration<double, std::nano> elapsed = Clock::now() - start;
+	return elapsed.count() / static_cast<double>(words.size() * rounds);
+}
+
+int main()
+{
+	// keywords and identifiers of a typical program, mixed case as the lexer sees them
+	const std::vector<std::string_view> words =
+	{
+		"begin", "End", "i", "sum", "for", "TO", "do", "if", "then", "else", "writeln", "counter",
+		"procedure", "Function", "result", "x1", "while", "not", "and", "or", "div", "Integer", "string",
+		"boolean", "var", "true", "FALSE", "downto", "program", "value", "n", "total_count", "fib",
+		"index", "temporary", "k", "BEGIN", "end", "a_rather_long_identifier", "tmp"
+	};
+	const size_t rounds = 1000000 / words.size();
+
+	OldKeywords old_keywords;
+	size_t old_checksum = 0;
+	size_t new_checksum = 0;
+	for (int pass = 0; pass < 2; pass++) // first one warms up
+	{
+		old_checksum = new_checksum = 0;
+		double old_ns = Measure(words, rounds, [&](std::string_view word) { return old_keywords.Lookup(word); }, old_checksum);
+		double new_ns = Measure(words, rounds, [](std::string_view word) { return Keywords::Lookup(word); }, new_checksum);
+		if (pass == 1)
+		{
+			std::cout << "unordered_map: " << old_ns << " ns/lookup" << std::endl;
+			std::cout << "perfect hash:  " << new_ns << " ns/lookup" << std::endl;
+		}
+	}
+
+	if (old_checksum != new_checksum)
+	{
+		std::cout << "Error: lookups disagree." << std::endl;
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,74 @@
+{ Benchmark of nested loops whose bodies repeat work that does not change between iterations }
+program nested_loops;
+
+var
+    i, j, k, n, width, height, scale, sum, calls : integer;
+    name : string;
+
+{ sizes are set by a call -> nothing to fold for the loops below }
+procedure setup;
+begin
+    n := 500;
+    width := 40;
+    height := 25;
+    scale := 7;
+    name := 'loop'
+end;
+
+procedure count;
+begin
+    calls := calls + 1
+end;
+
+function weighted(limit : integer) : integer;
+var
+    x, y, w : integer;
+
+    procedure widen;
+    begin
+        w := w + 1
+    end;
+
+begin
+    weighted := 0;
+    w := 3;
+    for x := 1 to limit do
+    begin
+        { w changes through widen, x * w must be evaluated again every time }
+        for y := 1 to limit do
+            weighted := weighted + (x * w) div 2 + (limit * limit - 1) div 4;
+        widen
+    end
+end;
+
+begin
+    setup;
+    sum := 0;
+    calls := 0;
+
+    for i := 1 to n do
+        for j := 1 to n do
+        begin
+            { width * height * scale and name + '!' do not depend on i, j, k }
+            k := 0;
+            while k < (width + height) div 8 do
+            begin
+                sum := sum + width * height * scale div 1000 + k - i div 50;
+                k := k + 1
+            end;
+            if name + '!' = 'loop!' then
+                sum := sum - 1
+        end;
+    writeln('sum = ', sum);
+
+    { calls is written through count -> calls div 1000 stays inside the loop }
+    sum := 0;
+    for i := 1 to n * n do
+    begin
+        count;
+        sum := sum + calls div 1000 + scale * scale
+    end;
+    writeln('sum = ', sum, ', calls = ', calls);
+
+    writeln('weighted = ', weighted(200))
+end.
@@ -0,0 +1,34 @@
+{ integers are 32 bits wide, sums that do not fit wrap around }
+program accumulation;
+var
+    i, n, total, product : integer;
+
+begin
+    n := 100000;
+    total := 0;
+    for i := 1 to n do
+        total := total + i;
+    writeln('sum of 1..', n, ' = ', total);
+
+    total := 7;
+    for i := 1 to n do
+        total := total + 3 * i + 5;
+    writeln('total = ', total);
+
+    total := 0;
+    for i := n downto 1 do
+        total := total - i * 1000;
+    writeln('total = ', total);
+
+    total := 0;
+    for i := 10 to 1 do
+        total := total + i;
+    writeln('empty range, total = ', total);
+
+    product := 0;
+    for i := 1 to 5 do
+    begin
+        product := i * 65536 * 65536 + i * 7;
+        writeln(i, ': ', product)
+    end
+end.
@@ -0,0 +1,25 @@
+{ div by a value checked to be non-zero works, division by zero stops the program }
+program division;
+var
+    i, n, d : integer;
+
+begin
+    n := 100;
+    for i := 1 to 4 do
+        writeln(n, ' div ', i, ' = ', n div i);
+
+    d := 0;
+    if d <> 0 then
+        writeln(n div d)
+    else
+        writeln('not dividing by zero');
+
+    d := 3;
+    while d > 0 do
+    begin
+        writeln(n, ' div ', d, ' = ', n div d);
+        d := d - 1
+    end;
+
+    writeln(n div d)
+end.
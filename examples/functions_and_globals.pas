@@ -0,0 +1,24 @@
+{ a function reading a global variable sees its changes, calls with the same arguments can give different results }
+program functions_and_globals;
+var
+    i, offset : integer;
+
+function shifted(n : integer): integer;
+begin
+    shifted := n + offset
+end;
+
+function square(n : integer): integer;
+begin
+    square := n * n
+end;
+
+begin
+    for i := 1 to 3 do
+    begin
+        offset := i * 10;
+        writeln('shifted(1) = ', shifted(1), ', square(4) = ', square(4))
+    end;
+    offset := 0;
+    writeln('shifted(1) = ', shifted(1))
+end.
@@ -0,0 +1,40 @@
+{ routines see the current value of the variables they use, also after it changes between their calls }
+program global_variables;
+var
+    x, limit : integer;
+
+procedure show;
+begin
+    writeln('x = ', x)
+end;
+
+procedure accumulate;
+var
+    step, total : integer;
+
+    procedure add;
+    begin
+        total := total + step
+    end;
+
+begin
+    total := 0;
+    step := 1;
+    add;
+    step := 10;
+    add;
+    writeln('total = ', total)
+end;
+
+begin
+    x := 1;
+    show;
+    x := 2;
+    show;
+    accumulate;
+    limit := 5;
+    if limit > 3 then
+        writeln('limit is above 3')
+    else
+        writeln('limit is at most 3')
+end.
@@ -0,0 +1,24 @@
+{ procedures without parameters, one of them with a local variable of its own }
+program inlined;
+var
+   a: integer;
+
+procedure hello;
+begin
+   writeln('hello')
+end;
+
+procedure copy;
+var
+   b: integer;
+begin
+   b := a
+end;
+
+begin
+   a := 1;
+   hello;
+   copy;
+   hello;
+   writeln('a = ', a)
+end.
@@ -0,0 +1,37 @@
+{ loop bodies run once per iteration, only when they run at all }
+program loops;
+var
+    i, k, zero, total : integer;
+
+function tick(n : integer): integer;
+begin
+    writeln('tick');
+    tick := n
+end;
+
+begin
+    k := 2;
+    zero := 0;
+    total := 0;
+    for i := 1 to 3 do
+        total := total + tick(7) * k;
+    writeln('total = ', total);
+
+    for i := 1 to 0 do
+        total := k div zero;
+    i := 5;
+    while i < 5 do
+        total := k div zero;
+    for i := 1 to 3 do
+        if zero <> 0 then
+            total := k div zero;
+    writeln('no division by zero, total = ', total);
+
+    i := 0;
+    while i < 3 do
+    begin
+        total := k * k + i;
+        i := i + 1
+    end;
+    writeln('total = ', total)
+end.
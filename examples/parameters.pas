@@ -0,0 +1,35 @@
+{ parameters are copies of the arguments, every argument gets evaluated once, from left to right }
+program parameters;
+var
+    a, b : integer;
+
+function twice(n : integer): integer;
+begin
+    n := n * 2;
+    twice := n
+end;
+
+function noisy(n : integer): integer;
+begin
+    writeln('evaluating ', n);
+    noisy := n
+end;
+
+procedure swap_print(first, second : integer);
+var
+    temp : integer;
+begin
+    temp := first;
+    first := second;
+    second := temp;
+    writeln(first, ' ', second)
+end;
+
+begin
+    a := 5;
+    b := twice(a);
+    writeln('a = ', a, ', b = ', b);
+    writeln(twice(noisy(3)) + twice(noisy(4)));
+    swap_print(noisy(1), noisy(2));
+    writeln('a = ', a)
+end.
@@ -0,0 +1,32 @@
+{ recursion as the last statement reuses the frame -> goes far deeper than the stack limit of other recursion }
+program tail_call;
+
+function sum(n, acc : integer): integer;
+begin
+    if n = 0 then
+        sum := acc
+    else
+        sum := sum(n - 1, acc + n)
+end;
+
+{ calls itself but ignores the result -> runs nested, keeping the result it assigned before }
+function first(n : integer): integer;
+begin
+    first := n;
+    if n > 0 then
+        first(n - 1)
+end;
+
+procedure countdown(n : integer);
+begin
+    if n > 0 then
+        countdown(n - 1)
+    else
+        writeln('countdown finished')
+end;
+
+begin
+    writeln('sum of 1..10000 = ', sum(10000, 0));
+    countdown(10000);
+    writeln('first(3) = ', first(3))
+end.